@@ -8,11 +8,14 @@
 #include "Framebuffer.hpp"
 #include "Input.hpp"
 #include "Material.hpp"
+#include "MemoryWidget.hpp"
+#include "PipelineCompiler.hpp"
 #include "UI.hpp"
 
 #include <algorithm>
 #include <array>
 #include <cmath>
+#include <future>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -57,6 +60,7 @@ ClientApp::ClientApp(const ApplicationProperties &props)
   pc.center_value = center;
   widgets.emplace_back(make_scope<FilesystemWidget>(
       *get_device(), std::filesystem::current_path()));
+  widgets.emplace_back(make_scope<MemoryWidget>());
   scene_renderer.set_extent(get_swapchain()->get_extent());
 };
 
@@ -170,24 +174,37 @@ auto ClientApp::on_update(floating ts) -> void {
   }
 
   update_entities(ts);
+  // Each submission records into its own per-frame slots, so beginning one
+  // only waits on the submission made frame_count frames ago
+  GpuFuture graphics_future;
   {
     graphics_command_buffer->begin(frame());
     graphics(ts);
-    graphics_command_buffer->end_and_submit();
+    graphics_future = scheduler->submit(*graphics_command_buffer);
   }
-  compute(ts);
+  // Runs on the compute queue, overlapping the scene passes below until
+  // they sample its output
+  const auto compute_future = compute(ts);
 
   {
-    graphics_command_buffer->begin(frame());
+    scene_command_buffer->begin(frame());
+    scheduler->acquire_pending(*scene_command_buffer);
     scene_drawing(ts);
-    graphics_command_buffer->end_and_submit();
+    const std::array previous{
+        SubmitWait{.future = graphics_future},
+        SubmitWait{
+            .future = compute_future,
+            .stage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+        },
+    };
+    scene_future = scheduler->submit(*scene_command_buffer, previous);
   }
   scene_renderer.end_frame();
   timer.end();
 }
 
 auto ClientApp::scene_drawing(floating ts) -> void {
-  scene_renderer.flush(*graphics_command_buffer, frame());
+  scene_renderer.flush(*scene_command_buffer, frame());
 }
 
 void ClientApp::on_create() {
@@ -205,6 +222,8 @@ void ClientApp::on_destroy() {
   }
   // Destroy all fields
   command_buffer.reset();
+  graphics_command_buffer.reset();
+  scene_command_buffer.reset();
 
   pipeline.reset();
   shader.reset();
@@ -231,10 +250,22 @@ auto ClientApp::graphics(floating ts) -> void {
                                                 });
   scene_renderer.end_renderpass(*graphics_command_buffer);
 #endif
+
+  // The Laplace passes sample the loaded texture on the compute queue
+  if (!compute_input_released) {
+    scheduler->release(*graphics_command_buffer, Queue::Type::Compute,
+                       {
+                           .image = &texture->get_image(),
+                           .source_access = VK_ACCESS_TRANSFER_WRITE_BIT,
+                           .source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+                           .destination_stage =
+                               VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       });
+    compute_input_released = true;
+  }
 }
 
-auto ClientApp::compute(floating ts) -> void {
-#if 0
+auto ClientApp::compute(floating ts) -> GpuFuture {
   randomize_span_of_matrices(matrices);
   const auto &input_buffer =
       storage_buffer_set.get(DescriptorBinding(0), frame(), DescriptorSet(0));
@@ -245,54 +276,57 @@ auto ClientApp::compute(floating ts) -> void {
   other_input_buffer->write(matrices.data(),
                             matrices.size() * sizeof(Math::Mat4));
 
-  static long double angle = 0.0;
-  angle += ts * 0.1;
+  static floating angle = 0.0F;
+  angle += ts * 0.1F;
 
-  // Map angle to 0 to 2pi
-  const auto angle_in_radians = std::sin(angle);
+  const auto sine_of_angle = std::sin(angle);
   const auto &simple_uniform =
       uniform_buffer_set.get(DescriptorBinding(3), frame(), DescriptorSet(0));
-  simple_uniform->write(&angle_in_radians, simple_uniform->get_size());
+  simple_uniform->write(&sine_of_angle, sizeof(sine_of_angle));
 
   material->set("pc.kernelSize", pc.kernel_size);
   material->set("pc.halfSize", pc.half_size);
   material->set("pc.precomputedCenterValue", pc.center_value);
-  material->set("input_image", *framebuffer->get_image(0));
+  material->set("input_image", *texture);
   material->set("output_image", *output_texture);
   scene_renderer.update_material_for_rendering(
       FrameIndex{frame()}, *material, &uniform_buffer_set, &storage_buffer_set);
 
-  // Begin command buffer
   command_buffer->begin(frame());
-  // Bind pipeline
+  scheduler->acquire_pending(*command_buffer);
+  dispatcher->set_command_buffer(command_buffer.get());
   DebugMarker::begin_region(command_buffer->get_command_buffer(),
-                            "MatrixMultiply",
+                            "LaplaceEdgeDetection",
                             {
                                 1.0F,
                                 0.0F,
                                 0.0F,
                             });
-  pipeline->bind(*command_buffer);
+  dispatcher->bind(*pipeline);
   material->bind(*command_buffer, *pipeline, frame());
 
-  constexpr auto wg_size = 16UL;
-
-  // Number of groups in each dimension
-  constexpr auto dispatchX = 1024 / wg_size;
-  constexpr auto dispatchY = 1024 / wg_size;
+  constexpr auto wg_size = 16U;
+  const auto &extent = texture->get_extent();
+  const auto dispatch_x = (extent.width + wg_size - 1) / wg_size;
+  const auto dispatch_y = (extent.height + wg_size - 1) / wg_size;
   dispatcher->push_constant(*pipeline, *material);
   dispatcher->dispatch({
-      .group_count_x = dispatchX,
-      .group_count_y = dispatchY,
+      .group_count_x = dispatch_x,
+      .group_count_y = dispatch_y,
       .group_count_z = 1,
   });
-  // End command buffer
   DebugMarker::end_region(command_buffer->get_command_buffer());
-  command_buffer->end_and_submit();
 
-  command_buffer->begin(frame());
-  dispatcher->set_command_buffer(command_buffer.get());
-  dispatcher->bind(*second_pipeline);
+  // The second pass reads what the first wrote
+  VkMemoryBarrier barrier{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+  };
+  vkCmdPipelineBarrier(command_buffer->get_command_buffer(),
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0,
+                       nullptr, 0, nullptr);
 
   second_material->set("pc.kernelSize", pc.kernel_size);
   second_material->set("pc.halfSize", pc.half_size);
@@ -303,17 +337,31 @@ auto ClientApp::compute(floating ts) -> void {
       FrameIndex{frame()}, *second_material, &uniform_buffer_set,
       &storage_buffer_set);
 
+  dispatcher->bind(*second_pipeline);
   second_material->bind(*command_buffer, *second_pipeline, frame());
-
   dispatcher->push_constant(*second_pipeline, *second_material);
   dispatcher->dispatch({
-      .group_count_x = dispatchX,
-      .group_count_y = dispatchY,
+      .group_count_x = dispatch_x,
+      .group_count_y = dispatch_y,
       .group_count_z = 1,
   });
 
-  command_buffer->end_and_submit();
-#endif
+  // The scene pass acquires both results before sampling them
+  for (const auto *output :
+       {output_texture.get(), output_texture_second.get()}) {
+    scheduler->release(*command_buffer, Queue::Type::Graphics,
+                       {
+                           .image = &output->get_image(),
+                       });
+  }
+
+  // The outputs are overwritten in full, so only the previous scene
+  // submission reading them has to finish first
+  const std::array previous{SubmitWait{
+      .future = scene_future,
+      .stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+  }};
+  return scheduler->submit(*command_buffer, previous);
 }
 
 void ClientApp::perform() {
@@ -345,6 +393,11 @@ void ClientApp::perform() {
                          .queue_type = Queue::Type::Graphics,
                          .record_stats = true,
                      });
+  scene_command_buffer = CommandBuffer::construct(
+      *get_device(), CommandBufferProperties{
+                         .queue_type = Queue::Type::Graphics,
+                         .record_stats = true,
+                     });
   randomize_span_of_matrices(matrices);
 
   static constexpr auto matrices_size =
@@ -361,23 +414,30 @@ void ClientApp::perform() {
       0.0F,  1.0F,  0.0F, // top
   };
   constexpr std::array index_data{0U, 1U, 2U};
-  vertex_buffer = Buffer::construct(
-      *get_device(), sizeof(float) * vertex_data.size(), Buffer::Type::Vertex);
+  vertex_buffer =
+      Buffer::construct(*get_device(), sizeof(float) * vertex_data.size(),
+                        Buffer::Type::Vertex, "Triangle Vertices");
   vertex_buffer->write(vertex_data.data(), sizeof(float) * vertex_data.size());
-  index_buffer = Buffer::construct(
-      *get_device(), index_data.size() * sizeof(u32), Buffer::Type::Index);
+  index_buffer =
+      Buffer::construct(*get_device(), index_data.size() * sizeof(u32),
+                        Buffer::Type::Index, "Triangle Indices");
   index_buffer->write(index_data.data(), index_data.size() * sizeof(u32));
 
+  // Compiled on the JobSystem while the renderer and meshes load below
+  std::future<Scope<Pipeline>> pending_pipeline;
+  std::future<Scope<Pipeline>> pending_second_pipeline;
+  std::future<Scope<GraphicsPipeline>> pending_graphics_pipeline;
   {
     shader = Shader::construct(*get_device(),
                                FS::shader("LaplaceEdgeDetection.comp.spv"));
 
     material = Material::construct(*get_device(), *shader);
-    pipeline = Pipeline::construct(*get_device(), PipelineConfiguration{
-                                                      "LaplaceEdgeDetection",
-                                                      PipelineStage::Compute,
-                                                      *shader,
-                                                  });
+    pending_pipeline = PipelineCompiler::compile(
+        *get_device(), PipelineConfiguration{
+                           "LaplaceEdgeDetection",
+                           PipelineStage::Compute,
+                           *shader,
+                       });
     auto &&[kernel_size, half_size, center_value] = compute_kernel_size<3>();
     material->set("pc.kernelSize", kernel_size);
     material->set("pc.halfSize", half_size);
@@ -388,12 +448,12 @@ void ClientApp::perform() {
         *get_device(), FS::shader("LaplaceEdgeDetection_Second.comp.spv"));
 
     second_material = Material::construct(*get_device(), *second_shader);
-    second_pipeline =
-        Pipeline::construct(*get_device(), PipelineConfiguration{
-                                               "LaplaceEdgeDetection_Second",
-                                               PipelineStage::Compute,
-                                               *second_shader,
-                                           });
+    pending_second_pipeline = PipelineCompiler::compile(
+        *get_device(), PipelineConfiguration{
+                           "LaplaceEdgeDetection_Second",
+                           PipelineStage::Compute,
+                           *second_shader,
+                       });
     auto &&[kernel_size, half_size, center_value] = compute_kernel_size<127>();
     second_material->set("pc.kernelSize", kernel_size);
     second_material->set("pc.halfSize", half_size);
@@ -422,7 +482,7 @@ void ClientApp::perform() {
                           FS::shader("Triangle.frag.spv"));
 
     graphics_material = Material::construct(*get_device(), *graphics_shader);
-    graphics_pipeline = GraphicsPipeline::construct(
+    pending_graphics_pipeline = PipelineCompiler::compile(
         *get_device(), GraphicsPipelineConfiguration{
                            .name = "DefaultGraphicsPipeline",
                            .shader = graphics_shader.get(),
@@ -437,6 +497,7 @@ void ClientApp::perform() {
   }
 
   dispatcher = make_scope<CommandDispatcher>(command_buffer.get());
+  scheduler = QueueScheduler::construct(*get_device());
 
   scene_renderer.create(*get_device(), *get_swapchain());
 
@@ -445,6 +506,10 @@ void ClientApp::perform() {
   sponza_mesh =
       Mesh::import_from(*get_device(), FS::model("pistol/pistol.fbx"));
 
+  pipeline = pending_pipeline.get();
+  second_pipeline = pending_second_pipeline.get();
+  graphics_pipeline = pending_graphics_pipeline.get();
+
   scene = make_scope<ECS::Scene>("Default");
   auto entity = scene->create_entity("Test");
 }
@@ -573,6 +638,11 @@ void ClientApp::on_interface(InterfaceSystem &system) {
     ImGui::SliderFloat("Depth Far", &far, 0.1f, 100.0f);
     ImGui::SliderFloat("Depth Bias", &bias, 0.0f, 0.1F);
     ImGui::SliderFloat("Depth Factor", &depth_value, 0.01f, 1.0f);
+
+    bool gpu_driven = scene_renderer.is_gpu_driven();
+    if (ImGui::Checkbox("GPU Culling", &gpu_driven)) {
+      scene_renderer.set_gpu_driven(gpu_driven);
+    }
   });
 
   for (const auto &widget : widgets)
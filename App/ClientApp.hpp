@@ -20,6 +20,7 @@
 #include "Math.hpp"
 #include "Mesh.hpp"
 #include "Pipeline.hpp"
+#include "QueueScheduler.hpp"
 #include "SceneRenderer.hpp"
 #include "Shader.hpp"
 #include "Texture.hpp"
@@ -52,6 +53,7 @@ public:
 private:
   Scope<ECS::Scene> scene;
   Scope<CommandDispatcher> dispatcher;
+  Scope<QueueScheduler> scheduler;
   Scope<DynamicLibraryLoader> loader;
 
   glm::vec3 camera_position{-3, -5, 3};
@@ -67,7 +69,12 @@ private:
 
   Scope<CommandBuffer> command_buffer;
   Scope<CommandBuffer> graphics_command_buffer;
+  Scope<CommandBuffer> scene_command_buffer;
   Scope<Framebuffer> framebuffer;
+  // The Laplace passes overwrite their outputs once the previous scene
+  // submission, which acquired them, has finished
+  GpuFuture scene_future{};
+  bool compute_input_released{false};
 
   Scope<Material> material;
   Scope<Pipeline> pipeline;
@@ -104,7 +111,7 @@ private:
 
   auto update_entities(floating ts) -> void;
   auto scene_drawing(floating ts) -> void;
-  auto compute(floating ts) -> void;
+  auto compute(floating ts) -> GpuFuture;
   auto graphics(floating ts) -> void;
 
   void perform();
@@ -0,0 +1,35 @@
+#ifndef BINDLESS_VKGPU
+#define BINDLESS_VKGPU
+
+#extension GL_EXT_nonuniform_qualifier : require
+
+#include <RendererResources.glsl>
+
+// Same layout as ShaderResources.glsl, followed by indices into the global
+// texture array. Material::set writes them from the texture's slot.
+layout(push_constant) uniform PushConstants {
+  vec4 albedo_colour;
+  float emission;
+  float metalness;
+  float roughness;
+  float use_normal_map;
+  uint shadow_map;
+  uint albedo_map;
+  uint diffuse_map;
+  uint normal_map;
+  uint metallic_map;
+  uint roughness_map;
+  uint ao_map;
+  uint specular_map;
+}
+pc;
+
+// Owned by the device, see BindlessTextures.
+layout(set = 2, binding = 0) uniform sampler2D textures[];
+
+vec4 sample_texture(uint index, vec2 uvs)
+{
+  return texture(textures[nonuniformEXT(index)], uvs);
+}
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef RENDERER_VKGPU
+#define RENDERER_VKGPU
+
+layout(std140, set = 0, binding = 1) uniform ShadowData {
+  mat4 view;
+  mat4 projection;
+  mat4 view_projection;
+  vec2 bias_and_default;
+}
+shadow;
+
+layout(std140, set = 0, binding = 0) uniform RendererData {
+  mat4 view;
+  mat4 projection;
+  mat4 view_projection;
+  vec4 light_pos;
+  vec4 light_dir;
+  vec4 camera_pos;
+}
+renderer;
+
+// All instances of the frame, packed per draw. gl_InstanceIndex already
+// includes the draw's firstInstance, so it indexes straight into this array.
+layout(std140, set = 0, binding = 2) readonly buffer VertexTransforms {
+  mat4 matrices[];
+}
+transforms;
+
+#endif
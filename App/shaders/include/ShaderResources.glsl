@@ -1,28 +1,7 @@
 #ifndef BUFFER_VKGPU
 #define BUFFER_VKGPU
 
-layout(std140, set = 0, binding = 1) uniform ShadowData {
-  mat4 view;
-  mat4 projection;
-  mat4 view_projection;
-  vec2 bias_and_default;
-}
-shadow;
-
-layout(std140, set = 0, binding = 0) uniform RendererData {
-  mat4 view;
-  mat4 projection;
-  mat4 view_projection;
-  vec4 light_pos;
-  vec4 light_dir;
-  vec4 camera_pos;
-}
-renderer;
-
-layout(std140, set = 0, binding = 2) readonly buffer VertexTransforms {
-  mat4 matrices[];
-}
-transforms;
+#include <RendererResources.glsl>
 
 layout(push_constant) uniform PushConstants {
   vec4 albedo_colour;
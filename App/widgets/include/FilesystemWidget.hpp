@@ -12,7 +12,8 @@
 
 using namespace Core;
 
-using TextureCache = GenericCache<Texture, TextureProperties, false>;
+using TextureCache =
+    GenericCache<Texture, TextureProperties, true, TextureCacheConstructor>;
 
 class FilesystemWidget : public Widget {
 public:
@@ -42,7 +43,6 @@ private:
   Scope<Texture> directory_icon;
 
   TextureCache texture_cache;
-  std::jthread pop_one_from_texture_cache_thread;
   Container::StringLikeMap<std::vector<Core::FS::DirectoryEntry>>
       directory_cache;
 
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "MemoryTelemetry.hpp"
+#include "Widget.hpp"
+
+using namespace Core;
+
+class MemoryWidget : public Widget {
+public:
+  void on_update(floating ts) override;
+  void on_interface(InterfaceSystem &) override;
+  void on_create() override;
+  void on_destroy() override;
+
+private:
+  MemorySnapshot snapshot{};
+
+  void render_categories();
+  void render_heaps();
+  void render_resources();
+};
@@ -17,21 +17,12 @@ FilesystemWidget::FilesystemWidget(const Device &dev,
                                                ImageUsage::TransferDst,
                                   })) {
   history.push_back(current_path);
-
-  pop_one_from_texture_cache_thread = std::jthread{
-      [this](const auto &stop_token) {
-        while (!stop_token.stop_requested()) {
-          std::this_thread::sleep_for(std::chrono::milliseconds(160));
-          texture_cache.update_one();
-        }
-      },
-  };
 }
 
 void FilesystemWidget::on_create() { load_icons(); }
 
 void FilesystemWidget::on_update(Core::floating ts) {
-  // Handle any updates here, if necessary
+  texture_cache.begin_frame();
 }
 
 void FilesystemWidget::on_interface(Core::InterfaceSystem &interface_system) {
@@ -0,0 +1,82 @@
+#include "MemoryWidget.hpp"
+
+#include "DataBuffer.hpp"
+#include "UI.hpp"
+
+#include <fmt/format.h>
+#include <imgui.h>
+
+void MemoryWidget::on_create() {}
+
+void MemoryWidget::on_update(Core::floating) {
+  snapshot = MemoryTelemetry::snapshot();
+}
+
+void MemoryWidget::on_interface(Core::InterfaceSystem &) {
+  if (UI::begin("Memory")) {
+    UI::text("Frame {}: {} allocations, {} frees", snapshot.frame,
+             snapshot.allocations_last_frame, snapshot.frees_last_frame);
+    if (ImGui::Button("Dump JSON")) {
+      MemoryTelemetry::dump_json(
+          fmt::format("memory_telemetry_{}.json", snapshot.frame));
+    }
+
+    render_categories();
+    render_heaps();
+    render_resources();
+    UI::end();
+  }
+}
+
+void MemoryWidget::on_destroy() {}
+
+void MemoryWidget::render_categories() {
+  if (!ImGui::BeginTable("MemoryCategories", 4)) {
+    return;
+  }
+  ImGui::TableSetupColumn("Category");
+  ImGui::TableSetupColumn("Live");
+  ImGui::TableSetupColumn("Allocations");
+  ImGui::TableSetupColumn("Peak");
+  ImGui::TableHeadersRow();
+
+  for (usize index = 0; index < memory_category_count; ++index) {
+    const auto &usage = snapshot.categories.at(index);
+    ImGui::TableNextRow();
+    ImGui::TableSetColumnIndex(0);
+    UI::text("{}", to_string(static_cast<MemoryCategory>(index)));
+    ImGui::TableSetColumnIndex(1);
+    UI::text("{}", human_readable_size(usage.live_bytes));
+    ImGui::TableSetColumnIndex(2);
+    UI::text("{}", usage.live_allocations);
+    ImGui::TableSetColumnIndex(3);
+    UI::text("{}", human_readable_size(usage.peak_bytes));
+  }
+  ImGui::EndTable();
+}
+
+void MemoryWidget::render_heaps() {
+  for (const auto &heap : snapshot.heaps) {
+    const auto fraction =
+        heap.budget == 0 ? 0.0F
+                         : static_cast<floating>(heap.usage) /
+                               static_cast<floating>(heap.budget);
+    const auto label =
+        fmt::format("{} / {}", human_readable_size(heap.usage),
+                    human_readable_size(heap.budget));
+    UI::text("Heap {}{}", heap.heap_index,
+             heap.device_local ? " (device local)" : "");
+    ImGui::ProgressBar(fraction, ImVec2(-1.0F, 0.0F), label.c_str());
+  }
+}
+
+void MemoryWidget::render_resources() {
+  if (!ImGui::CollapsingHeader("Resources")) {
+    return;
+  }
+  for (const auto &usage : snapshot.resources) {
+    UI::text("{} ({}): {} in {}", usage.resource_name,
+             to_string(usage.category), human_readable_size(usage.live_bytes),
+             usage.live_allocations);
+  }
+}
@@ -3,6 +3,7 @@
 
 #include "Device.hpp"
 #include "Logger.hpp"
+#include "MemoryTelemetry.hpp"
 
 #include <vk_mem_alloc.h>
 
@@ -55,11 +56,14 @@ constexpr auto operator|=(Creation &left, Creation right) -> Creation & {
 struct AllocationProperties {
   Usage usage{Usage::AUTO};
   Creation creation{Creation::HOST_ACCESS_RANDOM_BIT};
+  // Allocates from a custom pool, whose memory type overrides `usage`
+  VmaPool pool{nullptr};
 };
 
 class Allocator {
 public:
-  explicit Allocator(const std::string &resource_name);
+  explicit Allocator(const std::string &resource_name,
+                     MemoryCategory category = MemoryCategory::Other);
 
   template <typename T = void *>
   auto map_memory(VmaAllocation allocation) -> T * {
@@ -98,6 +102,16 @@ public:
 
 private:
   std::string resource_name{};
+  MemoryCategory category{MemoryCategory::Other};
+
+  /**
+   * @brief Names `allocation` and attaches its telemetry tag as user data.
+   */
+  auto tag(VmaAllocation allocation) -> void;
+  /**
+   * @brief Counts the free against the tag and deletes it.
+   */
+  static auto untag(VmaAllocation allocation) -> void;
 
   static auto construct_allocator(const Device &device,
                                   const Instance &instance) -> VmaAllocator;
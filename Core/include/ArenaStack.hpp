@@ -0,0 +1,111 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <vector>
+
+namespace Core {
+
+/**
+ * @brief Stacks ranges down from the top of a fixed-size arena. Ranges can
+ * be released in any order, but their space only comes back once every
+ * range retained after them has been released as well. Transient ranges are
+ * bumped up from the bottom and freed all at once by reset_transient.
+ */
+class ArenaStack {
+public:
+  explicit ArenaStack(u64 arena_capacity = 0)
+      : capacity(arena_capacity), top(arena_capacity) {}
+
+  /**
+   * @return the offset of the range, or nullopt if the arena has no room
+   * left for it.
+   */
+  [[nodiscard]] auto retain(u64 size, u64 alignment) -> std::optional<u64> {
+    if (size == 0 || size > top) {
+      return std::nullopt;
+    }
+
+    const auto offset = align_down(top - size, alignment);
+    if (offset < bottom) {
+      return std::nullopt;
+    }
+    top = offset;
+    ranges.push_back({.offset = offset});
+    return offset;
+  }
+
+  /**
+   * @brief Releases the range at `offset`, ignoring offsets that were not
+   * retained.
+   */
+  auto release(u64 offset) -> void {
+    const auto found = std::ranges::find(ranges, offset, &Range::offset);
+    if (found == ranges.end()) {
+      return;
+    }
+    found->released = true;
+
+    while (!ranges.empty() && ranges.back().released) {
+      ranges.pop_back();
+    }
+    top = ranges.empty() ? capacity : ranges.back().offset;
+  }
+
+  /**
+   * @return the offset of a transient range, or nullopt if it would reach
+   * into the retained ranges.
+   */
+  [[nodiscard]] auto allocate(u64 size, u64 alignment) -> std::optional<u64> {
+    const auto offset = align_up(bottom, alignment);
+    if (size == 0 || offset > top || size > top - offset) {
+      return std::nullopt;
+    }
+
+    bottom = offset + size;
+    return offset;
+  }
+
+  auto reset_transient() -> void { bottom = 0; }
+
+  [[nodiscard]] auto empty() const -> bool { return ranges.empty(); }
+  [[nodiscard]] auto get_capacity() const -> u64 { return capacity; }
+  /**
+   * @brief Bytes from the lowest live range to the top, including the
+   * ranges that were released out of order.
+   */
+  [[nodiscard]] auto get_used() const -> u64 { return capacity - top; }
+  [[nodiscard]] auto get_transient_used() const -> u64 { return bottom; }
+
+private:
+  struct Range {
+    u64 offset{0};
+    bool released{false};
+  };
+
+  u64 capacity{0};
+  // Lowest retained offset, capacity while nothing is retained
+  u64 top{0};
+  // End of the transient ranges, zero while there are none
+  u64 bottom{0};
+  // The most recently retained range, at the lowest offset, is last
+  std::vector<Range> ranges{};
+
+  static constexpr auto align_up(u64 value, u64 alignment) -> u64 {
+    if (alignment <= 1) {
+      return value;
+    }
+    return (value + alignment - 1) / alignment * alignment;
+  }
+
+  static constexpr auto align_down(u64 value, u64 alignment) -> u64 {
+    if (alignment <= 1) {
+      return value;
+    }
+    return value / alignment * alignment;
+  }
+};
+
+} // namespace Core
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Config.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "core/Forward.hpp"
+
+namespace Core {
+
+/**
+ * @brief One update-after-bind array of combined image samplers, shared by
+ * every shader on the device.
+ *
+ * Shaders opt in by declaring `textures[]` at set `descriptor_set`, binding
+ * `binding`, and address it with indices handed out by `index_of`. Slots are
+ * written once when an image view is first seen and released when the view
+ * is destroyed, so materials never allocate or update a set for textures.
+ * A view whose sampler or layout changes moves to a new slot. A released
+ * slot is only handed out again once every frame in flight that could still
+ * read it has completed.
+ */
+class BindlessTextures {
+public:
+  static constexpr u32 descriptor_set = 2;
+  static constexpr u32 binding = 0;
+
+  ~BindlessTextures();
+
+  /**
+   * @brief Slot of `image` in the global array, written on first use. A
+   * changed sampler or layout retires the old slot and returns a new one.
+   */
+  [[nodiscard]] auto index_of(const Image &image) -> u32;
+  /**
+   * @brief Frees the slot of a destroyed view. The slot is reused once its
+   * frame index comes around again in begin_frame.
+   */
+  auto release(VkImageView view) -> void;
+
+  /**
+   * @brief Makes the slots released while `frame` was last recorded
+   * available again. Called once per frame, after the fence of `frame` has
+   * been waited on.
+   */
+  auto begin_frame(u32 frame) -> void;
+
+  [[nodiscard]] auto get_layout() const -> VkDescriptorSetLayout {
+    return layout;
+  }
+  [[nodiscard]] auto get_descriptor_set() const -> VkDescriptorSet {
+    return descriptor_set_handle;
+  }
+  [[nodiscard]] auto get_capacity() const -> u32 { return capacity; }
+  [[nodiscard]] auto get_resident_count() const -> u32 {
+    return static_cast<u32>(slots.size());
+  }
+
+  static auto construct(const Device &) -> Scope<BindlessTextures>;
+
+private:
+  explicit BindlessTextures(const Device &);
+
+  struct Slot {
+    u32 index{0};
+    VkSampler sampler{nullptr};
+    VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+  };
+
+  const Device *device{nullptr};
+  u32 capacity{0};
+  VkDescriptorPool pool{nullptr};
+  VkDescriptorSetLayout layout{nullptr};
+  VkDescriptorSet descriptor_set_handle{nullptr};
+
+  std::unordered_map<VkImageView, Slot> slots{};
+  std::vector<u32> free_indices{};
+  std::array<std::vector<u32>, Config::frame_count> retired_indices{};
+  u32 current_frame{0};
+  u32 next_index{0};
+
+  auto acquire_index() -> u32;
+  auto write(u32 index, const VkDescriptorImageInfo &) const -> void;
+};
+
+} // namespace Core
@@ -6,19 +6,45 @@
 
 #include <cstring>
 #include <limits>
+#include <optional>
 #include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
 namespace Core {
 
 struct BufferDataImpl;
+struct FrameAllocation;
 
 class Buffer {
 public:
   enum class Type { Vertex, Index, Uniform, Storage, Invalid };
-
+  /**
+   * @brief Dynamic buffers stay persistently mapped and are written by the
+   * CPU directly. Static vertex and index buffers live in device-local
+   * memory and are filled through the staging uploader.
+   */
+  enum class Mode : u8 { Dynamic, Static };
+  /**
+   * @brief IndirectArguments buffers can also be read by indirect draws and
+   * dispatches.
+   */
+  enum class Role : u8 { Data, IndirectArguments };
+
+  /**
+   * @brief `name` labels the allocation in VMA, the memory telemetry and the
+   * debug utils. Without one, the buffer is named after its type.
+   */
   explicit Buffer(const Device &, u64 input_size, Type buffer_type,
+                  u32 binding, Mode buffer_mode = Mode::Dynamic,
+                  Role buffer_role = Role::Data, std::string_view name = {});
+  /**
+   * @brief A view of a range of a frame arena. Nothing is allocated, and
+   * the range is released back to the FrameAllocator on destruction.
+   */
+  explicit Buffer(const Device &, const FrameAllocation &, Type buffer_type,
                   u32 binding);
   ~Buffer();
   // Make non-copyable
@@ -38,14 +64,38 @@ public:
     }
   }
   [[nodiscard]] auto get_size() const noexcept -> u64 { return size; }
+  [[nodiscard]] auto get_mode() const noexcept -> Mode { return mode; }
   [[nodiscard]] auto get_binding() const noexcept -> u32 { return binding; }
   [[nodiscard]] auto get_buffer() const noexcept -> VkBuffer;
+  /**
+   * @brief Where the data starts in get_buffer(), non-zero for views of a
+   * frame arena.
+   */
+  [[nodiscard]] auto get_offset() const noexcept -> u64 {
+    return descriptor_info.offset;
+  }
 
   [[nodiscard]] auto get_descriptor_info() const noexcept
       -> const VkDescriptorBufferInfo & {
     return descriptor_info;
   }
 
+  [[nodiscard]] auto is_transient() const noexcept -> bool {
+    return transient;
+  }
+  /**
+   * @brief Where the range of this frame starts, bound as the dynamic offset
+   * of transient buffers. Zero for every other buffer.
+   */
+  [[nodiscard]] auto get_dynamic_offset() const noexcept -> u32 {
+    return dynamic_offset;
+  }
+  /**
+   * @brief Takes the range of this frame without writing it, for transient
+   * buffers only the GPU writes.
+   */
+  auto reserve() -> void;
+
   template <typename T> void write(std::span<T> data) {
     write(data.data(), data.size() * sizeof(T));
   }
@@ -76,21 +126,48 @@ public:
   }
 
   static auto construct(const Device &, u64 input_size, Type buffer_type,
-                        u32 binding) -> Scope<Buffer>;
-  static auto construct(const Device &, u64 input_size, Type buffer_type)
+                        u32 binding, Mode mode = Mode::Dynamic,
+                        Role role = Role::Data, std::string_view name = {})
+      -> Scope<Buffer>;
+  static auto construct(const Device &, u64 input_size, Type buffer_type,
+                        std::string_view name = {}) -> Scope<Buffer>;
+  static auto construct(const Device &, const FrameAllocation &,
+                        Type buffer_type, u32 binding) -> Scope<Buffer>;
+  /**
+   * @brief A buffer whose data only lives for one frame, in the arena of
+   * `frame`. The first write of every frame takes a new range from
+   * FrameAllocator::allocate_transient. The descriptor covers the arena from
+   * offset zero, so it never changes, and the range is bound with
+   * get_dynamic_offset().
+   */
+  static auto construct_transient(const Device &, u64 input_size,
+                                  Type buffer_type, u32 binding, u32 frame)
       -> Scope<Buffer>;
 
 private:
+  Buffer(const Device &, u64 input_size, Type buffer_type, u32 binding,
+         u32 frame);
+
   const Device *device;
   Scope<BufferDataImpl> buffer_data{};
   u64 size{};
   Type type{Type::Invalid};
+  Mode mode{Mode::Dynamic};
+  Role role{Role::Data};
   u32 binding{};
+  std::string debug_name{};
   VkDescriptorBufferInfo descriptor_info{};
+  // Set for views of a frame arena
+  std::optional<u32> arena_frame{};
+  bool transient{false};
+  u32 dynamic_offset{0};
+  // FrameAllocator frame counter of the current transient range
+  u64 reserved_in_frame{std::numeric_limits<u64>::max()};
 
   void initialise_vulkan_buffer();
   void initialise_descriptor_info();
 
+  void initialise_static_buffer();
   void initialise_vertex_buffer();
   void initialise_index_buffer();
   void initialise_uniform_buffer();
@@ -98,6 +175,12 @@ private:
 
   static constexpr u32 invalid_binding = ~u32();
 
+  /**
+   * @brief Device-local memory that cannot be mapped is written through the
+   * device staging uploader instead.
+   */
+  [[nodiscard]] auto is_host_visible() const -> bool;
+
   auto read_raw(size_t offset, size_t data_size) -> std::vector<char>;
 };
 
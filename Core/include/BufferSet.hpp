@@ -3,6 +3,7 @@
 #include "Buffer.hpp"
 #include "Config.hpp"
 #include "Device.hpp"
+#include "FrameAllocator.hpp"
 #include "Types.hpp"
 
 #include <ranges>
@@ -40,15 +41,61 @@ public:
     frame_count = frames;
   }
 
-  auto create(std::integral auto size, SetBinding layout) -> void {
+  /**
+   * @brief Each frame gets a range of its frame arena, or a buffer of its
+   * own if the arena is full. The arenas can always be indirect arguments,
+   * so `role` only matters for the fallback.
+   */
+  auto create(std::integral auto size, SetBinding layout,
+              Buffer::Role role = Buffer::Role::Data) -> void {
+    auto &frame_allocator = device->get_frame_allocator();
     for (auto frame = static_cast<FrameIndex>(0); frame < frame_count;
          ++frame) {
-      auto buffer = Buffer::construct(*device, static_cast<u64>(size), Type,
-                                      layout.binding);
+      const auto range =
+          frame < Config::frame_count
+              ? frame_allocator.retain(frame, static_cast<u64>(size), Type)
+              : FrameAllocation{};
+      auto buffer = range.valid()
+                        ? Buffer::construct(*device, range, Type,
+                                            layout.binding)
+                        : Buffer::construct(*device, static_cast<u64>(size),
+                                            Type, layout.binding,
+                                            Buffer::Mode::Dynamic, role,
+                                            fallback_name(layout, frame));
       set(std::move(buffer), frame, layout.set);
     }
   }
 
+  /**
+   * @brief Each frame gets a transient buffer in its frame arena, bound with
+   * a dynamic offset, for data written again every frame.
+   */
+  auto create_transient(std::integral auto size, SetBinding layout) -> void {
+    for (auto frame = static_cast<FrameIndex>(0); frame < frame_count;
+         ++frame) {
+      auto buffer = frame < Config::frame_count
+                        ? Buffer::construct_transient(
+                              *device, static_cast<u64>(size), Type,
+                              layout.binding, frame)
+                        : Buffer::construct(*device, static_cast<u64>(size),
+                                            Type, layout.binding,
+                                            Buffer::Mode::Dynamic,
+                                            Buffer::Role::Data,
+                                            fallback_name(layout, frame));
+      set(std::move(buffer), frame, layout.set);
+    }
+  }
+
+  [[nodiscard]] auto contains(DescriptorBinding binding, FrameIndex frame_index,
+                              DescriptorSet set = 0) const -> bool {
+    const auto frame = frame_set_binding_buffers.find(frame_index);
+    if (frame == frame_set_binding_buffers.end()) {
+      return false;
+    }
+    const auto buffers = frame->second.find(set);
+    return buffers != frame->second.end() && buffers->second.contains(binding);
+  }
+
   auto get(DescriptorBinding binding, FrameIndex frame_index,
            DescriptorSet set = 0) -> auto & {
     ensure(frame_set_binding_buffers.contains(frame_index),
@@ -74,6 +121,12 @@ public:
 private:
   const Device *device;
 
+  static auto fallback_name(SetBinding layout, FrameIndex frame)
+      -> std::string {
+    return fmt::format("{} Set {} Binding {} Frame {}", Type, layout.set,
+                       layout.binding, frame);
+  }
+
   u32 frame_count{0};
   using BindingBuffers = std::unordered_map<DescriptorBinding, Scope<Buffer>>;
   using SetBindingBuffers = std::unordered_map<DescriptorSet, BindingBuffers>;
@@ -3,9 +3,11 @@
 #include "Config.hpp"
 #include "Containers.hpp"
 #include "Device.hpp"
+#include "GpuFuture.hpp"
 #include "Types.hpp"
 
 #include <array>
+#include <span>
 #include <vulkan/vulkan.h>
 
 #include "core/Forward.hpp"
@@ -21,6 +23,11 @@ concept CommandBufferBindable =
       object.bind(command_buffer);
     };
 
+struct SubmitWait {
+  GpuFuture future{};
+  VkPipelineStageFlags stage{VK_PIPELINE_STAGE_ALL_COMMANDS_BIT};
+};
+
 struct CommandBufferProperties {
   Queue::Type queue_type{Queue::Type::Graphics};
   u32 count{Config::frame_count};
@@ -60,8 +67,19 @@ public:
   auto end() -> void;
   auto end_and_submit() -> void;
 
+  /**
+   * @brief Submits without waiting for the GPU. Timestamps for the frame are
+   * read back the next time it begins, or when the future is waited on by
+   * end_and_submit.
+   */
+  auto end_and_submit_async(std::span<const SubmitWait> waits = {})
+      -> GpuFuture;
+
   [[nodiscard]] virtual auto get_command_buffer() const -> VkCommandBuffer;
   [[nodiscard]] auto get_preferred_queue() const -> VkQueue;
+  [[nodiscard]] auto get_queue_type() const -> Queue::Type {
+    return properties.queue_type;
+  }
 
   [[nodiscard]] auto get_statistics() const -> std::tuple<floating> {
     return compute_times.peek();
@@ -74,20 +92,25 @@ public:
 
 private:
   auto submit() -> void;
+  auto submit_async(std::span<const SubmitWait> waits = {}) -> GpuFuture;
   const Device &device;
   CommandBufferProperties properties{};
   bool supports_device_query{false};
 
   struct FrameCommandBuffer {
     VkCommandBuffer command_buffer{};
-    VkFence fence{};
     VkSemaphore finished_semaphore{};
+    // Timeline value signalled by the last submission of this frame
+    u64 submitted_value{0};
+    bool has_pending_timestamps{false};
   };
   FrameCommandBuffer *active_frame{nullptr};
   VkQueryPool *active_pool{nullptr};
   std::vector<FrameCommandBuffer> command_buffers{};
 
   VkCommandPool command_pool{};
+  VkSemaphore timeline{};
+  u64 timeline_value{0};
 
   std::vector<VkQueryPool> query_pools{};
 
@@ -95,6 +118,8 @@ private:
 
   void create_query_objects();
   void destroy_query_objects();
+  auto wait_for(const FrameCommandBuffer &) const -> void;
+  auto collect_timestamps(FrameCommandBuffer &, VkQueryPool) -> void;
 };
 
 class SwapchainCommandBuffer : public CommandBuffer {
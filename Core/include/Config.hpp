@@ -18,16 +18,86 @@ static constexpr u32 frame_count = GPGPU_FRAME_COUNT;
 static constexpr u32 frame_count = 3;
 #endif
 
+// Zero sizes the JobSystem from std::thread::hardware_concurrency
 #ifdef GPGPU_THREAD_COUNT
 static constexpr u32 thread_count = GPGPU_THREAD_COUNT;
 #else
-static constexpr u32 thread_count = 4;
+static constexpr u32 thread_count = 0;
 #endif
 
+// Instance transforms per pass, the geometry and shadow passes have their own
 #ifdef GPGPU_TRANSFORM_BUFFER_SIZE
 static constexpr u32 transform_buffer_size = GPGPU_TRANSFORM_BUFFER_SIZE;
 #else
 static constexpr u32 transform_buffer_size = 1000;
 #endif
 
+#ifdef GPGPU_STAGING_BUFFER_SIZE
+static constexpr u64 staging_buffer_size = GPGPU_STAGING_BUFFER_SIZE;
+#else
+static constexpr u64 staging_buffer_size = 64ULL * 1024ULL * 1024ULL;
+#endif
+
+// Per frame in flight, shared by BufferSet ranges and transient allocations
+#ifdef GPGPU_FRAME_ARENA_SIZE
+static constexpr u64 frame_arena_size = GPGPU_FRAME_ARENA_SIZE;
+#else
+static constexpr u64 frame_arena_size = 4ULL * 1024ULL * 1024ULL;
+#endif
+
+#ifdef GPGPU_BINDLESS_TEXTURE_COUNT
+static constexpr u32 bindless_texture_count = GPGPU_BINDLESS_TEXTURE_COUNT;
+#else
+static constexpr u32 bindless_texture_count = 4096;
+#endif
+
+// Evicts least recently used GenericCache entries above this many bytes
+#ifdef GPGPU_CACHE_CAPACITY_BYTES
+static constexpr u64 cache_capacity_bytes = GPGPU_CACHE_CAPACITY_BYTES;
+#else
+static constexpr u64 cache_capacity_bytes = 256ULL * 1024ULL * 1024ULL;
+#endif
+
+#ifdef GPGPU_TEXTURE_STREAMING_BUDGET
+static constexpr u64 texture_streaming_budget = GPGPU_TEXTURE_STREAMING_BUDGET;
+#else
+static constexpr u64 texture_streaming_budget = 512ULL * 1024ULL * 1024ULL;
+#endif
+
+// Bytes the TextureStreamer may upload per frame, at least one step
+#ifdef GPGPU_TEXTURE_STREAMING_FRAME_UPLOAD
+static constexpr u64 texture_streaming_frame_upload =
+    GPGPU_TEXTURE_STREAMING_FRAME_UPLOAD;
+#else
+static constexpr u64 texture_streaming_frame_upload = 16ULL * 1024ULL * 1024ULL;
+#endif
+
+// Levels up to this size are uploaded as soon as a streamed texture decodes
+#ifdef GPGPU_TEXTURE_STREAMING_BASE_EXTENT
+static constexpr u32 texture_streaming_base_extent =
+    GPGPU_TEXTURE_STREAMING_BASE_EXTENT;
+#else
+static constexpr u32 texture_streaming_base_extent = 64;
+#endif
+
+#ifdef GPGPU_PIPELINE_CACHE_SAVE_INTERVAL
+static constexpr u32 pipeline_cache_save_interval =
+    GPGPU_PIPELINE_CACHE_SAVE_INTERVAL;
+#else
+static constexpr u32 pipeline_cache_save_interval = 30;
+#endif
+
+// Starts the SceneRenderer on GPU culling and indirect draws, if supported
+#ifdef GPGPU_GPU_DRIVEN_RENDERING
+static constexpr bool gpu_driven_rendering = GPGPU_GPU_DRIVEN_RENDERING;
+#else
+static constexpr bool gpu_driven_rendering = false;
+#endif
+
+#ifdef GPGPU_COMPRESS_MESH_TEXTURES
+static constexpr bool compress_mesh_textures = GPGPU_COMPRESS_MESH_TEXTURES;
+#else
+static constexpr bool compress_mesh_textures = true;
+#endif
+
 } // namespace Core::Config
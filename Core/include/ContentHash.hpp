@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <cstring>
+#include <functional>
+#include <span>
+
+namespace Core {
+
+/**
+ * @brief Fast non-cryptographic 64-bit hash of a byte range, consumed eight
+ * bytes at a time. Stable across runs, so it can key on-disk caches.
+ */
+[[nodiscard]] inline auto content_hash(std::span<const u8> bytes,
+                                       u64 seed = 0xcbf29ce484222325ULL)
+    -> u64 {
+  static constexpr u64 multiplier = 0x9e3779b97f4a7c15ULL;
+  const auto mix = [](u64 hash, u64 word) {
+    hash = (hash ^ word) * multiplier;
+    return hash ^ (hash >> 32);
+  };
+
+  auto hash = mix(seed, bytes.size());
+  usize offset = 0;
+  for (; offset + sizeof(u64) <= bytes.size(); offset += sizeof(u64)) {
+    u64 word{};
+    std::memcpy(&word, bytes.data() + offset, sizeof(u64));
+    hash = mix(hash, word);
+  }
+
+  u64 tail{};
+  if (offset < bytes.size()) {
+    std::memcpy(&tail, bytes.data() + offset, bytes.size() - offset);
+  }
+  return mix(hash, tail);
+}
+
+/**
+ * @brief Folds the std::hash of `value` into `seed`, boost style.
+ */
+template <class T> auto hash_combine(usize &seed, const T &value) -> void {
+  seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+} // namespace Core
@@ -42,6 +42,9 @@ public:
   }
 
   [[nodiscard]] auto raw() const -> const void * { return data.get(); }
+  [[nodiscard]] auto span() const -> std::span<const u8> {
+    return {data.get(), data ? buffer_size : 0};
+  }
 
   [[nodiscard]] auto operator=(DataBuffer &&other) noexcept -> DataBuffer & {
     buffer_size = other.buffer_size;
@@ -12,6 +12,15 @@
 
 namespace Core {
 
+/**
+ * @brief A set which outlives the frame it was written in, and the pool it
+ * must be returned to.
+ */
+struct PersistentDescriptorSet {
+  VkDescriptorPool pool{nullptr};
+  VkDescriptorSet set{nullptr};
+};
+
 class DescriptorResource {
 public:
   ~DescriptorResource();
@@ -23,22 +32,49 @@ public:
       const VkDescriptorSetAllocateInfo &alloc_info) const
       -> std::vector<VkDescriptorSet>;
 
+  /**
+   * @brief Allocates a set which is not reset in begin_frame. It must be
+   * returned with free_persistent_descriptor_set.
+   */
+  [[nodiscard]] auto allocate_persistent_descriptor_set(
+      const VkDescriptorSetAllocateInfo &alloc_info) const
+      -> PersistentDescriptorSet;
+  /**
+   * @brief Returns the set to its pool once every frame in flight that could
+   * still bind it has completed, in the begin_frame of the same frame index.
+   */
+  auto free_persistent_descriptor_set(const PersistentDescriptorSet &) const
+      -> void;
+
   void begin_frame(u32 frame);
   void end_frame();
 
+  /**
+   * @brief Incremented by every begin_frame, so callers can tell whether a
+   * set was already written during the frame being recorded.
+   */
+  [[nodiscard]] auto get_frame_counter() const -> u64 { return frame_counter; }
+
   static auto construct(const Device &) -> Scope<DescriptorResource>;
 
 private:
   explicit DescriptorResource(const Device &);
 
   void create_pool();
+  [[nodiscard]] auto create_persistent_pool() const -> VkDescriptorPool;
   void handle_fragmentation() const;
   void handle_out_of_memory() const;
 
   const Device *device;
   u32 current_frame{0};
+  u64 frame_counter{0};
   std::array<VkDescriptorPool, Config::frame_count> descriptor_pools;
   std::array<VkDescriptorPoolSize, 11> pool_sizes;
+  // Grown by one pool whenever the last one is exhausted
+  mutable std::vector<VkDescriptorPool> persistent_pools;
+  // Sets freed while each frame was recorded, returned in its begin_frame
+  mutable std::array<std::vector<PersistentDescriptorSet>, Config::frame_count>
+      retired_sets;
 
   // Optional: Structure to keep track of allocated descriptor sets and their
   // usage
@@ -27,6 +27,10 @@ enum class Type : u8 {
 
 enum class Feature : u8 {
   DeviceQuery,
+  DrawIndirectCount,
+  Bindless,
+  TextureCompressionBC,
+  MemoryBudget,
 };
 
 class Device {
@@ -64,6 +68,62 @@ public:
     return descriptor_resource;
   }
 
+  /**
+   * @brief The global texture array, or nullptr if the device lacks
+   * descriptor indexing.
+   */
+  [[nodiscard]] auto get_bindless_textures() const -> BindlessTextures * {
+    return bindless_textures.get();
+  }
+
+  /**
+   * @brief The pipeline cache shared by every pipeline on this device.
+   */
+  [[nodiscard]] auto get_pipeline_cache() const -> PipelineCache & {
+    return *pipeline_cache;
+  }
+
+  /**
+   * @brief The staging ring shared by every upload on this device. Created
+   * on first use, since it needs the Allocator.
+   */
+  [[nodiscard]] auto get_staging_uploader() const -> StagingUploader &;
+  /**
+   * @brief Must be called before the Allocator is destroyed.
+   */
+  auto destroy_staging_uploader() -> void;
+
+  /**
+   * @brief The per-frame arenas for uniform and storage data. Created on
+   * first use, like the staging uploader.
+   */
+  [[nodiscard]] auto get_frame_allocator() const -> FrameAllocator &;
+  /**
+   * @brief Must be called after every BufferSet is destroyed, and before
+   * the Allocator is.
+   */
+  auto destroy_frame_allocator() -> void;
+
+  /**
+   * @brief Builds the mip chains of uploaded textures. Created on first use,
+   * like the staging uploader.
+   */
+  [[nodiscard]] auto get_mip_generator() const -> MipGenerator &;
+  /**
+   * @brief Must be called before the Allocator is destroyed.
+   */
+  auto destroy_mip_generator() -> void;
+
+  /**
+   * @brief Streams texture mip chains within the VRAM budget. Created on
+   * first use, like the staging uploader.
+   */
+  [[nodiscard]] auto get_texture_streamer() const -> TextureStreamer &;
+  /**
+   * @brief Must be called before the staging uploader is destroyed.
+   */
+  auto destroy_texture_streamer() -> void;
+
   auto get_physical_device_surface_formats(VkSurfaceKHR) const
       -> std::vector<VkSurfaceFormatKHR>;
   auto get_physical_device_surface_present_modes(VkSurfaceKHR) const
@@ -79,6 +139,12 @@ private:
   VkDevice device{nullptr};
   VkPhysicalDevice physical_device{nullptr};
   Scope<DescriptorResource> descriptor_resource;
+  mutable Scope<StagingUploader> staging_uploader;
+  mutable Scope<FrameAllocator> frame_allocator;
+  mutable Scope<MipGenerator> mip_generator;
+  mutable Scope<TextureStreamer> texture_streamer;
+  Scope<BindlessTextures> bindless_textures;
+  Scope<PipelineCache> pipeline_cache;
 
   auto construct_vulkan_device(const Window &) -> void;
 
@@ -90,6 +156,13 @@ private:
   struct QueueFeatureSupport {
     bool timestamping{false};
   };
+  struct DeviceFeatureSupport {
+    bool draw_indirect_count{false};
+    bool bindless{false};
+    bool texture_compression_bc{false};
+    bool memory_budget{false};
+  };
+  DeviceFeatureSupport feature_support{};
   std::unordered_map<Queue::Type, IndexedQueue> queues{};
   std::unordered_map<Queue::Type, QueueFeatureSupport> queue_support{};
 
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+#include "core/Forward.hpp"
+
+namespace Core {
+
+class Mesh;
+
+/**
+ * @brief Per-frame list of submesh draws, stored as structure of arrays.
+ *
+ * Every submission appends its transform to one flat array and finds its
+ * draw through an open-addressing table. `pack` then scatters the
+ * transforms, grouped per draw, into the transform buffer. `clear` keeps all
+ * capacity, so a steady-state frame does not allocate.
+ */
+class DrawList {
+public:
+  auto submit(const Mesh *mesh, u32 submesh_index, Material *material,
+              const glm::mat4 &transform) -> void;
+
+  /**
+   * @brief Copies the transforms of every draw contiguously into `output`,
+   * starting at `offset`, and assigns each draw its first instance. Draws
+   * that do not fit are dropped with a warning.
+   *
+   * @return The offset after the last written transform.
+   */
+  auto pack(std::span<glm::mat4> output, u32 offset) -> u32;
+
+  auto clear() -> void;
+
+  [[nodiscard]] auto size() const -> u32 {
+    return static_cast<u32>(meshes.size());
+  }
+  [[nodiscard]] auto instance_size() const -> u32 {
+    return static_cast<u32>(transforms.size());
+  }
+  // Instances that did not fit in the last pack
+  [[nodiscard]] auto dropped_instance_size() const -> u32 {
+    return dropped_instances;
+  }
+
+  [[nodiscard]] auto get_mesh(u32 draw) const -> const Mesh * {
+    return meshes[draw];
+  }
+  [[nodiscard]] auto get_submesh_index(u32 draw) const -> u32 {
+    return submesh_indices[draw];
+  }
+  [[nodiscard]] auto get_material(u32 draw) const -> Material * {
+    return materials[draw];
+  }
+  [[nodiscard]] auto get_instance_count(u32 draw) const -> u32 {
+    return instance_counts[draw];
+  }
+  // Offset into the per-frame transform buffer, assigned in pack
+  [[nodiscard]] auto get_first_instance(u32 draw) const -> u32 {
+    return first_instances[draw];
+  }
+  // Slot in the indirect command buffer, assigned by the renderer
+  [[nodiscard]] auto get_draw_index(u32 draw) const -> u32 {
+    return draw_indices[draw];
+  }
+  auto set_draw_index(u32 draw, u32 value) -> void {
+    draw_indices[draw] = value;
+  }
+
+private:
+  static constexpr u32 empty_slot = 0;
+
+  // One entry per draw
+  std::vector<const Mesh *> meshes;
+  std::vector<u32> submesh_indices;
+  std::vector<Material *> materials;
+  std::vector<u32> instance_counts;
+  std::vector<u32> first_instances;
+  std::vector<u32> draw_indices;
+
+  // One entry per submitted instance
+  std::vector<glm::mat4> transforms;
+  std::vector<u32> instance_draws;
+
+  // Draw index + 1 per slot, empty_slot if unused. Power of two sized.
+  std::vector<u32> slots;
+  // Write position of each draw while packing
+  std::vector<u32> cursors;
+  u32 dropped_instances{0};
+
+  [[nodiscard]] auto find_or_insert(const Mesh *, u32 submesh_index,
+                                    Material *) -> u32;
+  auto grow_slots() -> void;
+  [[nodiscard]] static auto hash(const Mesh *, u32 submesh_index) -> usize;
+};
+
+} // namespace Core
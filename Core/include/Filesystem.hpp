@@ -86,6 +86,26 @@ auto pipeline_cache(StringLike auto path, bool resolve = true)
   }
 }
 
+auto mesh_cache(StringLike auto path, bool resolve = true)
+    -> std::filesystem::path {
+  const auto output = std::filesystem::path("mesh_cache") / path;
+  if (resolve) {
+    return std::filesystem::absolute(output);
+  } else {
+    return output;
+  }
+}
+
+auto texture_cache(StringLike auto path, bool resolve = true)
+    -> std::filesystem::path {
+  const auto output = std::filesystem::path("texture_cache") / path;
+  if (resolve) {
+    return std::filesystem::absolute(output);
+  } else {
+    return output;
+  }
+}
+
 auto mkdir_safe(StringLike auto path) -> bool {
   const auto resolved = FS::resolve(path);
   if (std::filesystem::exists(resolved)) {
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "ArenaStack.hpp"
+#include "Buffer.hpp"
+#include "Config.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <vulkan/vulkan.h>
+
+#include "core/Forward.hpp"
+
+namespace Core {
+
+struct FrameAllocatorImpl;
+
+/**
+ * @brief A range of the arena of one frame in flight. `mapped` points at
+ * the start of the range.
+ */
+struct FrameAllocation {
+  VkBuffer buffer{nullptr};
+  u64 offset{0};
+  u64 size{0};
+  u8 *mapped{nullptr};
+  u32 frame{0};
+
+  [[nodiscard]] auto valid() const -> bool { return buffer != nullptr; }
+};
+
+/**
+ * @brief Persistently mapped arenas for uniform and storage data, one per
+ * frame in flight, owned by the device.
+ *
+ * The arenas share one VMA pool created with the linear algorithm. Inside
+ * an arena, transient allocations are bumped up from the bottom and reset
+ * wholesale by begin_frame, once the fence of that frame has been waited
+ * on. Retained ranges, like those of a BufferSet, are stacked down from the
+ * top and stay until they are released. Main thread only, like the staging
+ * uploader.
+ */
+class FrameAllocator {
+public:
+  ~FrameAllocator();
+
+  /**
+   * @brief A range of the current frame, valid until its frame index comes
+   * around again.
+   */
+  [[nodiscard]] auto allocate_transient(u64 size, Buffer::Type type)
+      -> FrameAllocation;
+
+  /**
+   * @brief A range of the arena of `frame` that lives until it is released,
+   * or an invalid allocation if the arena has no room for it.
+   */
+  [[nodiscard]] auto retain(u32 frame, u64 size, Buffer::Type type)
+      -> FrameAllocation;
+  auto release(const FrameAllocation &) -> void;
+
+  /**
+   * @brief Resets the transient allocations of `frame`. Called once per
+   * frame, after the fence of the frame being recorded has been waited on.
+   */
+  auto begin_frame(u32 frame) -> void;
+  [[nodiscard]] auto get_current_frame() const -> u32 { return current_frame; }
+  /**
+   * @brief Number of begin_frame calls, which tells transient ranges of
+   * different frames apart.
+   */
+  [[nodiscard]] auto get_frame_counter() const -> u64 { return frame_counter; }
+  /**
+   * @brief The whole arena of `frame`, which dynamic-offset descriptors of
+   * transient ranges point at.
+   */
+  [[nodiscard]] auto get_arena(u32 frame) const -> FrameAllocation;
+
+  /**
+   * @brief Offset alignment of ranges bound as `type`, from the device
+   * limits.
+   */
+  [[nodiscard]] auto get_alignment(Buffer::Type type) const -> u64;
+  [[nodiscard]] auto get_arena_size() const -> u64 { return arena_size; }
+
+  static auto construct(const Device &,
+                        u64 arena_size = Config::frame_arena_size)
+      -> Scope<FrameAllocator>;
+
+private:
+  FrameAllocator(const Device &, u64 arena_size);
+
+  const Device *device{nullptr};
+  u64 arena_size{0};
+  u64 uniform_alignment{0};
+  u64 storage_alignment{0};
+  u32 current_frame{0};
+  u64 frame_counter{0};
+
+  Scope<FrameAllocatorImpl> impl;
+  std::array<ArenaStack, Config::frame_count> arenas{};
+
+  [[nodiscard]] auto to_allocation(u32 frame, u64 offset, u64 size) const
+      -> FrameAllocation;
+};
+
+} // namespace Core
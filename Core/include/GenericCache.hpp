@@ -1,37 +1,76 @@
 #pragma once
 
 #include "Concepts.hpp"
+#include "Config.hpp"
 #include "Containers.hpp"
 #include "Device.hpp"
-#include "ThreadPool.hpp"
+#include "JobSystem.hpp"
+#include "Logger.hpp"
 #include "Types.hpp"
 
-#include <future>
-#include <queue>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <string>
-#include <unordered_set>
-
-#include "core/Forward.hpp"
+#include <vector>
 
 namespace Core {
 
-template <typename R> bool is_ready(const std::future<R> &f) {
-  return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
-}
-
+/**
+ * @brief Constructs a T from its properties in one step, on any thread.
+ */
 template <class Constructor>
-concept ConstructorLike = requires(
+concept DirectConstructorLike = requires(
     const Device &device, const typename Constructor::Properties &properties) {
   {
     Constructor::construct(device, properties)
   } -> std::same_as<Scope<typename Constructor::Type>>;
 };
 
+/**
+ * @brief Decodes on any thread, then constructs from the decoded data on the
+ * main thread. Used for GPU resources, whose uploads are not thread-safe.
+ */
+template <class Constructor>
+concept StagedConstructorLike =
+    requires(const Device &device,
+             const typename Constructor::Properties &properties,
+             typename Constructor::Decoded &&decoded) {
+      {
+        Constructor::decode(properties)
+      } -> std::same_as<typename Constructor::Decoded>;
+      {
+        Constructor::construct(device, properties, std::move(decoded))
+      } -> std::same_as<Scope<typename Constructor::Type>>;
+    };
+
+template <class Constructor>
+concept ConstructorLike = DirectConstructorLike<Constructor> ||
+                          StagedConstructorLike<Constructor>;
+
 template <class T, class P>
 concept Cacheable = requires(const Device &device, const P &properties) {
   { properties.identifier } -> std::convertible_to<std::string>;
 };
 
+/**
+ * @brief Snapshot of the counters of a GenericCache.
+ */
+struct CacheStatistics {
+  u64 hits{0};
+  u64 misses{0};
+  u64 evictions{0};
+  usize entries{0};
+  usize pending{0};
+  usize resident_bytes{0};
+  usize capacity_bytes{0};
+};
+
 template <class T, class P> struct DefaultConstructor {
   using Type = T;
   using Properties = P;
@@ -44,28 +83,66 @@ template <class T, class P> struct DefaultConstructor {
 /**
  * @brief A cache for objects of type T, with asynchronous loading capabilities.
  *
+ * Entries are spread over `shard_count` shards by the hash of their
+ * identifier, each behind its own reader-writer lock, so hits only take a
+ * shared lock on one shard. Loads run on the JobSystem and insert their
+ * result themselves when they finish; a load that fails or returns null
+ * keeps resolving to the loading texture.
+ *
+ * Resident entries are limited to `capacity_bytes`, weighed by `C::cost` if
+ * the constructor has one, else by `T::size_bytes`. Once over capacity, the
+ * least recently used entries are evicted down to seven eighths of it,
+ * skipping pinned entries and entries used in the current frame. Evicted
+ * objects are destroyed `Config::frame_count` frames later, when no frame in
+ * flight can still use them, so references returned by put_or_get stay
+ * valid until the end of the frame unless the entry is pinned.
+ *
  * @tparam T The type of objects to cache.
  * @tparam P The properties type used for object identification and
  * construction
  * @tparam IsAsynchronous Use the sync version of this cache
  * @tparam C A constructor-like class for creating objects of type T. Must
- * satisfy ConstructorLike concept. The ConstructorLike concept is satisfied by
- * any class with a static construct function that returns a Scope<T> and takes
- * a const Device & and a const P & as arguments.
+ * satisfy ConstructorLike concept, either with a static construct function
+ * that returns a Scope<T> and takes a const Device & and a const P &, or with
+ * a decode step that runs on a worker and a construct step from the decoded
+ * data that runs on the main thread.
  */
 template <class T, class P, bool IsAsynchronous = true,
           ConstructorLike C = DefaultConstructor<T, P>>
   requires(Cacheable<T, P>)
 class GenericCache {
 public:
+  static constexpr usize shard_bits = 4;
+  static constexpr usize shard_count = usize{1} << shard_bits;
+
   /**
    * @brief Construct a new Generic Cache object.
    *
    * @param dev Reference to the device used for object construction.
-   * @param loading_texture The texture to return while objects are loading.
+   * @param loading_texture The object to return while objects are loading.
+   * @param capacity_bytes Total cost above which entries are evicted.
    */
-  explicit GenericCache(const Device &dev, Scope<Texture> loading_texture)
-      : device(&dev), loading(std::move(loading_texture)) {}
+  explicit GenericCache(const Device &dev, Scope<T> loading_texture,
+                        usize capacity_bytes = Config::cache_capacity_bytes)
+      : device(&dev), capacity(capacity_bytes),
+        loading(std::move(loading_texture)) {}
+
+  ~GenericCache() {
+    // Loads hold on to this cache until they have inserted their result
+    std::vector<JobHandle> loads;
+    {
+      std::scoped_lock lock(in_flight_mutex);
+      loads.swap(in_flight);
+    }
+    try {
+      JobSystem::run_main_thread_jobs_until(JobSystem::when_all(loads));
+    } catch (const std::exception &exception) {
+      error("Cache load failed during shutdown: {}", exception.what());
+    }
+  }
+
+  GenericCache(const GenericCache &) = delete;
+  auto operator=(const GenericCache &) -> GenericCache & = delete;
 
   /**
    * @brief Get or load an object of type T, identified by properties of type P.
@@ -77,73 +154,331 @@ public:
    * texture if loading.
    */
   auto put_or_get(const P &props) -> const Scope<T> & {
-    std::scoped_lock lock(access);
-    if (processing_identifier_cache.contains(props.identifier)) {
-      return loading;
+    const std::string_view identifier{props.identifier};
+    auto &shard = shard_for(identifier);
+    {
+      std::shared_lock lock(shard.mutex);
+      if (const auto found = shard.entries.find(identifier);
+          found != shard.entries.end()) {
+        return touch(found->second);
+      }
     }
 
-    if (type_cache.contains(props.identifier)) {
-      return type_cache.at(props.identifier);
+    if constexpr (IsAsynchronous) {
+      std::unique_lock lock(shard.mutex);
+      auto [entry, inserted] = shard.entries.try_emplace(props.identifier);
+      if (!inserted) {
+        return touch(entry->second);
+      }
+      misses.fetch_add(1, std::memory_order_relaxed);
+      entry->second.last_used = frame.load(std::memory_order_relaxed);
+      lock.unlock();
+      load(props);
+      return loading;
     } else {
-      if constexpr (IsAsynchronous) {
-
-        processing_identifier_cache.emplace(props.identifier);
-        auto future_texture = ThreadPool::submit(
-            [this, props]() { return C::construct(*device, props); });
-
-        future_cache.emplace(CacheTask{
-            .identifier = props.identifier,
-            .future = std::move(future_texture),
-        });
-        return loading;
-      } else {
-        type_cache[props.identifier] = C::construct(*device, props);
-        return type_cache.at(props.identifier);
+      // Constructed without the lock, so hits on the shard are not held up.
+      // A racing load of the same identifier keeps whichever lands first,
+      // the other value is destroyed after the lock is released.
+      auto value = guarded(props.identifier, [&] {
+        if constexpr (StagedConstructorLike<C>) {
+          return C::construct(*device, props, C::decode(props));
+        } else {
+          return C::construct(*device, props);
+        }
+      });
+
+      std::unique_lock lock(shard.mutex);
+      auto [entry, inserted] = shard.entries.try_emplace(props.identifier);
+      if (!inserted) {
+        return touch(entry->second);
       }
+      misses.fetch_add(1, std::memory_order_relaxed);
+      entry->second.last_used = frame.load(std::memory_order_relaxed);
+      store(entry->second, std::move(value));
+      lock.unlock();
+      trim();
+      return resolve(entry->second);
     }
   }
 
   /**
-   * @brief Update the cache by loading the next object in the queue.
-   *
-   * Will generally be called by external thread (non-main thread).
+   * @brief Advances the cache to the next frame. Call once per frame, after
+   * the fence of the frame being recorded has been waited on.
    */
-  auto update_one() {
-    if (future_cache.empty()) {
-      return;
+  auto begin_frame() -> void {
+    const auto current = frame.fetch_add(1, std::memory_order_relaxed) + 1;
+
+    std::vector<Scope<T>> destroyed;
+    {
+      std::scoped_lock lock(retired_mutex);
+      destroyed.swap(retired[current % Config::frame_count]);
     }
+    trim();
+  }
 
-    std::scoped_lock lock(access);
-    auto &&[identifier, future] = future_cache.front();
-    // Check state of future
-    if (is_ready(future)) {
-      return;
+  /**
+   * @brief Keeps an entry resident until it is unpinned, e.g. while it is
+   * referenced beyond the current frame. Returns false if it is not cached.
+   */
+  auto pin(std::string_view identifier) -> bool {
+    auto &shard = shard_for(identifier);
+    std::shared_lock lock(shard.mutex);
+    const auto found = shard.entries.find(identifier);
+    if (found == shard.entries.end()) {
+      return false;
     }
+    found->second.pins.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
 
-    auto result = future.get();
-    type_cache[identifier] = std::move(result);
-    future_cache.pop();
-    processing_identifier_cache.erase(identifier);
+  auto unpin(std::string_view identifier) -> void {
+    auto &shard = shard_for(identifier);
+    std::shared_lock lock(shard.mutex);
+    if (const auto found = shard.entries.find(identifier);
+        found != shard.entries.end()) {
+      found->second.pins.fetch_sub(1, std::memory_order_relaxed);
+    }
   }
 
-  auto type_cache_size() const -> usize { return type_cache.size(); }
-  auto future_cache_size() const -> usize { return future_cache.size(); }
+  auto statistics() const -> CacheStatistics {
+    return {
+        .hits = hits.load(std::memory_order_relaxed),
+        .misses = misses.load(std::memory_order_relaxed),
+        .evictions = evictions.load(std::memory_order_relaxed),
+        .entries = type_cache_size(),
+        .pending = pending,
+        .resident_bytes = resident,
+        .capacity_bytes = capacity,
+    };
+  }
+
+  auto type_cache_size() const -> usize {
+    usize size = 0;
+    for (const auto &shard : shards) {
+      std::shared_lock lock(shard.mutex);
+      size += shard.entries.size();
+    }
+    return size;
+  }
+  auto pending_size() const -> usize { return pending; }
 
-  auto get_loading_texture() const -> const Scope<Texture> & { return loading; }
+  auto get_loading_texture() const -> const Scope<T> & { return loading; }
 
 private:
   const Device *device;
 
-  struct CacheTask {
+  enum class EntryState : u8 { Loading, Ready, Failed };
+  struct Entry {
+    Scope<T> value{nullptr};
+    EntryState state{EntryState::Loading};
+    usize cost{0};
+    // Written under the shared lock by hits, read under the exclusive lock
+    // by eviction
+    std::atomic<u64> last_used{0};
+    std::atomic<u32> pins{0};
+  };
+
+  struct Shard {
+    mutable std::shared_mutex mutex;
+    Container::StringLikeMap<Entry> entries;
+  };
+
+  std::array<Shard, shard_count> shards{};
+  std::atomic<usize> pending{0};
+
+  const usize capacity;
+  std::atomic<usize> resident{0};
+  std::atomic<u64> frame{0};
+  std::atomic<u64> hits{0};
+  std::atomic<u64> misses{0};
+  std::atomic<u64> evictions{0};
+
+  std::mutex trim_mutex;
+  std::mutex retired_mutex;
+  std::array<std::vector<Scope<T>>, Config::frame_count> retired{};
+
+  std::mutex in_flight_mutex;
+  std::vector<JobHandle> in_flight{};
+
+  Scope<T> loading;
+
+  static auto shard_index(std::string_view identifier) -> usize {
+    // The maps bucket by the low bits of the same hash
+    const auto hash = Container::StringLikeHasher{}(identifier);
+    return hash >> (sizeof(usize) * 8 - shard_bits);
+  }
+
+  auto shard_for(std::string_view identifier) -> Shard & {
+    return shards[shard_index(identifier)];
+  }
+
+  // Ready entries never change until they are evicted
+  auto resolve(const Entry &entry) const -> const Scope<T> & {
+    return entry.state == EntryState::Ready ? entry.value : loading;
+  }
+
+  auto touch(Entry &entry) -> const Scope<T> & {
+    hits.fetch_add(1, std::memory_order_relaxed);
+    entry.last_used.store(frame.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+    return resolve(entry);
+  }
+
+  static auto cost_of(const T &value) -> usize {
+    if constexpr (requires {
+                    { C::cost(value) } -> std::convertible_to<usize>;
+                  }) {
+      return C::cost(value);
+    } else if constexpr (requires {
+                           { value.size_bytes() } -> std::convertible_to<usize>;
+                         }) {
+      return value.size_bytes();
+    } else {
+      return 1;
+    }
+  }
+
+  // Called with the shard locked exclusively
+  auto store(Entry &entry, Scope<T> value) -> void {
+    entry.value = std::move(value);
+    entry.state = entry.value ? EntryState::Ready : EntryState::Failed;
+    entry.cost = entry.value ? cost_of(*entry.value) : 0;
+    resident += entry.cost;
+  }
+
+  struct Candidate {
+    u64 last_used;
+    usize shard;
     std::string identifier;
-    std::future<Scope<T>> future;
   };
 
-  std::queue<CacheTask> future_cache;
-  std::unordered_set<std::string> processing_identifier_cache;
-  Container::StringLikeMap<Scope<T>> type_cache;
-  std::mutex access;
-  Scope<Texture> loading;
+  auto evictable(const Entry &entry, u64 current) const -> bool {
+    return entry.state == EntryState::Ready &&
+           entry.pins.load(std::memory_order_relaxed) == 0 &&
+           entry.last_used.load(std::memory_order_relaxed) < current;
+  }
+
+  auto trim() -> void {
+    if (resident <= capacity) {
+      return;
+    }
+    // One trim at a time is enough, the others would find the same victims
+    std::unique_lock trimming(trim_mutex, std::try_to_lock);
+    if (!trimming.owns_lock()) {
+      return;
+    }
+
+    const auto current = frame.load(std::memory_order_relaxed);
+    std::vector<Candidate> candidates;
+    for (usize index = 0; index < shard_count; ++index) {
+      std::shared_lock lock(shards[index].mutex);
+      for (const auto &[identifier, entry] : shards[index].entries) {
+        if (evictable(entry, current)) {
+          candidates.push_back(
+              {entry.last_used.load(std::memory_order_relaxed), index,
+               identifier});
+        }
+      }
+    }
+    std::ranges::sort(candidates, {}, &Candidate::last_used);
+
+    const auto target = capacity - capacity / 8;
+    std::vector<Scope<T>> evicted;
+    for (const auto &candidate : candidates) {
+      if (resident <= target) {
+        break;
+      }
+
+      auto &shard = shards[candidate.shard];
+      std::unique_lock lock(shard.mutex);
+      const auto found = shard.entries.find(candidate.identifier);
+      // It may have been used or pinned since it was collected
+      if (found == shard.entries.end() || !evictable(found->second, current)) {
+        continue;
+      }
+      resident -= found->second.cost;
+      evicted.push_back(std::move(found->second.value));
+      shard.entries.erase(found);
+      evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (evicted.empty()) {
+      return;
+    }
+    std::scoped_lock lock(retired_mutex);
+    auto &slot = retired[current % Config::frame_count];
+    std::ranges::move(evicted, std::back_inserter(slot));
+  }
+
+  template <typename F>
+  static auto guarded(const std::string &identifier, F &&make) -> Scope<T> {
+    try {
+      return make();
+    } catch (const std::exception &exception) {
+      warn("Could not load '{}' into the cache: {}", identifier,
+           exception.what());
+      return nullptr;
+    }
+  }
+
+  auto complete(const std::string &identifier, Scope<T> value) -> void {
+    {
+      auto &shard = shard_for(identifier);
+      std::unique_lock lock(shard.mutex);
+      auto &entry = shard.entries[identifier];
+      store(entry, std::move(value));
+      // Not evicted before it has been seen at least once
+      entry.last_used = frame.load(std::memory_order_relaxed);
+      --pending;
+    }
+    trim();
+  }
+
+  auto load(const P &props) -> void {
+    ++pending;
+
+    JobHandle job;
+    if constexpr (StagedConstructorLike<C>) {
+      using Decoded = typename C::Decoded;
+      auto decoded = make_ref<std::optional<Decoded>>();
+      const auto decode = JobSystem::schedule(
+          [props, decoded] {
+            try {
+              *decoded = C::decode(props);
+            } catch (const std::exception &exception) {
+              warn("Could not decode '{}' for the cache: {}",
+                   props.identifier, exception.what());
+            }
+          },
+          {}, JobAffinity::Background);
+      // GPU uploads go through the device's staging ring, which only the
+      // main thread may touch
+      job = JobSystem::then(
+          decode,
+          [this, props, decoded] {
+            complete(props.identifier, guarded(props.identifier, [&] {
+                       return decoded->has_value()
+                                  ? C::construct(*device, props,
+                                                 std::move(**decoded))
+                                  : Scope<T>{nullptr};
+                     }));
+          },
+          JobAffinity::MainThread);
+    } else {
+      job = JobSystem::schedule(
+          [this, props] {
+            complete(props.identifier, guarded(props.identifier, [&] {
+                       return C::construct(*device, props);
+                     }));
+          },
+          {}, JobAffinity::Background);
+    }
+
+    std::scoped_lock lock(in_flight_mutex);
+    std::erase_if(in_flight,
+                  [](const JobHandle &handle) { return handle.is_done(); });
+    in_flight.push_back(std::move(job));
+  }
 };
 
 } // namespace Core
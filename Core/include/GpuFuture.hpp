@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <limits>
+#include <vulkan/vulkan.h>
+
+namespace Core {
+
+/**
+ * @brief Ticket for a queue submission. It completes when the timeline
+ * semaphore reaches the submitted value. A default constructed future is
+ * always ready.
+ */
+class GpuFuture {
+public:
+  GpuFuture() = default;
+  GpuFuture(VkDevice device, VkSemaphore semaphore, u64 value)
+      : device(device), semaphore(semaphore), value(value) {}
+
+  [[nodiscard]] auto is_ready() const -> bool;
+
+  /**
+   * @brief Blocks until the submission completes or the timeout expires.
+   * @return true if the submission completed.
+   */
+  auto wait(u64 timeout_in_ns = std::numeric_limits<u64>::max()) const
+      -> bool;
+
+  [[nodiscard]] auto get_semaphore() const -> VkSemaphore { return semaphore; }
+  [[nodiscard]] auto get_value() const -> u64 { return value; }
+
+private:
+  VkDevice device{nullptr};
+  VkSemaphore semaphore{nullptr};
+  u64 value{0};
+};
+
+} // namespace Core
@@ -40,6 +40,8 @@ struct ImageProperties {
   SamplerAddressMode address_mode{SamplerAddressMode::Repeat};
   SamplerBorderColor border_color{SamplerBorderColor::FloatOpaqueBlack};
   CompareOperation compare_op{CompareOperation::Less};
+  /** @brief Names the allocation in VMA and the memory telemetry. */
+  std::string debug_name{};
 };
 
 class Image {
@@ -49,6 +51,13 @@ public:
   Image(const Device &, ImageProperties properties);
   Image(const Device &, ImageProperties properties,
         const DataBuffer &data_buffer);
+  /**
+   * @brief Uploads a complete mip chain, where level i starts at
+   * `level_offsets[i]` in `data`. Used for pre-built chains, such as block
+   * compressed data or KTX2 files, whose levels are not generated on the GPU.
+   */
+  Image(const Device &, ImageProperties properties, std::span<const u8> data,
+        std::span<const u64> level_offsets);
   ~Image();
 
   auto recreate() -> void;
@@ -62,6 +71,10 @@ public:
       -> const VkDescriptorImageInfo &;
   [[nodiscard]] auto get_vulkan_type() const noexcept -> VkDescriptorType;
   [[nodiscard]] auto get_extent() const noexcept -> const Extent<u32> &;
+  [[nodiscard]] auto get_image() const noexcept -> VkImage;
+  [[nodiscard]] auto get_aspect_mask() const noexcept -> VkImageAspectFlags {
+    return aspect_bit;
+  }
   [[nodiscard]] auto hash() const noexcept -> usize;
 
   static auto construct_reference(const Device &device,
@@ -75,7 +88,6 @@ private:
   Scope<ImageStorageImpl> impl{nullptr};
   VkImageAspectFlags aspect_bit{VK_IMAGE_ASPECT_COLOR_BIT};
 
-  auto create_mips() -> void;
   auto load_image_data_from_buffer(const DataBuffer &) const -> void;
   auto initialise_vulkan_image() -> void;
   auto initialise_vulkan_descriptor_info() -> void;
@@ -101,10 +101,53 @@ enum class ImageFormat : std::uint8_t {
   UNORM_RGBA8,
   DEPTH32F,
   DEPTH24STENCIL8,
-  DEPTH16
+  DEPTH16,
+  // Block compressed, 4x4 texels per block
+  BC1_UNORM,
+  BC1_SRGB,
+  BC3_UNORM,
+  BC3_SRGB,
+  BC5_UNORM,
+  BC7_UNORM,
+  BC7_SRGB,
+  // BC1 with 1-bit alpha, as stored in KTX2 files
+  BC1_RGBA_UNORM,
+  BC1_RGBA_SRGB,
 };
 auto to_vulkan_format(ImageFormat format) -> VkFormat;
 
+/**
+ * @brief Bytes per 4x4 block of a block compressed format, 0 otherwise.
+ */
+constexpr auto block_size(ImageFormat format) -> u32 {
+  switch (format) {
+    using enum ImageFormat;
+  case BC1_UNORM:
+  case BC1_SRGB:
+  case BC1_RGBA_UNORM:
+  case BC1_RGBA_SRGB:
+    return 8;
+  case BC3_UNORM:
+  case BC3_SRGB:
+  case BC5_UNORM:
+  case BC7_UNORM:
+  case BC7_SRGB:
+    return 16;
+  default:
+    return 0;
+  }
+}
+
+constexpr auto is_block_compressed(ImageFormat format) -> bool {
+  return block_size(format) != 0;
+}
+
+constexpr auto is_srgb(ImageFormat format) -> bool {
+  using enum ImageFormat;
+  return format == SRGB_RGBA8 || format == BC1_SRGB || format == BC3_SRGB ||
+         format == BC7_SRGB || format == BC1_RGBA_SRGB;
+}
+
 enum class SamplerFilter : std::uint8_t {
   Nearest,
   Linear,
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace Core {
+
+namespace Detail {
+struct JobState;
+}
+
+/**
+ * @brief Where a job may run. Background jobs are long ones, such as texture
+ * decodes, that only workers run, so the main thread waiting on frame work
+ * never picks one up.
+ */
+enum class JobAffinity : u8 { Any, MainThread, Background };
+
+/**
+ * @brief Shared handle to a job scheduled on the JobSystem. Default
+ * constructed handles count as done.
+ */
+class JobHandle {
+public:
+  JobHandle() = default;
+
+  [[nodiscard]] auto is_done() const -> bool;
+  [[nodiscard]] auto valid() const -> bool { return state != nullptr; }
+
+  /**
+   * @brief Runs other jobs until this one has finished, then rethrows
+   * anything the job threw. Main-thread jobs are never run here, so a graph
+   * containing one is waited on with JobSystem::run_main_thread_jobs_until.
+   * The main thread does not run background jobs here either.
+   */
+  auto wait() const -> void;
+
+private:
+  explicit JobHandle(Ref<Detail::JobState> job) : state(std::move(job)) {}
+
+  Ref<Detail::JobState> state{nullptr};
+
+  friend class JobSystem;
+};
+
+/**
+ * @brief Work-stealing job system with dependencies between jobs.
+ *
+ * There is one worker per hardware thread besides the main thread, unless
+ * Config::thread_count overrides it. Every worker owns a deque: it pushes and
+ * pops its own jobs at the back, and steals from the front of the others when
+ * it runs dry. A job only becomes runnable once all of its dependencies have
+ * finished, so graphs are built up front instead of blocking on futures.
+ * Main-thread jobs are queued separately and only run where the main thread
+ * asks for them, in run_main_thread_jobs and run_main_thread_jobs_until.
+ * Background jobs share one more queue, which workers only turn to once
+ * there is nothing else to run or steal.
+ */
+class JobSystem {
+public:
+  using Work = std::function<void()>;
+
+  /**
+   * @brief Binds the calling thread as the main thread and starts the
+   * workers. Called once by the App, before anything is scheduled.
+   */
+  static auto initialise() -> void;
+
+  /**
+   * @brief Schedules `work` to run once every job in `dependencies` is done.
+   */
+  static auto schedule(Work work, std::span<const JobHandle> dependencies = {},
+                       JobAffinity affinity = JobAffinity::Any) -> JobHandle;
+
+  /**
+   * @brief Continuation, runs `work` after `job` has finished.
+   */
+  static auto then(const JobHandle &job, Work work,
+                   JobAffinity affinity = JobAffinity::Any) -> JobHandle {
+    return schedule(std::move(work), std::span{&job, 1}, affinity);
+  }
+
+  /**
+   * @brief Finishes after every job in `jobs`. Waiting on it rethrows the
+   * first exception of those jobs.
+   */
+  static auto when_all(std::span<const JobHandle> jobs) -> JobHandle;
+
+  /**
+   * @brief Calls `body(index)` for every index in [begin, end), in chunks of
+   * `grain` indices per job.
+   */
+  template <typename F>
+  static auto parallel_for(usize begin, usize end, usize grain, F &&body,
+                           std::span<const JobHandle> dependencies = {})
+      -> JobHandle {
+    if (begin >= end) {
+      return when_all(dependencies);
+    }
+
+    grain = std::max(grain, usize{1});
+    auto shared_body = make_ref<std::decay_t<F>>(std::forward<F>(body));
+    std::vector<JobHandle> chunks;
+    chunks.reserve((end - begin + grain - 1) / grain);
+    for (auto first = begin; first < end;) {
+      const auto last = first + std::min(grain, end - first);
+      chunks.push_back(schedule(
+          [shared_body, first, last] {
+            for (auto index = first; index < last; ++index) {
+              (*shared_body)(index);
+            }
+          },
+          dependencies));
+      first = last;
+    }
+    return when_all(chunks);
+  }
+
+  /**
+   * @brief Schedules `task` without dependencies, for callers that want its
+   * result through a future.
+   */
+  template <typename F, typename R = std::invoke_result_t<std::decay_t<F>>>
+  [[nodiscard]] static auto submit(F &&task) -> std::future<R> {
+    auto packaged = make_ref<std::packaged_task<R()>>(std::forward<F>(task));
+    auto future = packaged->get_future();
+    schedule([packaged] { (*packaged)(); });
+    return future;
+  }
+
+  /**
+   * @brief Runs every runnable main-thread job, called once per frame.
+   * Returns the number of jobs that ran.
+   */
+  static auto run_main_thread_jobs() -> u32;
+  /**
+   * @brief Runs main-thread, background and other jobs until `job` has
+   * finished, then rethrows anything it threw. For shutdown paths waiting on
+   * graphs with main-thread continuations.
+   */
+  static auto run_main_thread_jobs_until(const JobHandle &job) -> void;
+
+  [[nodiscard]] static auto worker_count() -> u32;
+  [[nodiscard]] static auto is_main_thread() -> bool;
+
+private:
+  JobSystem() = default;
+};
+
+} // namespace Core
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Filesystem.hpp"
+#include "ImageProperties.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Core {
+
+struct Ktx2Layout {
+  ImageFormat format{ImageFormat::Undefined};
+  Extent<u32> extent{};
+  // Byte range of the file that holds every mip level
+  u64 payload_offset{0};
+  u64 payload_size{0};
+  // Start of each level relative to payload_offset, largest first
+  std::vector<u64> level_offsets{};
+};
+
+/**
+ * @brief Reader for KTX2 containers with a pre-built mip chain.
+ *
+ * Only the level index is parsed; the levels themselves are uploaded as
+ * they are stored in the file, without any CPU decode. Supported are 2D,
+ * single layer textures whose vkFormat has an ImageFormat, without
+ * supercompression.
+ */
+class Ktx2Reader {
+public:
+  static constexpr std::array<u8, 12> identifier{
+      0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n',
+  };
+
+  [[nodiscard]] static auto is_ktx2(const FS::Path &) -> bool;
+
+  /**
+   * @brief Validates the header and level index of `file`, which must be the
+   * whole container. Returns nullopt, with a warning, if it cannot be used.
+   */
+  [[nodiscard]] static auto parse(std::span<const u8> file)
+      -> std::optional<Ktx2Layout>;
+
+private:
+  Ktx2Reader() = default;
+};
+
+} // namespace Core
@@ -2,13 +2,19 @@
 
 #include "Types.hpp"
 
+#include <array>
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstring>
 #include <fmt/core.h>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <tuple>
+#include <type_traits>
 
 namespace Core {
 
@@ -21,19 +27,118 @@ enum class LogLevel {
   None // To disable logging
 };
 
-struct BackgroundLogMessage {
-  std::string message;
-  LogLevel level{LogLevel::None};
-};
+namespace Detail {
+
+template <typename T>
+concept LogStringArgument =
+    std::is_same_v<std::decay_t<T>, const char *> ||
+    std::is_same_v<std::decay_t<T>, char *> ||
+    std::is_same_v<std::remove_cvref_t<T>, std::string> ||
+    std::is_same_v<std::remove_cvref_t<T>, std::string_view>;
+
+// Values that format the same after being copied, so formatting them can be
+// left to the background thread
+template <typename T>
+concept LogValueArgument =
+    std::is_arithmetic_v<std::remove_cvref_t<T>> ||
+    std::is_enum_v<std::remove_cvref_t<T>> ||
+    std::is_same_v<std::decay_t<T>, const void *> ||
+    std::is_same_v<std::decay_t<T>, void *>;
+
+template <typename T>
+concept DeferredLogArgument = LogStringArgument<T> || LogValueArgument<T>;
+
+template <typename T>
+using DecodedLogArgument =
+    std::conditional_t<LogStringArgument<T>, std::string_view,
+                       std::remove_cvref_t<T>>;
+
+template <typename T> auto encoded_size(const T &value) -> usize {
+  if constexpr (LogStringArgument<T>) {
+    return sizeof(u32) + std::string_view{value}.size();
+  } else {
+    return sizeof(std::remove_cvref_t<T>);
+  }
+}
+
+template <typename T> auto encode(u8 *&output, const T &value) -> void {
+  if constexpr (LogStringArgument<T>) {
+    const std::string_view text{value};
+    const auto size = static_cast<u32>(text.size());
+    std::memcpy(output, &size, sizeof(size));
+    std::memcpy(output + sizeof(size), text.data(), text.size());
+    output += sizeof(size) + text.size();
+  } else {
+    std::memcpy(output, &value, sizeof(value));
+    output += sizeof(value);
+  }
+}
+
+template <typename T>
+auto decode(const u8 *&input) -> DecodedLogArgument<T> {
+  if constexpr (LogStringArgument<T>) {
+    u32 size{0};
+    std::memcpy(&size, input, sizeof(size));
+    const std::string_view text{
+        reinterpret_cast<const char *>(input + sizeof(size)), size};
+    input += sizeof(size) + size;
+    return text;
+  } else {
+    DecodedLogArgument<T> value;
+    std::memcpy(&value, input, sizeof(value));
+    input += sizeof(value);
+    return value;
+  }
+}
+
+using LogFormatter = void (*)(std::string_view format, const u8 *payload,
+                              std::string &output);
+using LogSink = void (*)(std::string_view output);
 
+template <typename... Args>
+auto format_log_record(std::string_view format, const u8 *payload,
+                       std::string &output) -> void {
+  // Braced initialisation decodes the arguments left to right
+  std::tuple<DecodedLogArgument<Args>...> values{decode<Args>(payload)...};
+  std::apply(
+      [&](auto &...value) {
+        fmt::vformat_to(std::back_inserter(output), format,
+                        fmt::make_format_args(value...));
+      },
+      values);
+}
+
+} // namespace Detail
+
+/**
+ * @brief Asynchronous logger backed by a bounded lock-free queue.
+ *
+ * Callers claim a record in a ring of `queue_capacity` slots and copy the
+ * format string pointer and their arguments into it. Formatting happens on
+ * the background thread, which appends to a block buffer that is written
+ * once it exceeds `flush_threshold` bytes, after `flush_interval`, or after
+ * an error. Arguments that cannot be copied safely, such as spans or types
+ * with their own formatter, are formatted by the caller into the record.
+ * Format strings must outlive the call, as string literals do.
+ */
 class Logger {
 public:
+  static constexpr usize queue_capacity = 4096;
+  static constexpr usize record_payload_size = 192;
+  static constexpr usize flush_threshold = 64ULL * 1024ULL;
+  static constexpr auto flush_interval = std::chrono::milliseconds{50};
+
   static Logger &get_instance();
   static void stop();
   ~Logger();
 
   void set_level(LogLevel level);
   auto get_level() const -> LogLevel;
+  /**
+   * @brief Redirects written blocks from stdout to `sink`, null restores
+   * stdout. Called from the background thread.
+   */
+  void set_sink(Detail::LogSink sink);
 
   Logger(const Logger &) = delete;
   Logger &operator=(const Logger &) = delete;
@@ -56,19 +161,48 @@ public:
 private:
   Logger();
 
+  struct alignas(64) Record {
+    // Slot i is free for position i + k * capacity and holds a message when
+    // the sequence is one past its position
+    std::atomic<u64> sequence{0};
+    LogLevel level{LogLevel::None};
+    u32 size{0};
+    // Null when the caller formatted the message into the payload or the
+    // overflow
+    Detail::LogFormatter formatter{nullptr};
+    std::string_view format{};
+    std::array<u8, record_payload_size> payload{};
+    std::string overflow{};
+  };
+
   void stop_all();
-  void log(std::string &&message, LogLevel level);
+  template <typename... Args>
+  void log(LogLevel level, fmt::format_string<Args...> format,
+           Args &&...args) noexcept;
+  auto claim(u64 &position) -> Record &;
+  void publish(Record &record, u64 position);
+  void write_immediately(LogLevel level, std::string_view message);
+  void write(std::string_view output);
   void process_queue(const std::stop_token &);
+  auto drain(std::string &output) -> usize;
 
   LogLevel current_level{LogLevel::None};
-  static void process_single(const BackgroundLogMessage &message);
+  static void append_record(const Record &record, std::string &output);
+  static void append_line(LogLevel level, std::string_view message,
+                          std::string &output);
   static LogLevel get_log_level_from_environment();
 
-  std::queue<BackgroundLogMessage> log_queue;
-  std::mutex queue_mutex;
+  std::unique_ptr<Record[]> records;
+  alignas(64) std::atomic<u64> tail{0};
+  alignas(64) std::atomic<u64> head{0};
+
+  std::mutex wake_mutex;
   std::condition_variable cv;
+  std::atomic_bool consumer_sleeping{false};
   std::jthread worker;
-  std::atomic_bool exit_flag;
+  std::atomic_bool exit_flag{false};
+  std::atomic_bool errors_pending{false};
+  std::atomic<Detail::LogSink> sink{nullptr};
 };
 
 } // namespace Core
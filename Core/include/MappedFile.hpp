@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Filesystem.hpp"
+#include "Types.hpp"
+
+#include <memory>
+#include <span>
+
+namespace Core {
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+  virtual ~MappedFile() = default;
+  [[nodiscard]] virtual auto data() const -> std::span<const u8> = 0;
+  [[nodiscard]] virtual bool is_valid() const = 0;
+
+  static auto construct(const FS::Path &path) -> std::unique_ptr<MappedFile>;
+};
+
+} // namespace Core
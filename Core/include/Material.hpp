@@ -10,6 +10,7 @@
 
 #include <BufferSet.hpp>
 #include <optional>
+#include <span>
 
 #include "reflection/ReflectionData.hpp"
 
@@ -20,6 +21,7 @@ public:
   static auto construct(const Device &, const Shader &) -> Scope<Material>;
   static auto construct_reference(const Device &, const Shader &)
       -> Ref<Material>;
+  ~Material();
 
   auto on_resize(const Extent<u32> &) -> void;
 
@@ -41,10 +43,16 @@ public:
     return constant_buffer;
   }
 
+  /**
+   * @brief Writes this frame's descriptor sets, if any bound resource or
+   * buffer changed since they were last written for this frame in flight.
+   * `dynamic_offsets` follow Shader::get_dynamic_bindings and are bound
+   * with the sets, missing ones are zero.
+   */
   auto
   update_for_rendering(FrameIndex frame_index,
-                       const std::vector<std::vector<VkWriteDescriptorSet>> &)
-      -> void;
+                       const std::vector<std::vector<VkWriteDescriptorSet>> &,
+                       std::span<const u32> dynamic_offsets = {}) -> void;
   auto update_for_rendering(FrameIndex frame_index) -> void {
     update_for_rendering(frame_index, {});
   }
@@ -61,6 +69,10 @@ public:
   }
 
   [[nodiscard]] auto get_shader() const -> const auto & { return *shader; }
+  /**
+   * @brief Process-unique id, used to group draws of the same material.
+   */
+  [[nodiscard]] auto get_id() const -> u32 { return id; }
 
 private:
   Material(const Device &, const Shader &);
@@ -71,6 +83,14 @@ private:
                  VkDescriptorSet additional_set) const -> void;
 
   auto set(std::string_view, const void *data) -> bool;
+  /**
+   * @brief Writes the global array index of `image` into the push constant
+   * `pc.<name>`, for shaders using BindlessTextures. The index of `texture`
+   * is refreshed before every update, since streamed textures swap images.
+   */
+  auto set_bindless(std::string_view name, const Image &image,
+                    const Texture *texture = nullptr) -> bool;
+  auto refresh_bindless_indices() -> void;
   [[nodiscard]] auto find_resource(std::string_view)
       -> std::optional<const Reflection::ShaderResourceDeclaration *>;
   [[nodiscard]] auto find_uniform(std::string_view) const
@@ -78,6 +98,7 @@ private:
 
   const Device *device{nullptr};
   const Shader *shader{nullptr};
+  u32 id{0};
 
   DataBuffer constant_buffer{};
   void initialise_constant_buffer();
@@ -85,6 +106,15 @@ private:
   auto invalidate_descriptor_sets() -> void;
   auto invalidate() -> void;
 
+  /**
+   * @brief Hash of every resource which would be written for a frame:
+   * texture and image hashes, layouts and buffer ranges.
+   */
+  [[nodiscard]] auto
+  compute_descriptor_key(const std::vector<VkWriteDescriptorSet> &) const
+      -> usize;
+  auto release_persistent_sets() -> void;
+
   enum class PendingDescriptorType : std::uint8_t {
     None = 0,
     Texture2D = 1,
@@ -121,11 +151,22 @@ private:
       descriptor_sets{};
 
   std::vector<const Texture *> texture_references;
+  // Push constant offset of each bindless texture index
+  std::unordered_map<u32, const Texture *> bindless_textures;
   std::vector<const Image *> image_references;
 
   std::vector<std::vector<VkWriteDescriptorSet>> write_descriptors;
   std::vector<bool> dirty_descriptor_sets;
 
+  // Sets 0 and 1 per frame in flight, rewritten in place when the key of
+  // that frame changes.
+  std::vector<std::vector<PersistentDescriptorSet>> persistent_sets;
+  std::vector<std::optional<usize>> descriptor_keys;
+  std::vector<u64> written_in_frame;
+  std::vector<bool> transient_sets;
+  // Change every frame without rewriting the sets
+  std::vector<std::vector<u32>> dynamic_offsets;
+
   std::unordered_map<std::string_view, Reflection::ShaderResourceDeclaration>
       identifiers{};
 };
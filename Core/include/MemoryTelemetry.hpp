@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Filesystem.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Core {
+
+enum class MemoryCategory : u8 {
+  Vertex,
+  Index,
+  Uniform,
+  Storage,
+  Image,
+  Staging,
+  Frame,
+  Other,
+};
+static constexpr usize memory_category_count = 8;
+
+auto to_string(MemoryCategory) -> std::string_view;
+
+struct MemoryUsage {
+  u64 live_bytes{0};
+  u64 live_allocations{0};
+  u64 peak_bytes{0};
+};
+
+struct NamedMemoryUsage {
+  std::string resource_name{};
+  MemoryCategory category{MemoryCategory::Other};
+  u64 live_bytes{0};
+  u64 live_allocations{0};
+};
+
+/**
+ * @brief What VMA reports for one memory heap. `usage` and `budget` come
+ * from VK_EXT_memory_budget when the device has it, and are estimates
+ * otherwise.
+ */
+struct HeapBudget {
+  u32 heap_index{0};
+  bool device_local{false};
+  u64 block_bytes{0};
+  u64 allocation_bytes{0};
+  u64 usage{0};
+  u64 budget{0};
+};
+
+struct MemorySnapshot {
+  u64 frame{0};
+  u32 allocations_last_frame{0};
+  u32 frees_last_frame{0};
+  std::array<MemoryUsage, memory_category_count> categories{};
+  // Sorted by live bytes, largest first
+  std::vector<NamedMemoryUsage> resources{};
+  std::vector<HeapBudget> heaps{};
+};
+
+/**
+ * @brief Process-wide accounting of every allocation made through the
+ * Allocator.
+ *
+ * Each allocation carries its resource name and category as VMA user data,
+ * so frees are attributed to the same bucket they were counted in. The
+ * counters are safe to update from any thread.
+ */
+class MemoryTelemetry {
+public:
+  static auto record_allocation(MemoryCategory, std::string_view name,
+                                u64 bytes) -> void;
+  static auto record_free(MemoryCategory, std::string_view name, u64 bytes)
+      -> void;
+
+  /**
+   * @brief Closes the allocation counts of the previous frame. Called once
+   * per frame by the App.
+   */
+  static auto begin_frame() -> void;
+
+  /**
+   * @brief The current counters, plus the heap budgets if the Allocator
+   * exists.
+   */
+  [[nodiscard]] static auto snapshot() -> MemorySnapshot;
+
+  [[nodiscard]] static auto to_json(const MemorySnapshot &) -> std::string;
+  /**
+   * @brief Writes to_json(snapshot()) to `path`. Returns false, after
+   * logging why, if the file could not be written.
+   */
+  static auto dump_json(const FS::Path &path) -> bool;
+
+private:
+  MemoryTelemetry() = default;
+};
+
+} // namespace Core
@@ -8,12 +8,13 @@
 
 #include <glm/glm.hpp>
 #include <span>
+#include <string>
 #include <vector>
 
 #include "core/Forward.hpp"
 
 struct aiMaterial;
-struct aiString;
+struct aiMesh;
 
 namespace Core {
 
@@ -46,6 +47,21 @@ struct Vertex {
   glm::vec3 bitangents{0.F};
 };
 
+/**
+ * @brief The resolved bindings of one material. Texture maps are paths
+ * relative to the mesh file, empty when the white texture is bound.
+ */
+struct MeshMaterial {
+  glm::vec4 albedo_colour{0.8F, 0.8F, 0.8F, 1.0F};
+  float emission{0.2F};
+  float metalness{0.0F};
+  float roughness{0.8F};
+  float use_normal_map{0.0F};
+  std::string albedo_map{};
+  std::string normal_map{};
+  std::string metallic_map{};
+};
+
 class Mesh {
 public:
   [[nodiscard]] auto get_submeshes() const -> const auto & {
@@ -56,6 +72,12 @@ public:
   }
   [[nodiscard]] auto get_materials_span() const -> std::span<Material *>;
   [[nodiscard]] auto get_material(u32 index) const -> Material *;
+  /**
+   * @brief Streamed textures the material of a submesh samples, for screen
+   * size hints to the TextureStreamer.
+   */
+  [[nodiscard]] auto get_streamed_textures(u32 submesh_index) const
+      -> std::span<const Texture *const>;
   [[nodiscard]] auto has_material(u32 index) const -> bool {
     return materials.size() > index;
   }
@@ -70,6 +92,10 @@ public:
   [[nodiscard]] constexpr auto casts_shadows() const -> bool {
     return is_shadow_caster;
   }
+  /**
+   * @brief Process-unique id, used to group draws of the same mesh.
+   */
+  [[nodiscard]] auto get_id() const -> u32 { return id; }
 
   static auto import_from(const Device &device, const FS::Path &file_path)
       -> Scope<Mesh>;
@@ -78,6 +104,7 @@ private:
   Mesh(const Device &device, const FS::Path &);
   const Device *device;
   const FS::Path file_path;
+  u32 id{0};
 
   std::vector<Vertex> vertices;
   std::vector<Index> indices;
@@ -91,26 +118,35 @@ private:
   std::vector<u32> submesh_indices;
 
   Scope<Shader> default_shader;
-  std::unordered_map<std::string, Scope<Texture>> mesh_owned_textures;
+  std::unordered_map<std::string, Ref<Texture>> mesh_owned_textures;
+  // Per material, the entries of mesh_owned_textures it samples
+  std::vector<std::vector<const Texture *>> material_textures;
 
   AABB bounding_box;
 
-  [[nodiscard]] auto
-  read_texture_from_file_path(const std::string &texture_path) const
-      -> Scope<Texture>;
-  void handle_normal_map(const Texture &white_texture,
-                         const aiMaterial *ai_material,
-                         Material &submesh_material, aiString ai_tex_path);
-  void handle_roughness_map(const Texture &white_texture,
-                            const aiMaterial *ai_material,
-                            Material &submesh_material, aiString ai_tex_path,
-                            float roughness);
-  void handle_metalness_map(const Texture &white_texture,
-                            const aiMaterial *ai_material,
-                            Material &submesh_material, float metalness);
-  void handle_albedo_map(const Texture &white_texture,
-                         const aiMaterial *ai_material,
-                         Material &submesh_material, aiString ai_tex_path);
+  [[nodiscard]] auto resolve_texture_path(const std::string &texture_path) const
+      -> FS::Path;
+  /**
+   * @brief Reads the file with Assimp into the vertex, index and submesh
+   * arrays. Fills one description per material.
+   */
+  auto import_with_assimp(std::vector<MeshMaterial> &) -> bool;
+  auto create_buffers(std::span<const Vertex>, std::span<const Index>)
+      -> void;
+  /**
+   * @brief Writes the vertices and indices of one submesh into its own range
+   * of the mesh arrays. Safe to run for several submeshes at once.
+   */
+  auto convert_submesh(const aiMesh &, Submesh &) -> void;
+  [[nodiscard]] auto describe_material(const aiMaterial &) const
+      -> MeshMaterial;
+  /**
+   * @brief Streams every texture the materials reference into
+   * mesh_owned_textures. They are usable right away and sharpen as the
+   * TextureStreamer uploads their larger levels.
+   */
+  auto stream_textures(std::span<const MeshMaterial>) -> void;
+  auto bind_material(const MeshMaterial &) -> Ref<Material>;
 
   struct Deleter {
     auto operator()(ImporterImpl *pimpl) -> void;
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Filesystem.hpp"
+#include "MappedFile.hpp"
+#include "Mesh.hpp"
+#include "Types.hpp"
+
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Core {
+
+/**
+ * @brief On-disk cache of the processed geometry and material bindings of a
+ * Mesh, so warm starts skip Assimp entirely.
+ *
+ * Entries live in FS::mesh_cache, one file per source model. Every entry
+ * records the key it was built for, derived from the source file contents,
+ * the import flags and the format version, so stale entries are rebuilt
+ * automatically.
+ */
+class MeshCache {
+public:
+  static constexpr u32 version = 1;
+
+  struct Contents {
+    // Both point into the mapped cache file
+    std::span<const Vertex> vertices{};
+    std::span<const Index> indices{};
+    std::vector<Submesh> submeshes{};
+    std::vector<MeshMaterial> materials{};
+
+    std::unique_ptr<MappedFile> file{};
+  };
+
+  [[nodiscard]] static auto key_for(const FS::Path &source, u32 import_flags)
+      -> std::optional<u64>;
+  [[nodiscard]] static auto load(const FS::Path &source, u64 key)
+      -> std::optional<Contents>;
+  static auto store(const FS::Path &source, u64 key,
+                    std::span<const Vertex> vertices,
+                    std::span<const Index> indices,
+                    std::span<const Submesh> submeshes,
+                    std::span<const MeshMaterial> materials) -> bool;
+
+private:
+  static auto path_for(const FS::Path &source) -> FS::Path;
+};
+
+} // namespace Core
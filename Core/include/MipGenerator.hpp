@@ -0,0 +1,94 @@
+#pragma once
+
+#include "CommandBuffer.hpp"
+#include "DescriptorResource.hpp"
+#include "Types.hpp"
+
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "core/Forward.hpp"
+
+namespace Core {
+
+/**
+ * @brief Builds the mip chains of uploaded textures, owned by the device.
+ *
+ * 8-bit RGBA textures are reduced by one compute dispatch, which writes up to
+ * `max_compute_mips` levels from level 0 in a single pass. Every other format
+ * falls back to a chain of linear blits. Like the StagingUploader, requests
+ * outside of a batch are executed immediately, while requests inside a batch
+ * are recorded into one submission with a single wait when the outermost
+ * batch ends.
+ */
+class MipGenerator {
+public:
+  static constexpr u32 max_compute_mips = 12;
+
+  ~MipGenerator();
+
+  class Batch {
+  public:
+    explicit Batch(MipGenerator &);
+    ~Batch();
+
+    Batch(const Batch &) = delete;
+    auto operator=(const Batch &) -> Batch & = delete;
+
+  private:
+    MipGenerator *generator{nullptr};
+  };
+
+  [[nodiscard]] auto batch() -> Batch { return Batch{*this}; }
+
+  /**
+   * @brief Generates every level below level 0 of `image`, whose levels must
+   * all be in TRANSFER_DST_OPTIMAL, usually after a staging upload. The image
+   * ends up in its properties' layout and must outlive the batch.
+   */
+  auto enqueue(const Image &image) -> void;
+
+  /**
+   * @brief Flushes pending staging uploads, then submits every enqueued
+   * image and waits for them.
+   */
+  auto flush() -> void;
+
+  /**
+   * @brief True if images with these properties get their mips from the
+   * compute path, which needs them to be created with storage usage.
+   */
+  [[nodiscard]] static auto supports_compute(const Device &,
+                                             const ImageProperties &) -> bool;
+
+  static auto construct(const Device &) -> Scope<MipGenerator>;
+
+private:
+  explicit MipGenerator(const Device &);
+
+  const Device *device{nullptr};
+  Scope<Shader> shader;
+  Scope<Pipeline> pipeline;
+  VkSampler sampler{nullptr};
+  // One atomic per image of a submission, reset by the shader after use
+  Scope<Buffer> counters;
+  u32 counter_capacity{0};
+
+  Scope<CommandBuffer> command_buffer;
+  std::vector<const Image *> pending{};
+  u32 batch_depth{0};
+
+  // Freed once the submission that uses them has completed
+  std::vector<VkImageView> transient_views{};
+  std::vector<PersistentDescriptorSet> transient_sets{};
+
+  auto end_batch() -> void;
+  auto reserve_counters(u32 count) -> void;
+  auto record_compute(VkCommandBuffer, const Image &, u32 counter_index)
+      -> void;
+  auto record_blits(VkCommandBuffer, const Image &) const -> void;
+  [[nodiscard]] auto create_level_view(const Image &, u32 level, VkFormat,
+                                       VkImageUsageFlags) -> VkImageView;
+};
+
+} // namespace Core
@@ -10,11 +10,6 @@
 
 namespace Core {
 
-namespace PipelineHelpers {
-[[nodiscard]] auto try_load_pipeline_cache(const std::string &name)
-    -> std::vector<u8>;
-}
-
 enum class PipelineBindPoint : std::uint8_t {
   BindPointGraphics = 0,
   BindPointCompute = 1,
@@ -173,7 +168,6 @@ private:
   std::string name{};
   VkPipelineBindPoint bind_point{VK_PIPELINE_BIND_POINT_COMPUTE};
   VkPipelineLayout pipeline_layout{};
-  VkPipelineCache pipeline_cache{};
   VkPipeline pipeline{};
 };
 
@@ -229,7 +223,6 @@ private:
   std::string name{};
   VkPipelineBindPoint bind_point{VK_PIPELINE_BIND_POINT_GRAPHICS};
   VkPipelineLayout pipeline_layout{};
-  VkPipelineCache pipeline_cache{};
   VkPipeline pipeline{};
 };
 
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Filesystem.hpp"
+#include "Types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <span>
+#include <string_view>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "core/Forward.hpp"
+
+namespace Core {
+
+/**
+ * @brief The one VkPipelineCache of a device, shared by every pipeline.
+ *
+ * Loaded once from disk when the device is created. Blobs written by another
+ * driver or GPU are detected from their VkPipelineCacheHeaderVersionOne and
+ * discarded, since drivers are allowed to reject them only late, or not at
+ * all. The cache is written back atomically every
+ * Config::pipeline_cache_save_interval seconds while pipelines are being
+ * created, and once more on destruction.
+ */
+class PipelineCache {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  ~PipelineCache();
+
+  [[nodiscard]] auto get_cache() const -> VkPipelineCache { return cache; }
+  /**
+   * @brief True if a compatible blob was loaded, so pipelines created in this
+   * run are expected to be cache hits.
+   */
+  [[nodiscard]] auto is_warm() const -> bool { return warm; }
+
+  /**
+   * @brief Logs how long a pipeline took to create and marks the cache as
+   * changed. Safe to call from any thread.
+   */
+  auto record_creation(std::string_view name, Clock::duration elapsed)
+      -> void;
+
+  /**
+   * @brief Writes the cache if it changed and the save interval has passed.
+   * Cheap enough to call once per frame.
+   */
+  auto save_if_due() -> void;
+  /**
+   * @brief Writes the cache to a temporary file and renames it over the
+   * previous one.
+   */
+  auto save() -> bool;
+
+  /**
+   * @brief Checks a blob's header against the device it is about to be
+   * given to.
+   */
+  [[nodiscard]] static auto
+  is_compatible(std::span<const u8> blob,
+                const VkPhysicalDeviceProperties &properties) -> bool;
+
+  static auto construct(const Device &) -> Scope<PipelineCache>;
+
+private:
+  explicit PipelineCache(const Device &);
+
+  const Device *device{nullptr};
+  VkPipelineCache cache{nullptr};
+  FS::Path path{};
+  bool warm{false};
+
+  std::mutex save_mutex{};
+  std::atomic<bool> dirty{false};
+  Clock::time_point last_save{};
+
+  std::atomic<u32> created_count{0};
+  std::atomic<u64> created_microseconds{0};
+
+  [[nodiscard]] auto load_compatible(const FS::Path &,
+                                     const VkPhysicalDeviceProperties &) const
+      -> std::vector<u8>;
+  auto merge_legacy_caches(const VkPhysicalDeviceProperties &) -> void;
+};
+
+} // namespace Core
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Pipeline.hpp"
+#include "Types.hpp"
+
+#include <future>
+
+#include "core/Forward.hpp"
+
+namespace Core {
+
+/**
+ * @brief Builds pipelines on the JobSystem.
+ *
+ * Pipeline creation only reads the device, the shaders and the framebuffer,
+ * and the device-wide PipelineCache is internally synchronised, so several
+ * pipelines can compile at once while the caller loads meshes and textures.
+ * Everything the configuration points to must outlive the returned future.
+ * Exceptions thrown while compiling are rethrown by `get`.
+ */
+class PipelineCompiler {
+public:
+  [[nodiscard]] static auto compile(const Device &,
+                                    PipelineConfiguration configuration)
+      -> std::future<Scope<Pipeline>>;
+  [[nodiscard]] static auto compile(const Device &,
+                                    GraphicsPipelineConfiguration configuration)
+      -> std::future<Scope<GraphicsPipeline>>;
+
+private:
+  PipelineCompiler() = default;
+};
+
+} // namespace Core
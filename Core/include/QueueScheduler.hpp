@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CommandBuffer.hpp"
+#include "Device.hpp"
+#include "GpuFuture.hpp"
+#include "Image.hpp"
+#include "Types.hpp"
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+namespace Core {
+
+/**
+ * @brief Image handed from a producing queue to a consuming queue.
+ */
+struct ImageHandoff {
+  const Image *image{nullptr};
+  VkImageLayout layout{VK_IMAGE_LAYOUT_GENERAL};
+  VkAccessFlags source_access{VK_ACCESS_SHADER_WRITE_BIT};
+  VkPipelineStageFlags source_stage{VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+  VkAccessFlags destination_access{VK_ACCESS_SHADER_READ_BIT};
+  VkPipelineStageFlags destination_stage{
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+};
+
+/**
+ * @brief Frame-graph-lite scheduling of work across the graphics and compute
+ * queues.
+ *
+ * Producers record the release half of a queue family ownership transfer
+ * with `release` and submit through the scheduler. Their futures become
+ * semaphore waits for the next submission on the consuming queue, which
+ * records the matching acquires with `acquire_pending` first. Dependencies
+ * are consumed once, so they must be re-registered every frame.
+ */
+class QueueScheduler {
+public:
+  ~QueueScheduler() = default;
+
+  auto release(const CommandBuffer &producer, Queue::Type consumer,
+               const ImageHandoff &) -> void;
+  auto acquire_pending(const CommandBuffer &consumer) -> void;
+
+  /**
+   * @brief Submits without blocking, waiting on every dependency registered
+   * for the queue of `command_buffer` and on `waits`.
+   */
+  auto submit(CommandBuffer &command_buffer,
+              std::span<const SubmitWait> waits = {}) -> GpuFuture;
+
+  /**
+   * @brief Handoffs released for `consumer` that it has not acquired yet.
+   */
+  [[nodiscard]] auto get_pending_handoff_count(Queue::Type consumer) const
+      -> usize;
+  /**
+   * @brief Producer submissions the next submission on `consumer` waits on.
+   */
+  [[nodiscard]] auto get_pending_wait_count(Queue::Type consumer) const
+      -> usize;
+
+  static auto construct(const Device &) -> Scope<QueueScheduler>;
+
+private:
+  explicit QueueScheduler(const Device &);
+
+  struct PendingHandoff {
+    Queue::Type producer{Queue::Type::Unknown};
+    ImageHandoff handoff{};
+  };
+
+  const Device *device{nullptr};
+  std::unordered_map<Queue::Type, std::vector<PendingHandoff>> handoffs{};
+  std::unordered_map<Queue::Type, std::vector<SubmitWait>> waits{};
+  std::unordered_map<Queue::Type, VkPipelineStageFlags> produced_for{};
+
+  [[nodiscard]] auto family_of(Queue::Type) const -> u32;
+};
+
+} // namespace Core
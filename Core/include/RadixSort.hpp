@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <vector>
+
+namespace Core {
+
+/**
+ * @brief Stable LSD radix sort on a 64-bit key, one byte per pass. Passes in
+ * which every key has the same byte are skipped, so keys which only use
+ * their low bits cost a fraction of a full sort.
+ *
+ * `scratch` is resized to `items.size()` and can be kept between calls to
+ * avoid allocating.
+ */
+template <class T, class KeyFunction>
+auto radix_sort(std::vector<T> &items, std::vector<T> &scratch,
+                KeyFunction &&key_of) -> void {
+  static constexpr u32 bucket_count = 256;
+  static constexpr u32 pass_count = sizeof(u64);
+
+  const auto size = items.size();
+  if (size < 2) {
+    return;
+  }
+  scratch.resize(size);
+
+  auto *source = &items;
+  auto *destination = &scratch;
+  std::array<usize, bucket_count> offsets{};
+  for (u32 pass = 0; pass < pass_count; ++pass) {
+    const auto shift = pass * 8;
+    offsets.fill(0);
+    for (const auto &item : *source) {
+      ++offsets[(key_of(item) >> shift) & 0xFF];
+    }
+
+    // Every key has the same byte, nothing would move
+    if (std::ranges::find(offsets, size) != offsets.end()) {
+      continue;
+    }
+
+    usize running = 0;
+    for (auto &offset : offsets) {
+      const auto count = offset;
+      offset = running;
+      running += count;
+    }
+    for (const auto &item : *source) {
+      (*destination)[offsets[(key_of(item) >> shift) & 0xFF]++] = item;
+    }
+    std::swap(source, destination);
+  }
+
+  if (source != &items) {
+    items.swap(scratch);
+  }
+}
+
+} // namespace Core
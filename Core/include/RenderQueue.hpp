@@ -0,0 +1,97 @@
+#pragma once
+
+#include "RadixSort.hpp"
+#include "Types.hpp"
+
+#include <span>
+#include <vector>
+
+namespace Core {
+
+/**
+ * @brief Orders the draws of one pass so that draws sharing state are
+ * adjacent.
+ *
+ * Draws are sorted on a packed key, most significant first: pipeline (8
+ * bits), material (20 bits), mesh (20 bits) and submesh (16 bits). Ids wider
+ * than their field wrap around, which only affects grouping, never
+ * correctness. The queue also counts the binds its users skip, so the effect
+ * of the ordering is visible per frame.
+ */
+class RenderQueue {
+public:
+  struct Entry {
+    u64 key{0};
+    // Index of the draw in the caller's storage
+    u32 index{0};
+  };
+
+  struct Statistics {
+    u32 draws{0};
+    u32 binds{0};
+    u32 elided_binds{0};
+
+    /**
+     * @brief Records whether a bind was issued or skipped because the same
+     * state was already bound.
+     */
+    auto count_bind(bool elided) -> void { ++(elided ? elided_binds : binds); }
+    auto count_draw() -> void { ++draws; }
+
+    auto operator+=(const Statistics &other) -> Statistics & {
+      draws += other.draws;
+      binds += other.binds;
+      elided_binds += other.elided_binds;
+      return *this;
+    }
+  };
+
+  [[nodiscard]] static constexpr auto make_key(u32 pipeline, u32 material,
+                                               u32 mesh, u32 submesh) -> u64 {
+    return (static_cast<u64>(pipeline & 0xFF) << 56) |
+           (static_cast<u64>(material & 0xFFFFF) << 36) |
+           (static_cast<u64>(mesh & 0xFFFFF) << 16) |
+           static_cast<u64>(submesh & 0xFFFF);
+  }
+
+  auto push(u64 key, u32 index) -> void { entries.push_back({key, index}); }
+
+  /**
+   * @brief Sorts the pushed draws. Draws with equal keys keep their
+   * submission order.
+   */
+  auto sort() -> void {
+    radix_sort(entries, scratch, [](const Entry &entry) { return entry.key; });
+  }
+
+  [[nodiscard]] auto get_entries() const -> std::span<const Entry> {
+    return entries;
+  }
+
+  /**
+   * @brief Adds the counts of one recorded range of this queue. Ranges can be
+   * recorded on different threads, each into its own Statistics.
+   */
+  auto add_statistics(const Statistics &recorded) -> void {
+    statistics += recorded;
+  }
+  [[nodiscard]] auto get_statistics() const -> const Statistics & {
+    return statistics;
+  }
+  [[nodiscard]] auto size() const -> usize { return entries.size(); }
+
+  /**
+   * @brief Empties the queue and its statistics, keeping the capacity.
+   */
+  auto clear() -> void {
+    entries.clear();
+    statistics = {};
+  }
+
+private:
+  std::vector<Entry> entries{};
+  std::vector<Entry> scratch{};
+  Statistics statistics{};
+};
+
+} // namespace Core
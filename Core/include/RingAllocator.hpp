@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Types.hpp"
+
+#include <deque>
+#include <optional>
+
+namespace Core {
+
+/**
+ * @brief Hands out regions of a fixed-size ring in FIFO order. Every region
+ * is tagged with the batch it was recorded in and is recycled by `retire`
+ * once that batch has completed.
+ */
+class RingAllocator {
+public:
+  explicit RingAllocator(u64 ring_capacity) : capacity(ring_capacity) {}
+
+  /**
+   * @return the offset of the region, or nullopt if the ring has no room
+   * until older batches retire.
+   */
+  [[nodiscard]] auto allocate(u64 size, u64 alignment, u64 batch)
+      -> std::optional<u64> {
+    if (size == 0 || size > capacity) {
+      return std::nullopt;
+    }
+
+    if (regions.empty()) {
+      regions.push_back({0, size, batch});
+      return 0;
+    }
+
+    const auto &front = regions.front();
+    const auto &back = regions.back();
+    const auto tail = front.offset;
+    const auto head = align_up(back.offset + back.size, alignment);
+    const auto wrapped = back.offset < front.offset;
+
+    std::optional<u64> offset{};
+    if (!wrapped) {
+      if (head + size <= capacity) {
+        offset = head;
+      } else if (size <= tail) {
+        offset = 0;
+      }
+    } else if (head + size <= tail) {
+      offset = head;
+    }
+
+    if (offset) {
+      regions.push_back({*offset, size, batch});
+    }
+    return offset;
+  }
+
+  /**
+   * @brief Recycles every region recorded in `batch` or earlier.
+   */
+  auto retire(u64 batch) -> void {
+    while (!regions.empty() && regions.front().batch <= batch) {
+      regions.pop_front();
+    }
+  }
+
+  [[nodiscard]] auto empty() const -> bool { return regions.empty(); }
+  [[nodiscard]] auto get_capacity() const -> u64 { return capacity; }
+
+private:
+  struct Region {
+    u64 offset{0};
+    u64 size{0};
+    u64 batch{0};
+  };
+
+  u64 capacity{0};
+  std::deque<Region> regions{};
+
+  static constexpr auto align_up(u64 value, u64 alignment) -> u64 {
+    if (alignment <= 1) {
+      return value;
+    }
+    return (value + alignment - 1) / alignment * alignment;
+  }
+};
+
+} // namespace Core
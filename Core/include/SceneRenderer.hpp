@@ -2,39 +2,19 @@
 
 #include "BufferSet.hpp"
 #include "Destructors.hpp"
+#include "DrawList.hpp"
 #include "Framebuffer.hpp"
 #include "Material.hpp"
 #include "Mesh.hpp"
 #include "Pipeline.hpp"
+#include "RenderQueue.hpp"
 #include "Swapchain.hpp"
 
 #include <functional>
 
 namespace Core {
-struct CommandKey;
-}
-
-template <> struct std::hash<Core::CommandKey> {
-  auto operator()(const Core::CommandKey &key) const noexcept -> Core::usize;
-}; // namespace std
-
-namespace Core {
-
-struct CommandKey {
-  const Mesh *mesh_ptr{nullptr};
-  u32 submesh_index{0};
-
-  auto operator<=>(const CommandKey &) const = default;
-};
 
 class SceneRenderer {
-  struct DrawCommand {
-    const Mesh *mesh_ptr{};
-    u32 submesh_index{0};
-    std::vector<glm::mat4> transforms_and_instances{};
-    Material *material{};
-  };
-
   struct RendererUBO {
     glm::mat4 view;
     glm::mat4 projection;
@@ -66,14 +46,48 @@ class SceneRenderer {
     float default_value = 0.1F;
   };
 
+  struct CullingUBO {
+    // 0-5 camera frustum, 6-11 shadow frustum
+    std::array<glm::vec4, 12> planes{};
+    // x packed instances, y draws
+    glm::uvec4 instance_count{0};
+  };
+
+  struct DrawCullData {
+    glm::vec4 aabb_min;
+    glm::vec4 aabb_max;
+    u32 frustum_index{0};
+    u32 instance_offset{0};
+    u32 batch_index{0};
+    // First command of the batch in the compacted command buffer
+    u32 batch_offset{0};
+  };
+
+  /**
+   * @brief Consecutive draws of a pass sharing material and mesh, so one
+   * indirect draw covers all of them.
+   */
+  struct IndirectBatch {
+    u32 first_command{0};
+    u32 command_count{0};
+  };
+
+  // Set 0 bindings rewritten every frame: the renderer, shadow, grid and
+  // culling uniforms and both transform buffers. They live in transient
+  // frame arena ranges and are bound with dynamic offsets.
+  static constexpr std::array<u32, 6> frame_bindings{0, 1, 2, 3, 4, 5};
+
+  // The shadow pass packs its instances after the geometry pass region
+  static constexpr u32 max_instances = 2 * Config::transform_buffer_size;
   struct TransformData {
-    std::array<glm::mat4, Config::transform_buffer_size> transforms{};
+    std::array<glm::mat4, max_instances> transforms{};
   };
   static constexpr auto size = sizeof(TransformData);
   TransformData transform_data;
   RendererUBO renderer_ubo{};
   ShadowUBO shadow_ubo{};
   GridUBO grid_ubo{};
+  CullingUBO culling_ubo{};
   DepthParameters depth_factor{};
 
   Scope<BufferSet<Buffer::Type::Uniform>> ubos;
@@ -93,8 +107,13 @@ public:
   };
 
   auto destroy(const Device &device) -> void;
-  auto begin_renderpass(const CommandBuffer &buffer,
-                        const Framebuffer &framebuffer) -> void;
+  /**
+   * @brief With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the viewport
+   * and scissor must be set by the secondary buffers instead.
+   */
+  auto begin_renderpass(
+      const CommandBuffer &buffer, const Framebuffer &framebuffer,
+      VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) -> void;
 
   /**
    * @brief Does a full renderpass (begins + ends) which clears!
@@ -133,6 +152,47 @@ public:
   auto get_sun_position() -> auto & { return sun_position; }
   auto get_depth_factors() -> auto & { return depth_factor; }
 
+  /**
+   * @brief Culls instances on the GPU, compacts the visible draws, and
+   * issues one vkCmdDrawIndexedIndirectCount per batch of draws sharing a
+   * material and mesh. Ignored if the device does not support indirect draw
+   * counts. Starts as Config::gpu_driven_rendering, so the CPU path is the
+   * default.
+   */
+  auto set_gpu_driven(bool enabled) -> void {
+    gpu_driven = enabled && supports_gpu_driven;
+  }
+  [[nodiscard]] auto is_gpu_driven() const -> bool { return gpu_driven; }
+
+  /**
+   * @brief Draws and issued/elided binds of the last flushed frame.
+   */
+  [[nodiscard]] auto get_geometry_statistics() const
+      -> const RenderQueue::Statistics & {
+    return geometry_queue.get_statistics();
+  }
+  [[nodiscard]] auto get_shadow_statistics() const
+      -> const RenderQueue::Statistics & {
+    return shadow_queue.get_statistics();
+  }
+
+  /**
+   * @brief True if geometry materials sample the device's global texture
+   * array, with indices in their push constants, instead of binding a
+   * per-material sampler set. Fixed by device support.
+   */
+  [[nodiscard]] auto is_bindless() const -> bool {
+    return geometry_shader && geometry_shader->uses_bindless_textures();
+  }
+
+  /**
+   * @brief The shader used for meshes in the geometry pass, the bindless
+   * variant if the device supports it. Mesh materials must be created from
+   * a compatible shader.
+   */
+  [[nodiscard]] static auto construct_geometry_shader(const Device &)
+      -> Scope<Shader>;
+
   [[nodiscard]] static auto get_white_texture() -> const Texture & {
     return *white_texture;
   }
@@ -142,6 +202,7 @@ public:
 
 private:
   Extent<u32> extent{};
+  TextureStreamer *texture_streamer{nullptr};
 
   Scope<GraphicsPipeline> geometry_pipeline;
   Scope<Framebuffer> geometry_framebuffer;
@@ -158,6 +219,22 @@ private:
   Scope<Material> grid_material;
   Scope<Mesh> grid_mesh;
 
+  Scope<Shader> cull_shader;
+  Scope<Pipeline> cull_pipeline;
+  Scope<Material> cull_material;
+  Scope<Shader> compact_shader;
+  Scope<Pipeline> compact_pipeline;
+  Scope<Material> compact_material;
+  bool supports_gpu_driven{false};
+  bool gpu_driven{false};
+  u32 packed_instance_count{0};
+  std::vector<u32> instance_draw_indices;
+  std::vector<DrawCullData> draw_cull_data;
+  // Per draw, in queue order, before culling and compaction
+  std::vector<VkDrawIndexedIndirectCommand> draw_commands;
+  std::vector<IndirectBatch> indirect_batches;
+  std::vector<u32> batch_counts;
+
   static inline Scope<Texture> white_texture;
   static inline Scope<Texture> black_texture;
   Scope<Texture> disarray_texture;
@@ -177,28 +254,84 @@ private:
   };
   PipelineAndHash bound_pipeline{};
 
-  std::unordered_map<CommandKey, DrawCommand> draw_commands;
-  std::unordered_map<CommandKey, DrawCommand> shadow_draw_commands;
+  // Uniform and storage buffer writes per shader and buffer set pair
+  std::unordered_map<usize, std::vector<std::vector<VkWriteDescriptorSet>>>
+      combined_write_descriptors;
+  // Scratch for the dynamic offsets of the material being updated
+  std::vector<u32> dynamic_offsets;
+
+  DrawList draw_list;
+  DrawList shadow_draw_list;
+
+  // Sorted draw order per pass, indexing into the draw lists
+  RenderQueue geometry_queue;
+  RenderQueue shadow_queue;
+
+  enum class Pass : u8 { Shadow, Geometry };
+
+  // Passes with fewer draws are recorded inline into the primary buffer.
+  // Larger ones are split into chunks recorded on the JobSystem.
+  static constexpr u32 parallel_draw_threshold = 512;
+  static constexpr u32 minimum_draws_per_chunk = 128;
+  static constexpr u32 chunk_slots = 8;
+  // Secondary buffers per pass and chunk, each with one per frame in flight
+  std::array<std::vector<Scope<CommandBuffer>>, 2> secondary_command_buffers;
+
+  // What the pass being recorded has bound, so repeated binds are skipped
+  struct BoundState {
+    const Material *material{nullptr};
+    const Buffer *vertex_buffer{nullptr};
+    const Buffer *index_buffer{nullptr};
+  };
 
   [[nodiscard]] auto is_already_bound(const GraphicsPipeline &pipeline) const
       -> bool {
     return pipeline.hash() == bound_pipeline.hash;
   }
 
-  auto shadow_pass(const CommandBuffer &, u32) -> void;
-  auto grid_pass(const CommandBuffer &, u32) -> void;
-  auto geometry_pass(const CommandBuffer &, u32) -> void;
+  /**
+   * @brief Packs every submitted instance transform into the transform
+   * buffer for this frame, with one write. Each command gets its offset in
+   * first_instance. Runs after the queues are built, as indirect commands
+   * are laid out in queue order.
+   */
+  auto upload_transforms(u32) -> void;
+  /**
+   * @brief Hints the projected size of every geometry draw to the streamer
+   * of the textures it samples. Runs after the transforms are packed.
+   */
+  auto hint_streamed_textures() -> void;
+  /**
+   * @brief Lays out the indirect commands of one pass in queue order and
+   * splits them into batches.
+   */
+  auto build_indirect_batches(DrawList &, const RenderQueue &,
+                              u32 frustum_index) -> void;
+  static auto build_queue(RenderQueue &, const DrawList &,
+                          const GraphicsPipeline &) -> void;
+  auto bind_mesh_buffers(const CommandBuffer &, RenderQueue::Statistics &,
+                         const Mesh &, BoundState &) -> void;
+  auto cull_pass(const CommandBuffer &, u32) -> void;
+  auto draw_indirect(const CommandBuffer &, u32 frame, u32 batch_index)
+      -> void;
+
+  /**
+   * @brief Writes the descriptor sets of every material in the pass. Runs on
+   * the recording thread, so chunks only read material state.
+   */
+  auto prepare_materials(Pass, u32 frame) -> void;
+  /**
+   * @brief Records one pass, inline or split over secondary buffers.
+   */
+  auto record_pass(const CommandBuffer &, u32 frame, Pass) -> void;
+  /**
+   * @brief Records a sorted range of the pass. Safe to call concurrently for
+   * different ranges and command buffers, after prepare_materials.
+   */
+  auto record_draws(const CommandBuffer &, u32 frame, Pass,
+                    std::span<const RenderQueue::Entry>,
+                    RenderQueue::Statistics &) -> void;
+  auto record_grid(const CommandBuffer &, u32 frame) -> void;
 };
 
 } // namespace Core
-
-namespace std {
-
-inline auto
-hash<Core::CommandKey>::operator()(const Core::CommandKey &key) const noexcept
-    -> Core::usize {
-  return std::hash<const Core::Mesh *>()(key.mesh_ptr) ^
-         std::hash<Core::u32>()(key.submesh_index);
-}
-
-} // namespace std
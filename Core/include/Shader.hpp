@@ -3,7 +3,9 @@
 #include "Device.hpp"
 #include "Types.hpp"
 
+#include <algorithm>
 #include <filesystem>
+#include <span>
 #include <unordered_set>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_core.h>
@@ -50,19 +52,47 @@ public:
 
   [[nodiscard]] auto allocate_descriptor_set(u32 set) const
       -> Reflection::MaterialDescriptorSet;
+  /**
+   * @brief A set for `set` which survives DescriptorResource::begin_frame.
+   */
+  [[nodiscard]] auto allocate_persistent_descriptor_set(u32 set) const
+      -> PersistentDescriptorSet;
   [[nodiscard]] auto get_descriptor_set(std::string_view descriptor_name,
                                         std::uint32_t set) const
       -> const VkWriteDescriptorSet *;
 
+  /**
+   * @brief True if the shader reads the device's global texture array, bound
+   * at BindlessTextures::descriptor_set.
+   */
+  [[nodiscard]] auto uses_bindless_textures() const -> bool {
+    return bindless_textures;
+  }
+
+  /**
+   * @brief Set 0 buffer bindings declared as dynamic-offset descriptors, in
+   * ascending order, which is the order their offsets are bound in.
+   */
+  [[nodiscard]] auto get_dynamic_bindings() const -> std::span<const u32> {
+    return dynamic_bindings;
+  }
+  [[nodiscard]] auto is_dynamic_binding(u32 binding) const -> bool {
+    return std::ranges::binary_search(dynamic_bindings, binding);
+  }
+
   [[nodiscard]] auto hash() const -> usize;
   [[nodiscard]] auto has_descriptor_set(u32 set) const -> bool;
 
-  static auto construct(const Device &device, const std::filesystem::path &path)
-      -> Scope<Shader>;
+  /**
+   * @brief Set 0 buffers at `dynamic` bindings use dynamic-offset
+   * descriptors, for data that moves within a buffer every frame.
+   */
+  static auto construct(const Device &device, const std::filesystem::path &path,
+                        std::span<const u32> dynamic = {}) -> Scope<Shader>;
   static auto construct(const Device &device,
                         const std::filesystem::path &vertex_path,
-                        const std::filesystem::path &fragment_path)
-      -> Scope<Shader>;
+                        const std::filesystem::path &fragment_path,
+                        std::span<const u32> dynamic = {}) -> Scope<Shader>;
 
 private:
   struct PathShaderType {
@@ -85,7 +115,8 @@ private:
   };
   explicit Shader(
       const Device &device,
-      const std::unordered_set<PathShaderType, Hasher, std::equal_to<>> &);
+      const std::unordered_set<PathShaderType, Hasher, std::equal_to<>> &,
+      std::span<const u32> dynamic);
 
   const Device &device;
   std::string name{};
@@ -93,8 +124,14 @@ private:
   Reflection::ReflectionData reflection_data{};
   std::unordered_map<Type, VkShaderModule> shader_modules{};
   std::unordered_map<Type, std::string> parsed_spirv_per_stage{};
+  bool bindless_textures{false};
+  // Requested on construction, then only those the shader declares
+  std::vector<u32> dynamic_bindings{};
+  // Hashing the SPIR-V is too slow for the per-draw material cache lookups
+  usize cached_hash{0};
 
   void create_descriptor_set_layouts();
+  [[nodiscard]] auto compute_hash() const -> usize;
 };
 
 } // namespace Core
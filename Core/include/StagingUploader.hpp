@@ -0,0 +1,109 @@
+#pragma once
+
+#include "CommandBuffer.hpp"
+#include "Device.hpp"
+#include "GpuFuture.hpp"
+#include "RingAllocator.hpp"
+#include "Types.hpp"
+
+#include <deque>
+#include <span>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "core/Forward.hpp"
+
+namespace Core {
+
+struct StagingBufferImpl;
+
+/**
+ * @brief Persistently mapped staging ring owned by the device.
+ *
+ * Uploads are copied into the ring and recorded into one transfer
+ * submission. Outside of a batch every upload is flushed immediately;
+ * inside a batch they are submitted together when the outermost batch ends.
+ * Submissions are not waited on. Their ring regions are recycled once they
+ * have signalled, and the CPU only blocks when the ring has no room left.
+ * Uploads are visible to graphics work submitted after the flush.
+ */
+class StagingUploader {
+public:
+  ~StagingUploader();
+
+  class Batch {
+  public:
+    explicit Batch(StagingUploader &);
+    ~Batch();
+
+    Batch(const Batch &) = delete;
+    auto operator=(const Batch &) -> Batch & = delete;
+
+  private:
+    StagingUploader *uploader{nullptr};
+  };
+
+  [[nodiscard]] auto batch() -> Batch { return Batch{*this}; }
+
+  auto upload(VkBuffer destination, std::span<const u8> data,
+              u64 destination_offset = 0) -> void;
+
+  /**
+   * @brief Copies `data` into `image`. The buffer offsets of `regions` are
+   * relative to the start of `data`. The image ends up in `final_layout`.
+   */
+  auto upload(const Image &image, std::span<const u8> data,
+              std::span<const VkBufferImageCopy> regions,
+              VkImageLayout final_layout) -> void;
+
+  /**
+   * @brief Submits everything recorded so far without waiting for it. Work
+   * on queues other than graphics must wait on the returned future.
+   */
+  auto flush() -> GpuFuture;
+
+  static auto construct(const Device &) -> Scope<StagingUploader>;
+
+private:
+  explicit StagingUploader(const Device &);
+
+  const Device *device{nullptr};
+  Queue::Type transfer_queue{Queue::Type::Transfer};
+  bool needs_ownership_transfer{false};
+
+  // Command buffer slots, so recording a batch does not wait on the last
+  static constexpr u32 command_slots = 4;
+
+  struct InFlightBatch {
+    u64 id{0};
+    GpuFuture future{};
+    std::vector<Scope<StagingBufferImpl>> oversized_buffers{};
+  };
+
+  Scope<StagingBufferImpl> ring_buffer;
+  RingAllocator ring;
+  std::vector<Scope<StagingBufferImpl>> oversized_buffers{};
+  // Submitted batches, oldest first
+  std::deque<InFlightBatch> in_flight{};
+
+  Scope<CommandBuffer> transfer_command_buffer;
+  Scope<CommandBuffer> acquire_command_buffer;
+  bool is_recording{false};
+  u32 batch_depth{0};
+  u64 batch_id{1};
+
+  std::vector<VkBufferMemoryBarrier> buffer_acquires{};
+  std::vector<VkImageMemoryBarrier> image_acquires{};
+
+  auto begin_recording() -> void;
+  auto end_batch() -> void;
+  /**
+   * @brief Recycles the ring regions of every batch that has signalled.
+   */
+  auto retire_completed() -> void;
+  auto wait_for_oldest() -> void;
+  [[nodiscard]] auto stage(std::span<const u8> data, u64 alignment)
+      -> std::pair<VkBuffer, u64>;
+};
+
+} // namespace Core
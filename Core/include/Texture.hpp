@@ -5,6 +5,8 @@
 #include "Filesystem.hpp"
 #include "Image.hpp"
 #include "ImageProperties.hpp"
+#include "Ktx2.hpp"
+#include "TextureCompressor.hpp"
 
 namespace Core {
 
@@ -61,16 +63,41 @@ public:
       -> Scope<Texture>;
   static auto construct_storage(const Device &, const TextureProperties &)
       -> Scope<Texture>;
+  /**
+   * @brief `.ktx2` paths upload their stored mip chain without decoding, in
+   * which case the format and extent of `properties` come from the file and
+   * no CPU copy is kept.
+   */
   static auto construct_shader(const Device &, const TextureProperties &)
       -> Scope<Texture>;
   static auto construct(const Device &, const FS::Path &) -> Scope<Texture>;
   static auto construct_from_buffer(const Device &, const TextureProperties &,
                                     DataBuffer &&) -> Scope<Texture>;
+  /**
+   * @brief Uploads pre-encoded blocks and their mip chain as is. The format
+   * and extent of `properties` are taken from `compressed`.
+   */
+  static auto construct_compressed(const Device &, const TextureProperties &,
+                                   CompressedTexture &&) -> Scope<Texture>;
 
 private:
   Texture(const Device &, const TextureProperties &);
   Texture(const Device &, usize, const Extent<u32> &);
   Texture(const Device &, const TextureProperties &, DataBuffer &&);
+  Texture(const Device &, const TextureProperties &, CompressedTexture &&);
+  Texture(const Device &, const TextureProperties &, std::span<const u8> file,
+          const Ktx2Layout &);
+
+  static auto construct_ktx2(const Device &, const TextureProperties &)
+      -> Scope<Texture>;
+
+  /**
+   * @brief Swaps in a new image for a streamed texture and returns the old
+   * one, which frames in flight may still sample.
+   */
+  auto replace_image(Scope<Image> replacement, ImageFormat format,
+                     const Extent<u32> &full_extent, usize resident_size)
+      -> Scope<Image>;
 
   const Device *device{nullptr};
   TextureProperties properties;
@@ -80,6 +107,29 @@ private:
   bool storage{false};
 
   Scope<Image> image{nullptr};
+
+  friend class TextureStreamer;
+};
+
+/**
+ * @brief Staged constructor for GenericCache: files are decoded on a worker
+ * and only uploaded on the main thread. KTX2 files are not decoded at all.
+ */
+struct TextureCacheConstructor {
+  using Type = Texture;
+  using Properties = TextureProperties;
+
+  struct Decoded {
+    DataBuffer pixels{};
+    Extent<u32> extent{};
+  };
+
+  static auto decode(const TextureProperties &) -> Decoded;
+  static auto construct(const Device &, const TextureProperties &, Decoded &&)
+      -> Scope<Texture>;
+
+private:
+  TextureCacheConstructor() = default;
 };
 
 } // namespace Core
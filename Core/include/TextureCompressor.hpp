@@ -0,0 +1,76 @@
+#pragma once
+
+#include "DataBuffer.hpp"
+#include "Filesystem.hpp"
+#include "ImageProperties.hpp"
+#include "Types.hpp"
+
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace Core {
+
+struct CompressedTexture {
+  ImageFormat format{ImageFormat::Undefined};
+  Extent<u32> extent{};
+  // Every mip level back to back, largest first
+  DataBuffer data{};
+  std::vector<u64> level_offsets{};
+};
+
+/**
+ * @brief CPU transcoder from RGBA8 texels to BC1, BC3, BC5 or BC7 blocks,
+ * including the mip chain.
+ *
+ * Endpoints are fitted along the principal axis of each block, and BC7 only
+ * uses mode 6, which trades some quality for a simple, fast encoder. Results
+ * are kept in FS::texture_cache, one file per content hash of the source
+ * file, target format and level count, so every texture is transcoded once.
+ */
+class TextureCompressor {
+public:
+  static constexpr u32 version = 1;
+
+  /**
+   * @brief Loads `source` from the cache, or decodes, transcodes and caches
+   * it. Returns nullopt if the file cannot be decoded.
+   */
+  [[nodiscard]] static auto load_or_compress(const FS::Path &source,
+                                             ImageFormat format,
+                                             bool generate_mips)
+      -> std::optional<CompressedTexture>;
+
+  /**
+   * @brief Downsamples `rgba` into `level_count` levels and encodes each.
+   * 8-bit RGBA formats keep the texels as they are, which only builds the
+   * chain.
+   */
+  [[nodiscard]] static auto compress(std::span<const u8> rgba,
+                                     const Extent<u32> &extent,
+                                     ImageFormat format, u32 level_count)
+      -> CompressedTexture;
+
+  /**
+   * @brief Encodes 4x4 RGBA8 texels, row by row, into one block of
+   * block_size(format) bytes.
+   */
+  static auto encode_block(ImageFormat format, std::span<const u8, 64> texels,
+                           std::span<u8> block) -> void;
+
+  [[nodiscard]] static auto full_level_count(const Extent<u32> &) -> u32;
+  /**
+   * @brief Bytes of one level, for block compressed and 8-bit RGBA formats.
+   */
+  [[nodiscard]] static auto level_size(ImageFormat, const Extent<u32> &,
+                                       u32 level) -> u64;
+
+private:
+  TextureCompressor() = default;
+
+  static auto load(u64 key, ImageFormat format)
+      -> std::optional<CompressedTexture>;
+  static auto store(u64 key, const CompressedTexture &) -> bool;
+};
+
+} // namespace Core
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "Config.hpp"
+#include "GpuFuture.hpp"
+#include "JobSystem.hpp"
+#include "Texture.hpp"
+#include "TextureCompressor.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <functional>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "core/Forward.hpp"
+
+namespace Core {
+
+/**
+ * @brief Streams the mip chains of textures within a fixed VRAM budget,
+ * owned by the device.
+ *
+ * A streamed texture starts out as one white texel and is usable right away.
+ * Once its chain has been decoded on the JobSystem, the levels no larger than
+ * Config::texture_streaming_base_extent are uploaded, and update() swaps in
+ * larger levels one at a time, highest priority first, until the texture
+ * reaches the level its hints ask for. Textures over budget drop levels
+ * again, lowest priority first, but never their base levels. Every step
+ * moves the texture into a new image: levels that stay resident are copied on
+ * the GPU and only new levels are uploaded. The old image is kept alive for
+ * Config::frame_count frames. The decoded chain is only kept while it has
+ * levels left to upload, so textures that become fully resident or drop
+ * levels free it and are decoded again once they want larger levels. Main
+ * thread only, like the staging uploader.
+ */
+class TextureStreamer {
+public:
+  /**
+   * @brief Produces the complete chain of a texture, largest level first,
+   * or nullopt to keep the placeholder. Runs on a worker.
+   */
+  using Decoder = std::function<std::optional<CompressedTexture>()>;
+
+  ~TextureStreamer();
+
+  [[nodiscard]] auto stream(const TextureProperties &, Decoder decode)
+      -> Ref<Texture>;
+
+  /**
+   * @brief Priority of `texture` for the next update, higher streams first.
+   * Textures without a hint have priority zero.
+   */
+  auto hint(const Texture &texture, floating priority) -> void;
+  /**
+   * @brief Hints the on-screen size of `texture` as its priority, and skips
+   * levels larger than that size.
+   */
+  auto hint_screen_extent(const Texture &texture, const Extent<u32> &extent)
+      -> void;
+
+  /**
+   * @brief Frees images retired Config::frame_count frames ago, then moves
+   * residency towards the hints of the last frame. Called once per frame,
+   * after the fence of the frame being recorded has been waited on.
+   */
+  auto update() -> void;
+
+  [[nodiscard]] auto get_budget() const -> u64 { return budget; }
+  [[nodiscard]] auto get_resident_bytes() const -> u64 {
+    return resident_bytes;
+  }
+  [[nodiscard]] auto get_streamed_count() const -> usize {
+    return entries.size();
+  }
+
+  static auto construct(const Device &,
+                        u64 budget_bytes = Config::texture_streaming_budget)
+      -> Scope<TextureStreamer>;
+
+private:
+  TextureStreamer(const Device &, u64 budget_bytes);
+
+  struct Entry {
+    u64 id{0};
+    const Texture *key{nullptr};
+    std::weak_ptr<Texture> texture{};
+    TextureProperties properties{};
+    Decoder decode{};
+    // Only held while levels are left to upload
+    std::optional<CompressedTexture> source{};
+    bool decoding{false};
+    ImageFormat format{ImageFormat::Undefined};
+    Extent<u32> extent{};
+    // Zero until the first decode
+    u32 level_count{0};
+    // Largest level that is never dropped
+    u32 base_level{0};
+    // Largest resident level, level_count while only the placeholder is
+    u32 resident_level{0};
+    // Largest level the screen hints of the last frame need, all if unset
+    std::optional<u32> wanted_level{};
+    floating priority{0.0F};
+    u64 resident_bytes{0};
+    // Not upgraded again in the frame it gave up levels
+    u64 dropped_in_frame{0};
+  };
+
+  const Device *device{nullptr};
+  u64 budget{0};
+  u64 resident_bytes{0};
+  u64 frame{0};
+  u64 next_id{1};
+  bool stopping{false};
+
+  // Levels kept by a step, copied from the old image into the new one
+  struct LevelCopy {
+    const Image *source{nullptr};
+    const Image *destination{nullptr};
+    u32 source_level{0};
+    u32 destination_level{0};
+    u32 level_count{0};
+    // The new levels were staged into the destination first
+    bool uploaded{false};
+  };
+
+  std::unordered_map<const Texture *, Entry> entries{};
+  std::vector<JobHandle> decodes{};
+  std::array<std::vector<Scope<Image>>, Config::frame_count> retired{};
+  std::vector<LevelCopy> pending_copies{};
+  std::array<GpuFuture, Config::frame_count> copies_submitted{};
+  // Destroyed first, which waits for the device before the retired images go
+  Scope<CommandBuffer> copy_command_buffer;
+
+  auto request_decode(Entry &) -> void;
+  auto on_decoded(const Texture *key, u64 id,
+                  std::optional<CompressedTexture> &&source) -> void;
+  auto set_resident_level(Entry &, u32 level) -> void;
+  /**
+   * @brief Records the level copies of this update on the graphics queue,
+   * after the staging submission that uploaded their new levels.
+   */
+  auto submit_copies() -> void;
+  /**
+   * @brief Drops levels of `candidates`, from the back, until `bytes` more
+   * fit the budget.
+   */
+  auto make_room(std::span<Entry *const> candidates, u64 bytes) -> bool;
+  [[nodiscard]] auto levels_size(const Entry &, u32 level) const -> u64;
+};
+
+} // namespace Core
@@ -6,6 +6,7 @@ namespace Core {
 
 class Allocator;
 class BaseException;
+class BindlessTextures;
 class Buffer;
 class CommandBuffer;
 class CommandDispatcher;
@@ -14,16 +15,21 @@ class Device;
 class DynamicLibraryLoader;
 class Environment;
 class FileCouldNotBeOpened;
+class FrameAllocator;
 class InterfaceSystem;
 class Image;
 class Instance;
 class Logger;
 class Material;
+class MipGenerator;
 class Pipeline;
+class PipelineCache;
 class Window;
 class QueueUnknownException;
 class Shader;
+class StagingUploader;
 class Texture;
+class TextureStreamer;
 class Timer;
 class Swapchain;
 class VulkanResultException;
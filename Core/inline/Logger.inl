@@ -8,7 +8,7 @@ void Logger::trace(fmt::format_string<Args...> format,
                    Args &&...args) noexcept {
   if (current_level > LogLevel::Trace)
     return;
-  log(fmt::format(format, std::forward<Args>(args)...), LogLevel::Trace);
+  log(LogLevel::Trace, format, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
@@ -16,7 +16,7 @@ void Logger::debug(fmt::format_string<Args...> format,
                    Args &&...args) noexcept {
   if (current_level > LogLevel::Debug)
     return;
-  log(fmt::format(format, std::forward<Args>(args)...), LogLevel::Debug);
+  log(LogLevel::Debug, format, std::forward<Args>(args)...);
 }
 
 #else
@@ -34,18 +34,60 @@ template <typename... Args>
 void Logger::info(fmt::format_string<Args...> format, Args &&...args) noexcept {
   if (current_level > LogLevel::Info)
     return;
-  log(fmt::format(format, std::forward<Args>(args)...), LogLevel::Info);
+  log(LogLevel::Info, format, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 void Logger::warn(fmt::format_string<Args...> format, Args &&...args) noexcept {
-  log(fmt::format(format, std::forward<Args>(args)...), LogLevel::Warn);
+  log(LogLevel::Warn, format, std::forward<Args>(args)...);
 }
 
 template <typename... Args>
 void Logger::error(fmt::format_string<Args...> format,
                    Args &&...args) noexcept {
-  log(fmt::format(format, std::forward<Args>(args)...), LogLevel::Error);
+  log(LogLevel::Error, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void Logger::log(LogLevel level, fmt::format_string<Args...> format,
+                 Args &&...args) noexcept {
+  if (exit_flag) {
+    write_immediately(level, fmt::format(format, std::forward<Args>(args)...));
+    return;
+  }
+
+  const fmt::string_view format_view = format;
+  u64 position{0};
+  auto &record = claim(position);
+  record.level = level;
+  record.formatter = nullptr;
+
+  if constexpr ((Detail::DeferredLogArgument<Args> && ...)) {
+    const auto size = (usize{0} + ... + Detail::encoded_size(args));
+    if (size <= record_payload_size) {
+      auto *output = record.payload.data();
+      (Detail::encode(output, args), ...);
+      record.size = static_cast<u32>(size);
+      record.formatter = &Detail::format_log_record<Args...>;
+      record.format = {format_view.data(), format_view.size()};
+      publish(record, position);
+      return;
+    }
+  }
+
+  // Already checked at compile time, formatting never consumes the arguments
+  auto *text = reinterpret_cast<char *>(record.payload.data());
+  const auto result =
+      fmt::format_to_n(text, record_payload_size, fmt::runtime(format_view),
+                       std::forward<Args>(args)...);
+  if (result.size <= record_payload_size) {
+    record.size = static_cast<u32>(result.size);
+  } else {
+    record.size = 0;
+    record.overflow =
+        fmt::format(fmt::runtime(format_view), std::forward<Args>(args)...);
+  }
+  publish(record, position);
 }
 
 } // namespace Core
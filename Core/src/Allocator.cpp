@@ -15,7 +15,52 @@
 
 namespace Core {
 
-Allocator::Allocator(const std::string &resource) : resource_name(resource) {}
+namespace {
+
+struct AllocationTag {
+  std::string resource_name;
+  MemoryCategory category;
+  u64 size;
+};
+
+} // namespace
+
+Allocator::Allocator(const std::string &resource, MemoryCategory memory)
+    : resource_name(resource), category(memory) {}
+
+auto Allocator::tag(VmaAllocation allocation) -> void {
+  vmaSetAllocationName(allocator, allocation, resource_name.data());
+
+  VmaAllocationInfo allocation_info{};
+  vmaGetAllocationInfo(allocator, allocation, &allocation_info);
+  vmaSetAllocationUserData(allocator, allocation,
+                           new AllocationTag{
+                               .resource_name = resource_name,
+                               .category = category,
+                               .size = allocation_info.size,
+                           });
+  MemoryTelemetry::record_allocation(category, resource_name,
+                                     allocation_info.size);
+}
+
+auto Allocator::untag(VmaAllocation allocation) -> void {
+  if (allocation == nullptr) {
+    return;
+  }
+
+  VmaAllocationInfo allocation_info{};
+  vmaGetAllocationInfo(allocator, allocation, &allocation_info);
+  const auto *allocation_tag =
+      static_cast<AllocationTag *>(allocation_info.pUserData);
+  if (allocation_tag == nullptr) {
+    return;
+  }
+  MemoryTelemetry::record_free(allocation_tag->category,
+                               allocation_tag->resource_name,
+                               allocation_tag->size);
+  vmaSetAllocationUserData(allocator, allocation, nullptr);
+  delete allocation_tag;
+}
 
 auto Allocator::allocate_buffer(VkBuffer &buffer,
                                 VkBufferCreateInfo &buffer_info,
@@ -25,12 +70,13 @@ auto Allocator::allocate_buffer(VkBuffer &buffer,
   VmaAllocationCreateInfo alloc_info = {};
   alloc_info.usage = static_cast<VmaMemoryUsage>(props.usage);
   alloc_info.flags = static_cast<VmaAllocationCreateFlags>(props.creation);
+  alloc_info.pool = props.pool;
 
   VmaAllocation allocation{};
   verify(vmaCreateBuffer(allocator, &buffer_info, &alloc_info, &buffer,
                          &allocation, nullptr),
          "vmaCreateBuffer", "Failed to create buffer");
-  vmaSetAllocationName(allocator, allocation, resource_name.data());
+  tag(allocation);
 
   return allocation;
 }
@@ -45,12 +91,13 @@ auto Allocator::allocate_buffer(VkBuffer &buffer,
   alloc_info.usage = static_cast<VmaMemoryUsage>(props.usage);
   alloc_info.flags = static_cast<VmaAllocationCreateFlags>(props.creation) |
                      VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
+  alloc_info.pool = props.pool;
 
   VmaAllocation allocation{};
   verify(vmaCreateBuffer(allocator, &buffer_info, &alloc_info, &buffer,
                          &allocation, &allocation_info),
          "vmaCreateBuffer", "Failed to create buffer");
-  vmaSetAllocationName(allocator, allocation, resource_name.data());
+  tag(allocation);
 
   return allocation;
 }
@@ -67,7 +114,7 @@ auto Allocator::allocate_image(VkImage &image,
   verify(vmaCreateImage(allocator, &image_create_info, &allocation_create_info,
                         &image, &allocation, nullptr),
          "vmaCreateImage", "Failed to create image");
-  vmaSetAllocationName(allocator, allocation, resource_name.data());
+  tag(allocation);
 
   return allocation;
 }
@@ -85,18 +132,20 @@ auto Allocator::allocate_image(VkImage &image,
   verify(vmaCreateImage(allocator, &image_create_info, &allocation_create_info,
                         &image, &allocation, &allocation_info),
          "vmaCreateImage", "Failed to create image");
-  vmaSetAllocationName(allocator, allocation, resource_name.data());
+  tag(allocation);
 
   return allocation;
 }
 
 void Allocator::deallocate_buffer(VmaAllocation allocation, VkBuffer &buffer) {
   ensure(allocator != nullptr, "Allocator was null.");
+  untag(allocation);
   vmaDestroyBuffer(allocator, buffer, allocation);
 }
 
 void Allocator::deallocate_image(VmaAllocation allocation, VkImage &image) {
   ensure(allocator != nullptr, "Allocator was null.");
+  untag(allocation);
   vmaDestroyImage(allocator, image, allocation);
 }
 
@@ -110,6 +159,12 @@ auto Allocator::construct_allocator(const Device &device,
   allocator_create_info.physicalDevice = device.get_physical_device();
   allocator_create_info.device = device.get_device();
   allocator_create_info.instance = instance.get_instance();
+  // Every selected device supports 1.2, which VMA needs for the budgets
+  allocator_create_info.vulkanApiVersion = VK_API_VERSION_1_2;
+  if (device.check_support(Feature::MemoryBudget)) {
+    allocator_create_info.flags |=
+        VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+  }
 
   VmaAllocator alloc{};
   verify(vmaCreateAllocator(&allocator_create_info, &alloc),
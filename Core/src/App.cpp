@@ -3,11 +3,19 @@
 #include "App.hpp"
 
 #include "Allocator.hpp"
+#include "BindlessTextures.hpp"
 #include "Config.hpp"
 #include "DescriptorResource.hpp"
 #include "Formatters.hpp"
+#include "FrameAllocator.hpp"
 #include "InterfaceSystem.hpp"
+#include "JobSystem.hpp"
 #include "Logger.hpp"
+#include "MemoryTelemetry.hpp"
+#include "MipGenerator.hpp"
+#include "PipelineCache.hpp"
+#include "StagingUploader.hpp"
+#include "TextureStreamer.hpp"
 #include "UI.hpp"
 
 #include <cstddef>
@@ -23,6 +31,9 @@ auto AppDeleter::operator()(App *app) const noexcept -> void {
 }
 
 App::App(const ApplicationProperties &props) : properties(props) {
+  JobSystem::initialise();
+  info("Job system running on {} workers", JobSystem::worker_count());
+
   // Initialize the instance
   instance = Instance::construct(properties.headless);
 
@@ -50,6 +61,10 @@ App::App(const ApplicationProperties &props) : properties(props) {
 }
 
 App::~App() {
+  device->destroy_texture_streamer();
+  device->destroy_mip_generator();
+  device->destroy_staging_uploader();
+  device->destroy_frame_allocator();
   Allocator::destroy();
   swapchain.reset();
   window.reset();
@@ -67,7 +82,11 @@ auto App::run() -> void {
   Scope<InterfaceSystem> interface_system =
       make_scope<InterfaceSystem>(*device, *window, *swapchain);
 
-  on_create();
+  {
+    // Textures loaded during creation share one mip submission
+    auto mips = device->get_mip_generator().batch();
+    on_create();
+  }
 
   auto last_time = now();
   const auto total_time = last_time;
@@ -89,14 +108,28 @@ auto App::run() -> void {
     }
 
     device->get_descriptor_resource()->begin_frame(swapchain->current_frame());
+    MemoryTelemetry::begin_frame();
+    device->get_frame_allocator().begin_frame(swapchain->current_frame());
+    if (auto *bindless = device->get_bindless_textures(); bindless != nullptr) {
+      bindless->begin_frame(swapchain->current_frame());
+    }
     const auto current_time = now();
 
     const auto delta_time_seconds =
         std::chrono::duration<floating>(current_time - last_time).count();
 
-    on_update(delta_time_seconds);
-
     {
+      // Textures loaded this frame, including those finished by main-thread
+      // jobs, get their mips before it is submitted
+      auto mips = device->get_mip_generator().batch();
+      {
+        // Finished loads and streaming steps share one staging submission
+        auto uploads = device->get_staging_uploader().batch();
+        JobSystem::run_main_thread_jobs();
+        device->get_texture_streamer().update();
+      }
+      on_update(delta_time_seconds);
+
       interface_system->begin_frame();
       on_interface(*interface_system);
       interface_system->end_frame();
@@ -112,6 +145,8 @@ auto App::run() -> void {
 
     device->get_descriptor_resource()->end_frame();
     swapchain->present();
+
+    device->get_pipeline_cache().save_if_due();
   }
 
   vkDeviceWaitIdle(device->get_device());
@@ -0,0 +1,184 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "BindlessTextures.hpp"
+
+#include "Config.hpp"
+#include "Device.hpp"
+#include "Image.hpp"
+#include "Logger.hpp"
+#include "Verify.hpp"
+
+#include <algorithm>
+#include <vulkan/vulkan_core.h>
+
+namespace Core {
+
+class BindlessCapacityException : public BaseException {
+public:
+  using BaseException::BaseException;
+};
+
+BindlessTextures::BindlessTextures(const Device &dev) : device(&dev) {
+  VkPhysicalDeviceDescriptorIndexingProperties indexing_properties{
+      .sType =
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES,
+  };
+  VkPhysicalDeviceProperties2 properties{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+      .pNext = &indexing_properties,
+  };
+  vkGetPhysicalDeviceProperties2(device->get_physical_device(), &properties);
+
+  capacity = std::min({
+      Config::bindless_texture_count,
+      indexing_properties.maxDescriptorSetUpdateAfterBindSampledImages,
+      indexing_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+      indexing_properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+  });
+
+  const VkDescriptorPoolSize pool_size{
+      .type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .descriptorCount = capacity,
+  };
+  const VkDescriptorPoolCreateInfo pool_info{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+      .maxSets = 1,
+      .poolSizeCount = 1,
+      .pPoolSizes = &pool_size,
+  };
+  verify(vkCreateDescriptorPool(device->get_device(), &pool_info, nullptr,
+                                &pool),
+         "vkCreateDescriptorPool", "Failed to create bindless descriptor pool");
+
+  const VkDescriptorSetLayoutBinding layout_binding{
+      .binding = binding,
+      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .descriptorCount = capacity,
+      .stageFlags = VK_SHADER_STAGE_ALL,
+      .pImmutableSamplers = nullptr,
+  };
+  const VkDescriptorBindingFlags binding_flags =
+      VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+      VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+      VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+  const VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info{
+      .sType =
+          VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+      .bindingCount = 1,
+      .pBindingFlags = &binding_flags,
+  };
+  const VkDescriptorSetLayoutCreateInfo layout_info{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .pNext = &binding_flags_info,
+      .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+      .bindingCount = 1,
+      .pBindings = &layout_binding,
+  };
+  verify(vkCreateDescriptorSetLayout(device->get_device(), &layout_info,
+                                     nullptr, &layout),
+         "vkCreateDescriptorSetLayout",
+         "Failed to create bindless descriptor set layout");
+
+  const VkDescriptorSetAllocateInfo allocation_info{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .descriptorPool = pool,
+      .descriptorSetCount = 1,
+      .pSetLayouts = &layout,
+  };
+  verify(vkAllocateDescriptorSets(device->get_device(), &allocation_info,
+                                  &descriptor_set_handle),
+         "vkAllocateDescriptorSets", "Failed to allocate bindless set");
+
+  info("Created bindless texture table with {} slots", capacity);
+}
+
+BindlessTextures::~BindlessTextures() {
+  vkDestroyDescriptorSetLayout(device->get_device(), layout, nullptr);
+  vkDestroyDescriptorPool(device->get_device(), pool, nullptr);
+}
+
+auto BindlessTextures::index_of(const Image &image) -> u32 {
+  const auto &image_info = image.get_descriptor_info();
+
+  if (auto it = slots.find(image_info.imageView); it != slots.end()) {
+    auto &slot = it->second;
+    if (slot.sampler == image_info.sampler &&
+        slot.layout == image_info.imageLayout) {
+      return slot.index;
+    }
+    // Frames in flight may still sample the old descriptor, so it is retired
+    // like a released slot instead of being rewritten in place
+    const auto index = acquire_index();
+    retired_indices.at(current_frame).push_back(slot.index);
+    slot = {
+        .index = index,
+        .sampler = image_info.sampler,
+        .layout = image_info.imageLayout,
+    };
+    write(index, image_info);
+    return index;
+  }
+
+  const auto index = acquire_index();
+  slots.try_emplace(image_info.imageView,
+                    Slot{
+                        .index = index,
+                        .sampler = image_info.sampler,
+                        .layout = image_info.imageLayout,
+                    });
+  write(index, image_info);
+  return index;
+}
+
+auto BindlessTextures::acquire_index() -> u32 {
+  if (!free_indices.empty()) {
+    const auto index = free_indices.back();
+    free_indices.pop_back();
+    return index;
+  }
+  if (next_index >= capacity) {
+    error("Bindless texture table is full ({} slots)", capacity);
+    throw BindlessCapacityException("Bindless texture table is full");
+  }
+  return next_index++;
+}
+
+auto BindlessTextures::release(VkImageView view) -> void {
+  if (auto it = slots.find(view); it != slots.end()) {
+    // Frames already submitted may still sample through this slot
+    retired_indices.at(current_frame).push_back(it->second.index);
+    slots.erase(it);
+  }
+}
+
+auto BindlessTextures::begin_frame(u32 frame) -> void {
+  ensure(frame < Config::frame_count, "Frame index {} out of range", frame);
+  current_frame = frame;
+
+  auto &retired = retired_indices.at(frame);
+  free_indices.insert(free_indices.end(), retired.begin(), retired.end());
+  retired.clear();
+}
+
+auto BindlessTextures::write(u32 index,
+                             const VkDescriptorImageInfo &image_info) const
+    -> void {
+  const VkWriteDescriptorSet write_set{
+      .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .dstSet = descriptor_set_handle,
+      .dstBinding = binding,
+      .dstArrayElement = index,
+      .descriptorCount = 1,
+      .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .pImageInfo = &image_info,
+  };
+  vkUpdateDescriptorSets(device->get_device(), 1, &write_set, 0, nullptr);
+}
+
+auto BindlessTextures::construct(const Device &device)
+    -> Scope<BindlessTextures> {
+  return Scope<BindlessTextures>{new BindlessTextures(device)};
+}
+
+} // namespace Core
@@ -5,6 +5,8 @@
 #include "Allocator.hpp"
 #include "DebugMarker.hpp"
 #include "Device.hpp"
+#include "FrameAllocator.hpp"
+#include "StagingUploader.hpp"
 #include "Verify.hpp"
 
 #include <cassert>
@@ -14,22 +16,45 @@
 
 namespace Core {
 
-static auto to_vulkan_usage(Buffer::Type buffer_type) -> VkBufferUsageFlags {
+static auto to_vulkan_usage(Buffer::Type buffer_type, Buffer::Role role)
+    -> VkBufferUsageFlags {
+  // Every buffer can be the destination of a staged upload
+  static constexpr VkBufferUsageFlags transfer =
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  const VkBufferUsageFlags indirect =
+      role == Buffer::Role::IndirectArguments
+          ? VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT
+          : VkBufferUsageFlags{0};
   switch (buffer_type) {
   case Buffer::Type::Vertex:
-    return VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    return VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | transfer;
   case Buffer::Type::Index:
-    return VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    return VK_BUFFER_USAGE_INDEX_BUFFER_BIT | transfer;
   case Buffer::Type::Uniform:
-    return VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    return VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | transfer;
   case Buffer::Type::Storage:
-    return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    return VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | indirect | transfer;
   default:
     return VK_BUFFER_USAGE_FLAG_BITS_MAX_ENUM;
     assert(false);
   }
 }
 
+static auto to_memory_category(Buffer::Type buffer_type) -> MemoryCategory {
+  switch (buffer_type) {
+  case Buffer::Type::Vertex:
+    return MemoryCategory::Vertex;
+  case Buffer::Type::Index:
+    return MemoryCategory::Index;
+  case Buffer::Type::Uniform:
+    return MemoryCategory::Uniform;
+  case Buffer::Type::Storage:
+    return MemoryCategory::Storage;
+  default:
+    return MemoryCategory::Other;
+  }
+}
+
 struct BufferDataImpl {
   VkBuffer buffer{};
   VmaAllocation allocation{};
@@ -37,21 +62,85 @@ struct BufferDataImpl {
 };
 
 Buffer::Buffer(const Device &dev, u64 input_size, Type buffer_type,
-               u32 input_binding)
+               u32 input_binding, Mode buffer_mode, Role buffer_role,
+               std::string_view name)
     : device(&dev), buffer_data(make_scope<BufferDataImpl>()), size(input_size),
-      type(buffer_type), binding(input_binding) {
+      type(buffer_type), mode(buffer_mode), role(buffer_role),
+      binding(input_binding),
+      debug_name(name.empty() ? fmt::format("{} Buffer", buffer_type)
+                              : std::string{name}) {
   initialise_vulkan_buffer();
   initialise_descriptor_info();
 }
 
 auto Buffer::construct(const Device &device, u64 input_size, Type buffer_type,
-                       u32 binding) -> Scope<Buffer> {
-  return make_scope<Buffer>(device, input_size, buffer_type, binding);
+                       u32 binding, Mode mode, Role role,
+                       std::string_view name) -> Scope<Buffer> {
+  return make_scope<Buffer>(device, input_size, buffer_type, binding, mode,
+                            role, name);
+}
+
+auto Buffer::construct(const Device &device, u64 input_size, Type buffer_type,
+                       std::string_view name) -> Scope<Buffer> {
+  return make_scope<Buffer>(device, input_size, buffer_type, invalid_binding,
+                            Mode::Dynamic, Role::Data, name);
 }
 
-auto Buffer::construct(const Device &device, u64 input_size, Type buffer_type)
+Buffer::Buffer(const Device &dev, const FrameAllocation &range,
+               Type buffer_type, u32 input_binding)
+    : device(&dev), buffer_data(make_scope<BufferDataImpl>()),
+      size(range.size), type(buffer_type), binding(input_binding),
+      arena_frame(range.frame) {
+  buffer_data->buffer = range.buffer;
+  buffer_data->allocation_info.pMappedData = range.mapped;
+  descriptor_info = {
+      .buffer = range.buffer,
+      .offset = range.offset,
+      .range = range.size,
+  };
+}
+
+auto Buffer::construct(const Device &device, const FrameAllocation &range,
+                       Type buffer_type, u32 binding) -> Scope<Buffer> {
+  return make_scope<Buffer>(device, range, buffer_type, binding);
+}
+
+Buffer::Buffer(const Device &dev, u64 input_size, Type buffer_type,
+               u32 input_binding, u32 frame)
+    : device(&dev), buffer_data(make_scope<BufferDataImpl>()),
+      size(input_size), type(buffer_type), binding(input_binding),
+      arena_frame(frame), transient(true) {
+  const auto arena = device->get_frame_allocator().get_arena(frame);
+  ensure(size <= arena.size, "Transient buffer of {} bytes exceeds the arena",
+         size);
+  buffer_data->buffer = arena.buffer;
+  buffer_data->allocation_info.pMappedData = arena.mapped;
+  descriptor_info = {
+      .buffer = arena.buffer,
+      .offset = 0,
+      .range = size,
+  };
+}
+
+auto Buffer::construct_transient(const Device &device, u64 input_size,
+                                 Type buffer_type, u32 binding, u32 frame)
     -> Scope<Buffer> {
-  return make_scope<Buffer>(device, input_size, buffer_type, invalid_binding);
+  return Scope<Buffer>{
+      new Buffer(device, input_size, buffer_type, binding, frame)};
+}
+
+auto Buffer::reserve() -> void {
+  auto &frame_allocator = device->get_frame_allocator();
+  if (!transient || reserved_in_frame == frame_allocator.get_frame_counter()) {
+    return;
+  }
+
+  const auto range = frame_allocator.allocate_transient(size, type);
+  ensure(range.frame == *arena_frame,
+         "Transient buffer of frame {} written in frame {}", *arena_frame,
+         range.frame);
+  dynamic_offset = static_cast<u32>(range.offset);
+  reserved_in_frame = frame_allocator.get_frame_counter();
 }
 
 auto Buffer::initialise_descriptor_info() -> void {
@@ -82,16 +171,41 @@ void Buffer::initialise_vulkan_buffer() {
 
   DebugMarker::set_object_name(*device, buffer_data->buffer,
                                VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT,
-                               fmt::format("Buffer-{}", type).data());
+                               debug_name.c_str());
+}
+
+void Buffer::initialise_static_buffer() {
+  Allocator allocator{debug_name, to_memory_category(type)};
+
+  VkBufferCreateInfo buffer_create_info{};
+  buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+  buffer_create_info.size = get_size();
+  buffer_create_info.usage = to_vulkan_usage(type, role);
+
+  // No host access flags, so VMA is free to pick memory the CPU cannot see.
+  // Writes then go through the staging uploader.
+  buffer_data->allocation = allocator.allocate_buffer(
+      buffer_data->buffer, buffer_create_info,
+      {
+          .usage = Usage::AUTO_PREFER_DEVICE,
+          .creation = Creation{},
+      });
+  vmaGetAllocationInfo(Allocator::get_allocator(), buffer_data->allocation,
+                       &buffer_data->allocation_info);
 }
 
 void Buffer::initialise_vertex_buffer() {
-  Allocator allocator{"Vertex Buffer"};
+  if (mode == Mode::Static) {
+    initialise_static_buffer();
+    return;
+  }
+
+  Allocator allocator{debug_name, MemoryCategory::Vertex};
 
   VkBufferCreateInfo buffer_create_info{};
   buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   buffer_create_info.size = get_size();
-  buffer_create_info.usage = to_vulkan_usage(type);
+  buffer_create_info.usage = to_vulkan_usage(type, role);
 
   const auto is_vertex = type == Buffer::Type::Vertex;
 
@@ -110,12 +224,17 @@ void Buffer::initialise_vertex_buffer() {
 }
 
 void Buffer::initialise_index_buffer() {
-  Allocator allocator{"Index Buffer"};
+  if (mode == Mode::Static) {
+    initialise_static_buffer();
+    return;
+  }
+
+  Allocator allocator{debug_name, MemoryCategory::Index};
 
   VkBufferCreateInfo buffer_create_info{};
   buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   buffer_create_info.size = get_size();
-  buffer_create_info.usage = to_vulkan_usage(type);
+  buffer_create_info.usage = to_vulkan_usage(type, role);
 
   const auto is_index = type == Buffer::Type::Index;
 
@@ -134,12 +253,12 @@ void Buffer::initialise_index_buffer() {
 }
 
 void Buffer::initialise_uniform_buffer() {
-  Allocator allocator{"Uniform Buffer"};
+  Allocator allocator{debug_name, MemoryCategory::Uniform};
 
   VkBufferCreateInfo buffer_create_info{};
   buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   buffer_create_info.size = get_size();
-  buffer_create_info.usage = to_vulkan_usage(type);
+  buffer_create_info.usage = to_vulkan_usage(type, role);
 
   const auto is_uniform = type == Buffer::Type::Uniform;
 
@@ -158,12 +277,12 @@ void Buffer::initialise_uniform_buffer() {
 }
 
 void Buffer::initialise_storage_buffer() {
-  Allocator allocator{"Storage Buffer"};
+  Allocator allocator{debug_name, MemoryCategory::Storage};
 
   VkBufferCreateInfo buffer_create_info{};
   buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   buffer_create_info.size = get_size();
-  buffer_create_info.usage = to_vulkan_usage(type);
+  buffer_create_info.usage = to_vulkan_usage(type, role);
 
   const auto is_uniform = type == Buffer::Type::Uniform;
 
@@ -192,7 +311,7 @@ auto Buffer::read_raw(size_t offset, size_t data_size) -> std::vector<char> {
     std::memcpy(
         data.data(),
         static_cast<const char *>(buffer_data->allocation_info.pMappedData) +
-            offset,
+            dynamic_offset + offset,
         data_size);
   } else {
     // Otherwise, map the buffer, copy the data, then unmap
@@ -208,7 +327,19 @@ auto Buffer::read_raw(size_t offset, size_t data_size) -> std::vector<char> {
 }
 
 Buffer::~Buffer() {
-  Allocator allocator{"Buffer"};
+  // Transient ranges are reset with their frame
+  if (transient) {
+    return;
+  }
+  if (arena_frame.has_value()) {
+    device->get_frame_allocator().release({
+        .offset = descriptor_info.offset,
+        .frame = *arena_frame,
+    });
+    return;
+  }
+
+  Allocator allocator{debug_name, to_memory_category(type)};
   allocator.deallocate_buffer(buffer_data->allocation, buffer_data->buffer);
   debug("Destroyed Buffer (type: {})", type);
 }
@@ -217,9 +348,35 @@ auto Buffer::get_buffer() const noexcept -> VkBuffer {
   return buffer_data->buffer;
 }
 
+auto Buffer::is_host_visible() const -> bool {
+  if (buffer_data->allocation_info.pMappedData != nullptr) {
+    return true;
+  }
+
+  VkMemoryPropertyFlags memory_properties{};
+  vmaGetAllocationMemoryProperties(Allocator::get_allocator(),
+                                   buffer_data->allocation, &memory_properties);
+  return (memory_properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
 void Buffer::write(const void *data, u64 data_size) {
   assert(data_size <= size); // Ensure we don't write out of bounds
 
+  if (transient) {
+    reserve();
+    std::memcpy(static_cast<u8 *>(buffer_data->allocation_info.pMappedData) +
+                    dynamic_offset,
+                data, data_size);
+    return;
+  }
+
+  if (!is_host_visible()) {
+    device->get_staging_uploader().upload(
+        buffer_data->buffer,
+        std::span{static_cast<const u8 *>(data), data_size});
+    return;
+  }
+
   const auto is_always_mapped = buffer_data->allocation_info.pMappedData;
   if (is_always_mapped) {
     std::memcpy(buffer_data->allocation_info.pMappedData, data, data_size);
@@ -235,6 +392,14 @@ void Buffer::write(const void *data, u64 data_size) {
 
 void Buffer::write(const void *data, u64 data_size) const {
   assert(data_size <= size); // Ensure we don't write out of bounds
+  ensure(!transient, "Transient buffers take their range on a non-const write");
+
+  if (!is_host_visible()) {
+    device->get_staging_uploader().upload(
+        buffer_data->buffer,
+        std::span{static_cast<const u8 *>(data), data_size});
+    return;
+  }
 
   const auto is_always_mapped = buffer_data->allocation_info.pMappedData;
   if (is_always_mapped) {
@@ -83,15 +83,18 @@ CommandBuffer::CommandBuffer(const Device &dev, CommandBufferProperties props)
            "vkAllocateCommandBuffers", "Failed to allocate command buffers");
   }
 
-  VkFenceCreateInfo fence_info{};
-  fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-  fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
-  for (auto i = 0U; i < properties.count; ++i) {
-    verify(vkCreateFence(device.get_device(), &fence_info, nullptr,
-                         &command_buffers[i].fence),
-           "vkCreateFence", "Failed to create fence");
-  }
+  VkSemaphoreTypeCreateInfo timeline_type_info{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+      .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+      .initialValue = timeline_value,
+  };
+  VkSemaphoreCreateInfo timeline_info{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+      .pNext = &timeline_type_info,
+  };
+  verify(vkCreateSemaphore(device.get_device(), &timeline_info, nullptr,
+                           &timeline),
+         "vkCreateSemaphore", "Failed to create timeline semaphore");
 
   // Create semaphores
   VkSemaphoreCreateInfo semaphore_info{};
@@ -116,9 +119,7 @@ CommandBuffer::~CommandBuffer() {
 
   vkDestroyCommandPool(device.get_device(), command_pool, nullptr);
 
-  for (const auto &command_buffer : command_buffers) {
-    vkDestroyFence(device.get_device(), command_buffer.fence, nullptr);
-  }
+  vkDestroySemaphore(device.get_device(), timeline, nullptr);
 
   // Destroy semaphores
   for (const auto &command_buffer : command_buffers) {
@@ -144,11 +145,14 @@ auto CommandBuffer::begin(u32 current_frame,
   active_pool = &query_pools.at(current_frame);
   active_frame = &command_buffers.at(current_frame);
 
+  // The previous submission of this frame must retire before re-recording
+  wait_for(*active_frame);
+  if (active_frame->has_pending_timestamps) {
+    collect_timestamps(*active_frame, *active_pool);
+  }
+
   verify(vkBeginCommandBuffer(get_command_buffer(), &begin_info),
          "vkBeginCommandBuffer", "Failed to begin recording command buffer");
-  verify(vkWaitForFences(device.get_device(), 1, &active_frame->fence, VK_TRUE,
-                         timeout),
-         "vkWaitForFences", "Failed to wait for fence");
   if (supports_device_query) {
     vkCmdResetQueryPool(get_command_buffer(), *active_pool, 0, 2);
     vkCmdWriteTimestamp(get_command_buffer(),
@@ -156,54 +160,91 @@ auto CommandBuffer::begin(u32 current_frame,
   }
 }
 
-auto CommandBuffer::submit() -> void {
+auto CommandBuffer::submit_async(std::span<const SubmitWait> waits)
+    -> GpuFuture {
+  const auto signal_value = ++timeline_value;
+
+  std::vector<VkSemaphore> wait_semaphores;
+  std::vector<u64> wait_values;
+  std::vector<VkPipelineStageFlags> wait_stages;
+  for (const auto &[future, stage] : waits) {
+    // Default constructed futures are already complete
+    if (future.get_semaphore() == nullptr) {
+      continue;
+    }
+    wait_semaphores.push_back(future.get_semaphore());
+    wait_values.push_back(future.get_value());
+    wait_stages.push_back(stage);
+  }
+
+  VkTimelineSemaphoreSubmitInfo timeline_submit_info{
+      .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+      .waitSemaphoreValueCount = static_cast<u32>(wait_values.size()),
+      .pWaitSemaphoreValues = wait_values.data(),
+      .signalSemaphoreValueCount = 1,
+      .pSignalSemaphoreValues = &signal_value,
+  };
+
   VkSubmitInfo submit_info{};
   submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+  submit_info.pNext = &timeline_submit_info;
 
-  constexpr VkPipelineStageFlags wait_stage_mask =
-      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-  submit_info.pWaitDstStageMask = &wait_stage_mask;
-  // submit_info.signalSemaphoreCount = 1;
-  // submit_info.pSignalSemaphores = &active_frame->finished_semaphore;
+  submit_info.waitSemaphoreCount = static_cast<u32>(wait_semaphores.size());
+  submit_info.pWaitSemaphores = wait_semaphores.data();
+  submit_info.pWaitDstStageMask = wait_stages.data();
+  submit_info.signalSemaphoreCount = 1;
+  submit_info.pSignalSemaphores = &timeline;
 
   submit_info.commandBufferCount = 1;
   std::array<VkCommandBuffer, 1> relevant_buffers{get_command_buffer()};
   submit_info.pCommandBuffers = relevant_buffers.data();
 
-  auto relevant_queue = get_preferred_queue();
+  verify(vkQueueSubmit(get_preferred_queue(), 1, &submit_info, nullptr),
+         "vkQueueSubmit", "Failed to submit queue");
 
-  verify(vkWaitForFences(device.get_device(), 1, &active_frame->fence, VK_TRUE,
-                         timeout),
-         "vkWaitForFences", "Failed to wait for fence");
-  verify(vkResetFences(device.get_device(), 1, &active_frame->fence),
-         "vkResetFences", "Failed to reset fence");
+  active_frame->submitted_value = signal_value;
+  active_frame->has_pending_timestamps = supports_device_query;
 
-  verify(vkQueueSubmit(relevant_queue, 1, &submit_info, active_frame->fence),
-         "vkQueueSubmit", "Failed to submit queue");
-  verify(vkWaitForFences(device.get_device(), 1, &active_frame->fence, VK_TRUE,
-                         timeout),
-         "vkWaitForFences", "Failed to wait for fence");
+  return GpuFuture{device.get_device(), timeline, signal_value};
+}
 
-  if (supports_device_query) {
-    std::array<u64, 2> timestamps{};
-    vkGetQueryPoolResults(device.get_device(), *active_pool, 0, 2,
-                          sizeof(timestamps), timestamps.data(), sizeof(u64),
-                          VK_QUERY_RESULT_64_BIT);
-
-    const auto timestamp_period =
-        device.get_device_properties().limits.timestampPeriod;
-    static constexpr auto convert_to_floating = [](const auto timestamp) {
-      return static_cast<floating>(timestamp);
-    };
-    floating time_taken_seconds = (convert_to_floating(timestamps[1]) -
-                                   convert_to_floating(timestamps[0])) *
-                                  timestamp_period * 1.0e-9F;
-    const auto times_in_ms = time_taken_seconds * 1000.0F;
-
-    compute_times.push(times_in_ms);
+auto CommandBuffer::submit() -> void {
+  submit_async();
+  wait_for(*active_frame);
+  if (active_frame->has_pending_timestamps) {
+    collect_timestamps(*active_frame, *active_pool);
   }
 }
 
+auto CommandBuffer::wait_for(const FrameCommandBuffer &frame) const -> void {
+  GpuFuture{device.get_device(), timeline, frame.submitted_value}.wait();
+}
+
+auto CommandBuffer::collect_timestamps(FrameCommandBuffer &frame,
+                                       VkQueryPool pool) -> void {
+  frame.has_pending_timestamps = false;
+
+  std::array<u64, 2> timestamps{};
+  const auto result = vkGetQueryPoolResults(
+      device.get_device(), pool, 0, 2, sizeof(timestamps), timestamps.data(),
+      sizeof(u64), VK_QUERY_RESULT_64_BIT);
+  if (result != VK_SUCCESS) {
+    return;
+  }
+
+  const auto timestamp_period =
+      device.get_device_properties().limits.timestampPeriod;
+  static constexpr auto convert_to_floating = [](const auto timestamp) {
+    return static_cast<floating>(timestamp);
+  };
+  floating time_taken_seconds = (convert_to_floating(timestamps[1]) -
+                                 convert_to_floating(timestamps[0])) *
+                                timestamp_period * 1.0e-9F;
+  const auto times_in_ms = time_taken_seconds * 1000.0F;
+
+  compute_times.push(times_in_ms);
+}
+
 auto CommandBuffer::end() -> void {
   if (supports_device_query) {
     vkCmdWriteTimestamp(get_command_buffer(),
@@ -219,6 +260,12 @@ auto CommandBuffer::end_and_submit() -> void {
   submit();
 }
 
+auto CommandBuffer::end_and_submit_async(std::span<const SubmitWait> waits)
+    -> GpuFuture {
+  end();
+  return submit_async(waits);
+}
+
 void CommandBuffer::create_query_objects() {
   VkQueryPoolCreateInfo query_pool_info{};
   query_pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
@@ -20,6 +20,9 @@ DescriptorResource::~DescriptorResource() {
   for (const auto &descriptor_pool : descriptor_pools) {
     vkDestroyDescriptorPool(device->get_device(), descriptor_pool, nullptr);
   }
+  for (const auto &descriptor_pool : persistent_pools) {
+    vkDestroyDescriptorPool(device->get_device(), descriptor_pool, nullptr);
+  }
 }
 
 auto DescriptorResource::allocate_descriptor_set(
@@ -65,8 +68,53 @@ auto DescriptorResource::allocate_many_descriptor_sets(
   return descriptor_sets;
 }
 
+auto DescriptorResource::allocate_persistent_descriptor_set(
+    const VkDescriptorSetAllocateInfo &alloc_info) const
+    -> PersistentDescriptorSet {
+  if (persistent_pools.empty()) {
+    persistent_pools.push_back(create_persistent_pool());
+  }
+
+  auto alloc_info_copy = alloc_info;
+  alloc_info_copy.descriptorSetCount = 1;
+
+  PersistentDescriptorSet result{};
+  alloc_info_copy.descriptorPool = persistent_pools.back();
+  auto allocation_result = vkAllocateDescriptorSets(
+      device->get_device(), &alloc_info_copy, &result.set);
+  if (allocation_result == VK_ERROR_OUT_OF_POOL_MEMORY ||
+      allocation_result == VK_ERROR_FRAGMENTED_POOL) {
+    persistent_pools.push_back(create_persistent_pool());
+    alloc_info_copy.descriptorPool = persistent_pools.back();
+    allocation_result = vkAllocateDescriptorSets(
+        device->get_device(), &alloc_info_copy, &result.set);
+  }
+  verify(allocation_result, "vkAllocateDescriptorSets",
+         "Failed to allocate persistent descriptor set");
+
+  result.pool = alloc_info_copy.descriptorPool;
+  return result;
+}
+
+auto DescriptorResource::free_persistent_descriptor_set(
+    const PersistentDescriptorSet &persistent) const -> void {
+  if (persistent.set == nullptr) {
+    return;
+  }
+  // Frames already submitted may still have the set bound
+  retired_sets.at(current_frame).push_back(persistent);
+}
+
 void DescriptorResource::begin_frame(u32 frame) {
   current_frame = frame;
+  ++frame_counter;
+
+  auto &retired = retired_sets.at(current_frame);
+  for (const auto &persistent : retired) {
+    vkFreeDescriptorSets(device->get_device(), persistent.pool, 1,
+                         &persistent.set);
+  }
+  retired.clear();
   // Cleanup or reset operations for the beginning of the frame
 
   vkResetDescriptorPool(device->get_device(), descriptor_pools[current_frame],
@@ -145,6 +193,21 @@ void DescriptorResource::create_pool() {
   }
 }
 
+auto DescriptorResource::create_persistent_pool() const -> VkDescriptorPool {
+  VkDescriptorPoolCreateInfo pool_info = {};
+  pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+  pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+  pool_info.poolSizeCount = static_cast<uint32_t>(pool_sizes.size());
+  pool_info.pPoolSizes = pool_sizes.data();
+  pool_info.maxSets = 1000 * Config::frame_count;
+
+  VkDescriptorPool pool{};
+  verify(vkCreateDescriptorPool(device->get_device(), &pool_info, nullptr,
+                                &pool),
+         "vkCreateDescriptorPool", "Failed to create persistent pool");
+  return pool;
+}
+
 void DescriptorResource::handle_fragmentation() const {
   // Handle fragmentation issues
 }
@@ -3,15 +3,23 @@
 #include "Device.hpp"
 
 #include "Allocator.hpp"
+#include "BindlessTextures.hpp"
 #include "DescriptorResource.hpp"
+#include "FrameAllocator.hpp"
 #include "Instance.hpp"
 #include "Logger.hpp"
+#include "MipGenerator.hpp"
+#include "PipelineCache.hpp"
+#include "StagingUploader.hpp"
+#include "TextureStreamer.hpp"
 #include "Types.hpp"
 #include "Verify.hpp"
 #include "Window.hpp"
 
+#include <algorithm>
 #include <fmt/format.h>
 #include <fmt/std.h>
+#include <string_view>
 #include <vector>
 #include <vulkan/vulkan_core.h>
 
@@ -25,9 +33,19 @@ public:
 Device::Device(const Instance &inst, const Window &window) : instance(inst) {
   construct_vulkan_device(window);
   descriptor_resource = DescriptorResource::construct(*this);
+  pipeline_cache = PipelineCache::construct(*this);
+  if (feature_support.bindless) {
+    bindless_textures = BindlessTextures::construct(*this);
+  }
 }
 
 Device::~Device() {
+  texture_streamer.reset();
+  mip_generator.reset();
+  staging_uploader.reset();
+  frame_allocator.reset();
+  bindless_textures.reset();
+  pipeline_cache.reset();
   descriptor_resource.reset();
 
   vkDeviceWaitIdle(device);
@@ -37,6 +55,42 @@ Device::~Device() {
   info("Destroyed Device!");
 }
 
+auto Device::get_staging_uploader() const -> StagingUploader & {
+  if (!staging_uploader) {
+    staging_uploader = StagingUploader::construct(*this);
+  }
+  return *staging_uploader;
+}
+
+auto Device::destroy_staging_uploader() -> void { staging_uploader.reset(); }
+
+auto Device::get_frame_allocator() const -> FrameAllocator & {
+  if (!frame_allocator) {
+    frame_allocator = FrameAllocator::construct(*this);
+  }
+  return *frame_allocator;
+}
+
+auto Device::destroy_frame_allocator() -> void { frame_allocator.reset(); }
+
+auto Device::get_mip_generator() const -> MipGenerator & {
+  if (!mip_generator) {
+    mip_generator = MipGenerator::construct(*this);
+  }
+  return *mip_generator;
+}
+
+auto Device::destroy_mip_generator() -> void { mip_generator.reset(); }
+
+auto Device::get_texture_streamer() const -> TextureStreamer & {
+  if (!texture_streamer) {
+    texture_streamer = TextureStreamer::construct(*this);
+  }
+  return *texture_streamer;
+}
+
+auto Device::destroy_texture_streamer() -> void { texture_streamer.reset(); }
+
 auto Device::check_support(const Feature feature, Queue::Type queue) const
     -> bool {
   if (!queue_support.contains(queue)) {
@@ -51,6 +105,22 @@ auto Device::check_support(const Feature feature, Queue::Type queue) const
     return queue_support.at(queue).timestamping;
   }
 
+  if (feature == Feature::DrawIndirectCount) {
+    return feature_support.draw_indirect_count;
+  }
+
+  if (feature == Feature::Bindless) {
+    return feature_support.bindless;
+  }
+
+  if (feature == Feature::TextureCompressionBC) {
+    return feature_support.texture_compression_bc;
+  }
+
+  if (feature == Feature::MemoryBudget) {
+    return feature_support.memory_budget;
+  }
+
   return false;
 }
 
@@ -232,9 +302,62 @@ auto Device::create_vulkan_device(
     VkPhysicalDevice dev,
     std::vector<IndexQueueTypePair> &index_queue_type_pairs) -> VkDevice {
 
+  VkPhysicalDeviceVulkan12Features supported_vulkan_12_features{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+  };
+  VkPhysicalDeviceFeatures2 supported_features{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
+      .pNext = &supported_vulkan_12_features,
+  };
+  vkGetPhysicalDeviceFeatures2(dev, &supported_features);
+
   VkPhysicalDeviceFeatures device_features{};
   device_features.pipelineStatisticsQuery = VK_TRUE;
   device_features.logicOp = VK_TRUE;
+  // Culled indirect draws keep their per-draw instance offset
+  device_features.drawIndirectFirstInstance =
+      supported_features.features.drawIndirectFirstInstance;
+  // Mesh textures are uploaded as BC blocks where possible
+  device_features.textureCompressionBC =
+      supported_features.features.textureCompressionBC;
+  feature_support.texture_compression_bc =
+      device_features.textureCompressionBC == VK_TRUE;
+
+  VkPhysicalDeviceVulkan12Features vulkan_12_features{
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
+  };
+  vulkan_12_features.drawIndirectCount =
+      supported_vulkan_12_features.drawIndirectCount;
+  // Command buffer submissions are tracked with timeline semaphores
+  ensure(supported_vulkan_12_features.timelineSemaphore == VK_TRUE,
+         "Device does not support timeline semaphores");
+  vulkan_12_features.timelineSemaphore = VK_TRUE;
+
+  // Materials index a global texture array written after bind
+  const auto supports_bindless =
+      supported_vulkan_12_features.descriptorIndexing == VK_TRUE &&
+      supported_vulkan_12_features.runtimeDescriptorArray == VK_TRUE &&
+      supported_vulkan_12_features.descriptorBindingPartiallyBound ==
+          VK_TRUE &&
+      supported_vulkan_12_features
+              .descriptorBindingSampledImageUpdateAfterBind == VK_TRUE &&
+      supported_vulkan_12_features
+              .descriptorBindingUpdateUnusedWhilePending == VK_TRUE &&
+      supported_vulkan_12_features
+              .shaderSampledImageArrayNonUniformIndexing == VK_TRUE;
+  if (supports_bindless) {
+    vulkan_12_features.descriptorIndexing = VK_TRUE;
+    vulkan_12_features.runtimeDescriptorArray = VK_TRUE;
+    vulkan_12_features.descriptorBindingPartiallyBound = VK_TRUE;
+    vulkan_12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    vulkan_12_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    vulkan_12_features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+  }
+  feature_support.bindless = supports_bindless;
+
+  feature_support.draw_indirect_count =
+      vulkan_12_features.drawIndirectCount == VK_TRUE &&
+      device_features.drawIndirectFirstInstance == VK_TRUE;
 
   std::vector<VkDeviceQueueCreateInfo> queue_infos;
   for (auto &&[type, queue_info, supports_timestamping] :
@@ -248,9 +371,25 @@ auto Device::create_vulkan_device(
   auto swapchain_extension = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
   std::vector<const char *> extensions = {swapchain_extension};
 
+  // Lets VMA report real heap usage and budgets for the memory telemetry
+  u32 extension_count = 0;
+  vkEnumerateDeviceExtensionProperties(dev, nullptr, &extension_count,
+                                       nullptr);
+  std::vector<VkExtensionProperties> available_extensions(extension_count);
+  vkEnumerateDeviceExtensionProperties(dev, nullptr, &extension_count,
+                                       available_extensions.data());
+  feature_support.memory_budget = std::ranges::any_of(
+      available_extensions, [](const VkExtensionProperties &extension) {
+        return std::string_view{extension.extensionName} ==
+               VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+      });
+  if (feature_support.memory_budget) {
+    extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+  }
+
   VkDeviceCreateInfo create_info = {
       .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
-      .pNext = nullptr,
+      .pNext = &vulkan_12_features,
       .queueCreateInfoCount = static_cast<u32>(queue_infos.size()),
       .pQueueCreateInfos = queue_infos.data(),
       .enabledExtensionCount = static_cast<u32>(extensions.size()),
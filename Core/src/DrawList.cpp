@@ -0,0 +1,113 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "DrawList.hpp"
+
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace Core {
+
+auto DrawList::hash(const Mesh *mesh, u32 submesh_index) -> usize {
+  auto seed = std::hash<const Mesh *>{}(mesh);
+  seed ^= std::hash<u32>{}(submesh_index) + 0x9e3779b9 + (seed << 6) +
+          (seed >> 2);
+  return seed;
+}
+
+auto DrawList::submit(const Mesh *mesh, u32 submesh_index, Material *material,
+                      const glm::mat4 &transform) -> void {
+  const auto draw = find_or_insert(mesh, submesh_index, material);
+  ++instance_counts[draw];
+  transforms.push_back(transform);
+  instance_draws.push_back(draw);
+}
+
+auto DrawList::find_or_insert(const Mesh *mesh, u32 submesh_index,
+                              Material *material) -> u32 {
+  // Keep the table at most half full
+  if ((meshes.size() + 1) * 2 > slots.size()) {
+    grow_slots();
+  }
+
+  const auto mask = slots.size() - 1;
+  for (auto slot = hash(mesh, submesh_index) & mask;;
+       slot = (slot + 1) & mask) {
+    if (slots[slot] == empty_slot) {
+      const auto draw = static_cast<u32>(meshes.size());
+      slots[slot] = draw + 1;
+      meshes.push_back(mesh);
+      submesh_indices.push_back(submesh_index);
+      materials.push_back(material);
+      instance_counts.push_back(0);
+      first_instances.push_back(0);
+      draw_indices.push_back(0);
+      return draw;
+    }
+
+    const auto draw = slots[slot] - 1;
+    if (meshes[draw] == mesh && submesh_indices[draw] == submesh_index) {
+      return draw;
+    }
+  }
+}
+
+auto DrawList::grow_slots() -> void {
+  const auto capacity = std::max<usize>(64, std::bit_ceil(slots.size() * 2));
+  slots.assign(capacity, empty_slot);
+
+  const auto mask = capacity - 1;
+  for (u32 draw = 0; draw < meshes.size(); ++draw) {
+    auto slot = hash(meshes[draw], submesh_indices[draw]) & mask;
+    while (slots[slot] != empty_slot) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = draw + 1;
+  }
+}
+
+auto DrawList::pack(std::span<glm::mat4> output, u32 offset) -> u32 {
+  cursors.resize(meshes.size());
+  dropped_instances = 0;
+
+  for (u32 draw = 0; draw < meshes.size(); ++draw) {
+    const auto count = instance_counts[draw];
+    if (offset + count > output.size()) {
+      dropped_instances += count;
+      instance_counts[draw] = 0;
+    }
+    first_instances[draw] = offset;
+    cursors[draw] = offset;
+    offset += instance_counts[draw];
+  }
+
+  for (usize instance = 0; instance < transforms.size(); ++instance) {
+    const auto draw = instance_draws[instance];
+    if (instance_counts[draw] == 0) {
+      continue;
+    }
+    output[cursors[draw]++] = transforms[instance];
+  }
+
+  if (dropped_instances > 0) {
+    warn("Transform buffer region ending at {} is full, dropped {} of {} "
+         "instances.",
+         output.size(), dropped_instances, transforms.size());
+  }
+  return offset;
+}
+
+auto DrawList::clear() -> void {
+  meshes.clear();
+  submesh_indices.clear();
+  materials.clear();
+  instance_counts.clear();
+  first_instances.clear();
+  draw_indices.clear();
+  transforms.clear();
+  instance_draws.clear();
+  std::ranges::fill(slots, empty_slot);
+}
+
+} // namespace Core
@@ -0,0 +1,153 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "FrameAllocator.hpp"
+
+#include "Allocator.hpp"
+#include "Device.hpp"
+#include "Verify.hpp"
+
+#include <algorithm>
+#include <vk_mem_alloc.h>
+
+namespace Core {
+
+namespace {
+
+constexpr VkBufferUsageFlags arena_usage =
+    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+    VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+
+} // namespace
+
+struct FrameAllocatorImpl {
+  struct ArenaBuffer {
+    VkBuffer buffer{};
+    VmaAllocation allocation{};
+    VmaAllocationInfo allocation_info{};
+  };
+
+  VmaPool pool{};
+  std::array<ArenaBuffer, Config::frame_count> buffers{};
+
+  explicit FrameAllocatorImpl(u64 arena_size) {
+    VkBufferCreateInfo buffer_create_info{};
+    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.size = arena_size;
+    buffer_create_info.usage = arena_usage;
+
+    // Same memory as the dynamic storage buffers, mapped for the CPU
+    VmaAllocationCreateInfo allocation_create_info{};
+    allocation_create_info.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+    allocation_create_info.flags =
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT |
+        VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    u32 memory_type_index{0};
+    verify(vmaFindMemoryTypeIndexForBufferInfo(
+               Allocator::get_allocator(), &buffer_create_info,
+               &allocation_create_info, &memory_type_index),
+           "vmaFindMemoryTypeIndexForBufferInfo",
+           "No memory type for the frame arenas");
+
+    // One block holding every arena back to back
+    VmaPoolCreateInfo pool_create_info{};
+    pool_create_info.memoryTypeIndex = memory_type_index;
+    pool_create_info.flags = VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT;
+    pool_create_info.blockSize = arena_size * Config::frame_count;
+    pool_create_info.minBlockCount = 1;
+    pool_create_info.maxBlockCount = 1;
+    verify(vmaCreatePool(Allocator::get_allocator(), &pool_create_info, &pool),
+           "vmaCreatePool", "Failed to create the frame arena pool");
+
+    Allocator allocator{"Frame Arena", MemoryCategory::Frame};
+    for (auto &arena : buffers) {
+      arena.allocation = allocator.allocate_buffer(
+          arena.buffer, arena.allocation_info, buffer_create_info,
+          {
+              .usage = Usage::AUTO_PREFER_DEVICE,
+              .creation = Creation::MAPPED_BIT,
+              .pool = pool,
+          });
+    }
+  }
+
+  ~FrameAllocatorImpl() {
+    Allocator allocator{"Frame Arena", MemoryCategory::Frame};
+    for (auto &arena : buffers) {
+      allocator.deallocate_buffer(arena.allocation, arena.buffer);
+    }
+    vmaDestroyPool(Allocator::get_allocator(), pool);
+  }
+};
+
+FrameAllocator::FrameAllocator(const Device &dev, u64 size)
+    : device(&dev), arena_size(size),
+      impl(make_scope<FrameAllocatorImpl>(size)) {
+  const auto &limits = device->get_device_properties().limits;
+  uniform_alignment = limits.minUniformBufferOffsetAlignment;
+  storage_alignment = limits.minStorageBufferOffsetAlignment;
+  arenas.fill(ArenaStack{arena_size});
+}
+
+FrameAllocator::~FrameAllocator() = default;
+
+auto FrameAllocator::construct(const Device &device, u64 arena_size)
+    -> Scope<FrameAllocator> {
+  return Scope<FrameAllocator>{new FrameAllocator(device, arena_size)};
+}
+
+auto FrameAllocator::get_alignment(Buffer::Type type) const -> u64 {
+  switch (type) {
+  case Buffer::Type::Uniform:
+    return uniform_alignment;
+  case Buffer::Type::Storage:
+    return storage_alignment;
+  default:
+    return std::max(uniform_alignment, storage_alignment);
+  }
+}
+
+auto FrameAllocator::allocate_transient(u64 size, Buffer::Type type)
+    -> FrameAllocation {
+  const auto offset =
+      arenas.at(current_frame).allocate(size, get_alignment(type));
+  ensure(offset.has_value(), "Frame arena {} is out of space for {} bytes",
+         current_frame, size);
+  return to_allocation(current_frame, *offset, size);
+}
+
+auto FrameAllocator::retain(u32 frame, u64 size, Buffer::Type type)
+    -> FrameAllocation {
+  ensure(frame < Config::frame_count, "Frame index {} out of range", frame);
+  const auto offset = arenas.at(frame).retain(size, get_alignment(type));
+  return offset ? to_allocation(frame, *offset, size) : FrameAllocation{};
+}
+
+auto FrameAllocator::release(const FrameAllocation &allocation) -> void {
+  arenas.at(allocation.frame).release(allocation.offset);
+}
+
+auto FrameAllocator::begin_frame(u32 frame) -> void {
+  ensure(frame < Config::frame_count, "Frame index {} out of range", frame);
+  current_frame = frame;
+  ++frame_counter;
+  arenas.at(frame).reset_transient();
+}
+
+auto FrameAllocator::get_arena(u32 frame) const -> FrameAllocation {
+  return to_allocation(frame, 0, arena_size);
+}
+
+auto FrameAllocator::to_allocation(u32 frame, u64 offset, u64 size) const
+    -> FrameAllocation {
+  const auto &arena = impl->buffers.at(frame);
+  return {
+      .buffer = arena.buffer,
+      .offset = offset,
+      .size = size,
+      .mapped =
+          static_cast<u8 *>(arena.allocation_info.pMappedData) + offset,
+      .frame = frame,
+  };
+}
+
+} // namespace Core
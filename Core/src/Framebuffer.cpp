@@ -2,7 +2,6 @@
 
 #include "Framebuffer.hpp"
 
-#include "Allocator.hpp"
 #include "DebugMarker.hpp"
 #include "Verify.hpp"
 
@@ -92,7 +91,6 @@ auto Framebuffer::invalidate() -> void {
 
 auto Framebuffer::create_framebuffer() -> void {
   trace("Framebuffer::create_framebuffer");
-  Allocator allocator("Framebuffer");
 
   std::vector<VkAttachmentDescription> attachmentDescriptions;
 
@@ -107,6 +105,10 @@ auto Framebuffer::create_framebuffer() -> void {
   if (properties.existing_framebuffer)
     attachment_images.clear();
 
+  const auto attachment_name = [this](u32 index) {
+    return fmt::format("{}-Attachment{}", properties.debug_name, index);
+  };
+
   u32 attachment_index = 0;
   for (auto attachment_specification : attachments) {
     if (is_depth_format(attachment_specification.format)) {
@@ -143,6 +145,7 @@ auto Framebuffer::create_framebuffer() -> void {
                   .address_mode = SamplerAddressMode::ClampToBorder,
                   .border_color = SamplerBorderColor::FloatOpaqueWhite,
                   .compare_op = CompareOperation::Less,
+                  .debug_name = attachment_name(attachment_index),
               });
         }
       }
@@ -195,6 +198,7 @@ auto Framebuffer::create_framebuffer() -> void {
                        ImageUsage::TransferSrc | ImageUsage::TransferDst;
           spec.extent.width = static_cast<u32>(width * properties.scale);
           spec.extent.height = static_cast<u32>(height * properties.scale);
+          spec.debug_name = attachment_name(attachment_index);
           color_attachment = attachment_images.emplace_back(
               Image::construct_reference(*device, spec));
         } else {
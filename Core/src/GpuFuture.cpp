@@ -0,0 +1,40 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "GpuFuture.hpp"
+
+#include "Verify.hpp"
+
+namespace Core {
+
+auto GpuFuture::is_ready() const -> bool {
+  if (semaphore == nullptr) {
+    return true;
+  }
+
+  u64 current{0};
+  verify(vkGetSemaphoreCounterValue(device, semaphore, &current),
+         "vkGetSemaphoreCounterValue", "Failed to read timeline semaphore");
+  return current >= value;
+}
+
+auto GpuFuture::wait(u64 timeout_in_ns) const -> bool {
+  if (semaphore == nullptr) {
+    return true;
+  }
+
+  VkSemaphoreWaitInfo wait_info{
+      .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+      .semaphoreCount = 1,
+      .pSemaphores = &semaphore,
+      .pValues = &value,
+  };
+  const auto result = vkWaitSemaphores(device, &wait_info, timeout_in_ns);
+  if (result == VK_TIMEOUT) {
+    return false;
+  }
+
+  verify(result, "vkWaitSemaphores", "Failed to wait for timeline semaphore");
+  return true;
+}
+
+} // namespace Core
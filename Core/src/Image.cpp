@@ -3,9 +3,12 @@
 #include "Image.hpp"
 
 #include "Allocator.hpp"
+#include "BindlessTextures.hpp"
 #include "CommandBuffer.hpp"
 #include "DataBuffer.hpp"
 #include "Logger.hpp"
+#include "MipGenerator.hpp"
+#include "StagingUploader.hpp"
 #include "Verify.hpp"
 
 #include <cstring>
@@ -32,6 +35,24 @@ auto to_vulkan_format(ImageFormat format) -> VkFormat {
     return VK_FORMAT_D24_UNORM_S8_UINT;
   case DEPTH16:
     return VK_FORMAT_D16_UNORM;
+  case BC1_UNORM:
+    return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+  case BC1_SRGB:
+    return VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+  case BC3_UNORM:
+    return VK_FORMAT_BC3_UNORM_BLOCK;
+  case BC3_SRGB:
+    return VK_FORMAT_BC3_SRGB_BLOCK;
+  case BC5_UNORM:
+    return VK_FORMAT_BC5_UNORM_BLOCK;
+  case BC7_UNORM:
+    return VK_FORMAT_BC7_UNORM_BLOCK;
+  case BC7_SRGB:
+    return VK_FORMAT_BC7_SRGB_BLOCK;
+  case BC1_RGBA_UNORM:
+    return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+  case BC1_RGBA_SRGB:
+    return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
   default:
     assert(false);
     return VK_FORMAT_MAX_ENUM;
@@ -232,6 +253,9 @@ struct Image::ImageStorageImpl {
   explicit ImageStorageImpl(const Device *dev) : device(dev) {}
 
   ~ImageStorageImpl() {
+    if (auto *bindless = device->get_bindless_textures(); bindless != nullptr) {
+      bindless->release(image_view);
+    }
     vkDestroySampler(device->get_device(), sampler, nullptr);
     vkDestroyImageView(device->get_device(), image_view, nullptr);
     Allocator allocator{"Image"};
@@ -277,71 +301,73 @@ auto Image::recreate() -> void {
 
   initialise_vulkan_image();
   initialise_vulkan_descriptor_info();
-  // if (properties.mip_info.valid()) {
-  //  create_mips();
-  //}
 }
 
 auto Image::load_image_data_from_buffer(const DataBuffer &data_buffer) const
     -> void {
-  // Create a transfer buffer
-  Allocator allocator{"Image"};
-  VkBufferCreateInfo buffer_create_info{};
-  buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-  buffer_create_info.size = data_buffer.size();
-  buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-
-  VkBuffer staging_buffer{};
-  VmaAllocationInfo staging_allocation_info{};
-  const auto allocation = allocator.allocate_buffer(
-      staging_buffer, staging_allocation_info, buffer_create_info,
-      {.usage = Usage::AUTO_PREFER_DEVICE,
-       .creation = Creation::HOST_ACCESS_RANDOM_BIT | Creation::MAPPED_BIT});
-  const std::span allocation_span{
-      static_cast<u8 *>(staging_allocation_info.pMappedData),
-      staging_allocation_info.size};
-  data_buffer.read(allocation_span);
-
-  {
-    const auto buffer = create_immediate(*device, Queue::Type::Graphics);
-
-    transition_image(buffer, impl->image, VK_IMAGE_LAYOUT_UNDEFINED,
-                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, aspect_bit);
-    VkBufferImageCopy region{};
-    region.bufferOffset = 0;
-    region.bufferRowLength = 0;
-    region.bufferImageHeight = 0;
+  // Mip generation blits from level 0, so leave it as a transfer destination
+  const auto final_layout = properties.mip_info.valid()
+                                ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+                                : to_vulkan_layout(properties.layout);
+
+  VkBufferImageCopy region{};
+  region.bufferOffset = 0;
+  region.bufferRowLength = 0;
+  region.bufferImageHeight = 0;
+  region.imageSubresource.aspectMask = aspect_bit;
+  region.imageSubresource.mipLevel = 0;
+  region.imageSubresource.baseArrayLayer = 0;
+  region.imageSubresource.layerCount = 1;
+  region.imageOffset = {
+      0,
+      0,
+      0,
+  };
+  region.imageExtent = {
+      properties.extent.width,
+      properties.extent.height,
+      1,
+  };
+
+  device->get_staging_uploader().upload(*this, data_buffer.span(),
+                                        std::span{&region, 1}, final_layout);
+}
+
+Image::Image(const Device &dev, ImageProperties properties,
+             const DataBuffer &data_buffer)
+    : Image(dev, properties) {
+  load_image_data_from_buffer(data_buffer);
+  if (this->properties.mip_info.valid()) {
+    device->get_mip_generator().enqueue(*this);
+  }
+}
+
+Image::Image(const Device &dev, ImageProperties properties,
+             std::span<const u8> data, std::span<const u64> level_offsets)
+    : Image(dev, properties) {
+  const auto level_count =
+      this->properties.mip_info.valid() ? this->properties.mip_info.mips : 1;
+  ensure(level_offsets.size() == level_count,
+         "Expected {} mip level offsets, got {}", level_count,
+         level_offsets.size());
+
+  std::vector<VkBufferImageCopy> regions(level_count);
+  for (u32 level = 0; level < level_count; ++level) {
+    auto &region = regions[level];
+    region.bufferOffset = level_offsets[level];
     region.imageSubresource.aspectMask = aspect_bit;
-    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.mipLevel = level;
     region.imageSubresource.baseArrayLayer = 0;
     region.imageSubresource.layerCount = 1;
-    region.imageOffset = {
-        0,
-        0,
-        0,
-    };
     region.imageExtent = {
-        properties.extent.width,
-        properties.extent.height,
+        std::max(this->properties.extent.width >> level, 1U),
+        std::max(this->properties.extent.height >> level, 1U),
         1,
     };
-
-    vkCmdCopyBufferToImage(buffer.get_command_buffer(), staging_buffer,
-                           impl->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1,
-                           &region);
-
-    transition_image(buffer, impl->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                     to_vulkan_layout(properties.layout), aspect_bit);
   }
 
-  allocator.deallocate_buffer(allocation, staging_buffer);
-}
-
-Image::Image(const Device &dev, ImageProperties properties,
-             const DataBuffer &data_buffer)
-    : Image(dev, properties) {
-  load_image_data_from_buffer(data_buffer);
-  create_mips();
+  device->get_staging_uploader().upload(
+      *this, data, regions, to_vulkan_layout(this->properties.layout));
 }
 
 auto Image::initialise_vulkan_descriptor_info() -> void {
@@ -384,6 +410,8 @@ auto hash_combine(usize &seed, const void *value) noexcept -> void {
 }
 } // namespace
 
+auto Image::get_image() const noexcept -> VkImage { return impl->image; }
+
 auto Image::hash() const noexcept -> usize {
   usize hash = 0;
   hash_combine(hash, impl->image);
@@ -394,99 +422,10 @@ auto Image::hash() const noexcept -> usize {
 
 Image::~Image() = default;
 
-void Image::create_mips() {
-  VkImageMemoryBarrier barrier{};
-  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-  barrier.image = impl->image;
-  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-  barrier.subresourceRange.aspectMask = aspect_bit;
-  barrier.subresourceRange.baseArrayLayer = 0;
-  barrier.subresourceRange.layerCount = 1;
-  barrier.subresourceRange.levelCount = 1;
-  auto &&[mip_width, mip_height] = properties.extent.as<i32>();
-
-  auto command_buffer = create_immediate(*device, Queue::Type::Graphics);
-  transition_image(command_buffer, impl->image, VK_IMAGE_LAYOUT_UNDEFINED,
-                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-  for (u32 i = 1; i < properties.mip_info.mips; i++) {
-    barrier.subresourceRange.baseMipLevel = i - 1;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-    vkCmdPipelineBarrier(
-        command_buffer.get_command_buffer(), VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-    VkImageBlit blit{};
-    blit.srcOffsets[0] = {
-        0,
-        0,
-        0,
-    };
-    blit.srcOffsets[1] = {
-        mip_width,
-        mip_height,
-        1,
-    };
-    blit.srcSubresource.aspectMask = aspect_bit;
-    blit.srcSubresource.mipLevel = i - 1;
-    blit.srcSubresource.baseArrayLayer = 0;
-    blit.srcSubresource.layerCount = 1;
-    blit.dstOffsets[0] = {
-        0,
-        0,
-        0,
-    };
-    blit.dstOffsets[1] = {
-        mip_width > 1 ? mip_width / 2 : 1,
-        mip_height > 1 ? mip_height / 2 : 1,
-        1,
-    };
-    blit.dstSubresource.aspectMask = aspect_bit;
-    blit.dstSubresource.mipLevel = i;
-    blit.dstSubresource.baseArrayLayer = 0;
-    blit.dstSubresource.layerCount = 1;
-
-    vkCmdBlitImage(command_buffer.get_command_buffer(), impl->image,
-                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, impl->image,
-                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
-                   VK_FILTER_LINEAR);
-
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-    vkCmdPipelineBarrier(command_buffer.get_command_buffer(),
-                         VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr,
-                         0, nullptr, 1, &barrier);
-
-    if (mip_width > 1) {
-      mip_width /= 2;
-    }
-    if (mip_height > 1) {
-      mip_height /= 2;
-    }
-  }
-
-  barrier.subresourceRange.baseMipLevel = properties.mip_info.mips - 1;
-  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-  barrier.newLayout = to_vulkan_layout(properties.layout);
-  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-  vkCmdPipelineBarrier(command_buffer.get_command_buffer(),
-                       VK_PIPELINE_STAGE_TRANSFER_BIT,
-                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
-                       nullptr, 1, &barrier);
-}
-
 auto Image::initialise_vulkan_image() -> void {
-  Allocator allocator{"Image"};
+  Allocator allocator{properties.debug_name.empty() ? "Image"
+                                                    : properties.debug_name,
+                      MemoryCategory::Image};
   VkImageCreateInfo image_create_info{};
   image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
   image_create_info.imageType = VK_IMAGE_TYPE_2D;
@@ -503,12 +442,20 @@ auto Image::initialise_vulkan_image() -> void {
   image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
   image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
-  Creation creation{0};
+  // The mip generator writes the levels below 0 as storage images, sRGB
+  // images through a UNORM view
+  const auto generates_mips_in_compute =
+      MipGenerator::supports_compute(*device, properties);
+  if (generates_mips_in_compute) {
+    image_create_info.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    if (properties.format == ImageFormat::SRGB_RGBA8) {
+      image_create_info.flags |= VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT |
+                                 VK_IMAGE_CREATE_EXTENDED_USAGE_BIT;
+    }
+  }
 
-  static auto is_storage = [&] {
-    return (properties.usage & ImageUsage::Storage) != ImageUsage{0};
-  };
-  if (is_storage()) {
+  Creation creation{0};
+  if ((properties.usage & ImageUsage::Storage) != ImageUsage{0}) {
     creation = Creation::HOST_ACCESS_RANDOM_BIT | Creation::MAPPED_BIT;
   }
 
@@ -531,6 +478,15 @@ auto Image::initialise_vulkan_image() -> void {
   image_view_create_info.subresourceRange.baseArrayLayer = 0;
   image_view_create_info.subresourceRange.layerCount = 1;
 
+  // The storage bit is only meant for the mip generator's own views
+  const VkImageViewUsageCreateInfo view_usage_info{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO,
+      .usage = static_cast<VkImageUsageFlags>(properties.usage),
+  };
+  if (generates_mips_in_compute) {
+    image_view_create_info.pNext = &view_usage_info;
+  }
+
   verify(vkCreateImageView(device->get_device(), &image_view_create_info,
                            nullptr, &impl->image_view),
          "vkCreateImageView", "Failed to create image view");
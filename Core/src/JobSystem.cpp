@@ -0,0 +1,385 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "JobSystem.hpp"
+
+#include "Config.hpp"
+#include "Verify.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace Core {
+
+namespace Detail {
+
+struct JobState {
+  JobSystem::Work work;
+  JobAffinity affinity{JobAffinity::Any};
+  // Unfinished dependencies, plus one held while the job is being scheduled
+  std::atomic<u32> pending{1};
+  std::atomic<bool> done{false};
+  std::exception_ptr exception{nullptr};
+
+  std::mutex continuation_mutex;
+  bool finished{false};
+  std::vector<Ref<JobState>> continuations{};
+};
+
+} // namespace Detail
+
+namespace {
+
+using Detail::JobState;
+
+struct WorkerQueue {
+  std::mutex mutex;
+  std::deque<Ref<JobState>> jobs;
+};
+
+thread_local i32 worker_index = -1;
+
+auto resolve_worker_count() -> u32 {
+  if constexpr (Config::thread_count > 0) {
+    return Config::thread_count;
+  }
+  // The main thread runs jobs too while it waits
+  const auto hardware_threads = std::thread::hardware_concurrency();
+  return hardware_threads > 1 ? hardware_threads - 1 : 1;
+}
+
+class Scheduler {
+public:
+  Scheduler() {
+    const auto count = resolve_worker_count();
+    queues.reserve(count);
+    for (u32 i = 0; i < count; ++i) {
+      queues.push_back(make_scope<WorkerQueue>());
+    }
+    workers.reserve(count);
+    for (u32 i = 0; i < count; ++i) {
+      workers.emplace_back([this, i] { worker_loop(i); });
+    }
+  }
+
+  ~Scheduler() {
+    stopping = true;
+    {
+      std::scoped_lock lock(sleep_mutex);
+    }
+    wake.notify_all();
+    for (auto &worker : workers) {
+      worker.join();
+    }
+  }
+
+  Scheduler(const Scheduler &) = delete;
+  auto operator=(const Scheduler &) -> Scheduler & = delete;
+
+  auto bind_main_thread() -> void {
+    auto bound = std::thread::id{};
+    const auto current = std::this_thread::get_id();
+    if (!main_thread_id.compare_exchange_strong(bound, current)) {
+      ensure(bound == current, "The job system is bound to another thread");
+    }
+  }
+
+  [[nodiscard]] auto is_main_thread() const -> bool {
+    return std::this_thread::get_id() == main_thread_id.load();
+  }
+
+  [[nodiscard]] auto worker_count() const -> u32 {
+    return static_cast<u32>(workers.size());
+  }
+
+  auto release(const Ref<JobState> &job) -> void {
+    if (job->pending.fetch_sub(1) == 1) {
+      enqueue(job);
+    }
+  }
+
+  auto wait_until_done(const JobState &job) -> void {
+    // A background job could hold up the main thread for a whole frame
+    const auto take_background = worker_index >= 0;
+    while (!job.done) {
+      if (try_run_one(take_background)) {
+        continue;
+      }
+
+      std::unique_lock lock(sleep_mutex);
+      ++sleepers;
+      wake.wait(lock, [&] {
+        return job.done || queued > 0 ||
+               (take_background && background_queued > 0);
+      });
+      --sleepers;
+    }
+  }
+
+  auto run_main_thread_jobs_until(const JobState &job) -> void {
+    while (!job.done) {
+      if (run_main_thread_jobs() > 0 || try_run_one(true)) {
+        continue;
+      }
+
+      std::unique_lock lock(sleep_mutex);
+      ++sleepers;
+      wake.wait(lock, [&] {
+        return job.done || queued > 0 || main_queued > 0 ||
+               background_queued > 0;
+      });
+      --sleepers;
+    }
+  }
+
+  auto run_main_thread_jobs() -> u32 {
+    u32 count = 0;
+    while (auto job = pop(main_queue, main_queued, false)) {
+      run(job);
+      ++count;
+    }
+    return count;
+  }
+
+private:
+  // Unset until bind_main_thread
+  std::atomic<std::thread::id> main_thread_id{};
+  std::vector<Scope<WorkerQueue>> queues;
+  WorkerQueue main_queue;
+  WorkerQueue background_queue;
+  std::vector<std::thread> workers;
+
+  // Runnable jobs in the worker, main-thread and background queues
+  std::atomic<u64> queued{0};
+  std::atomic<u64> main_queued{0};
+  std::atomic<u64> background_queued{0};
+  std::atomic<u32> next_queue{0};
+  std::atomic<bool> stopping{false};
+
+  std::mutex sleep_mutex;
+  std::condition_variable wake;
+  std::atomic<u32> sleepers{0};
+
+  auto enqueue(const Ref<JobState> &job) -> void {
+    if (job->affinity == JobAffinity::MainThread) {
+      push(main_queue, main_queued, job);
+    } else if (job->affinity == JobAffinity::Background) {
+      push(background_queue, background_queued, job);
+    } else {
+      // Workers keep what they spawn, anything else is spread round-robin
+      const auto index = worker_index >= 0
+                             ? static_cast<u32>(worker_index)
+                             : next_queue++ % static_cast<u32>(queues.size());
+      push(*queues[index], queued, job);
+    }
+    wake_sleepers();
+  }
+
+  static auto push(WorkerQueue &queue, std::atomic<u64> &counter,
+                   const Ref<JobState> &job) -> void {
+    {
+      std::scoped_lock lock(queue.mutex);
+      queue.jobs.push_back(job);
+    }
+    ++counter;
+  }
+
+  // Owners take their newest job, thieves the oldest
+  static auto pop(WorkerQueue &queue, std::atomic<u64> &counter, bool newest)
+      -> Ref<JobState> {
+    std::scoped_lock lock(queue.mutex);
+    if (queue.jobs.empty()) {
+      return nullptr;
+    }
+
+    Ref<JobState> job;
+    if (newest) {
+      job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+    } else {
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+    }
+    --counter;
+    return job;
+  }
+
+  auto steal(u32 start) -> Ref<JobState> {
+    const auto count = static_cast<u32>(queues.size());
+    for (u32 offset = 0; offset < count; ++offset) {
+      if (auto job = pop(*queues[(start + offset) % count], queued, false)) {
+        return job;
+      }
+    }
+    return nullptr;
+  }
+
+  auto try_run_one(bool take_background) -> bool {
+    Ref<JobState> job;
+    if (worker_index >= 0) {
+      job = pop(*queues[worker_index], queued, true);
+    }
+    if (!job && queued > 0) {
+      job = steal(worker_index >= 0 ? static_cast<u32>(worker_index) + 1
+                                    : next_queue.load());
+    }
+    // Only once no frame work is left to run or steal
+    if (!job && take_background && background_queued > 0) {
+      job = pop(background_queue, background_queued, false);
+    }
+    if (!job) {
+      return false;
+    }
+
+    run(job);
+    return true;
+  }
+
+  auto run(const Ref<JobState> &job) -> void {
+    try {
+      if (job->work) {
+        job->work();
+      }
+    } catch (...) {
+      job->exception = std::current_exception();
+    }
+    // Drop the captures as soon as possible, handles may live much longer
+    job->work = nullptr;
+
+    std::vector<Ref<JobState>> continuations;
+    {
+      std::scoped_lock lock(job->continuation_mutex);
+      job->finished = true;
+      continuations.swap(job->continuations);
+    }
+    job->done = true;
+
+    for (const auto &continuation : continuations) {
+      release(continuation);
+    }
+    wake_sleepers();
+  }
+
+  auto wake_sleepers() -> void {
+    if (sleepers == 0) {
+      return;
+    }
+    {
+      std::scoped_lock lock(sleep_mutex);
+    }
+    wake.notify_all();
+  }
+
+  auto worker_loop(u32 index) -> void {
+    worker_index = static_cast<i32>(index);
+    while (!stopping) {
+      if (try_run_one(true)) {
+        continue;
+      }
+
+      std::unique_lock lock(sleep_mutex);
+      ++sleepers;
+      wake.wait(lock, [this] {
+        return stopping || queued > 0 || background_queued > 0;
+      });
+      --sleepers;
+    }
+  }
+};
+
+// Created on first use, with no main thread until JobSystem::initialise
+auto scheduler() -> Scheduler & {
+  static Scheduler instance;
+  return instance;
+}
+
+} // namespace
+
+auto JobHandle::is_done() const -> bool { return !state || state->done; }
+
+auto JobHandle::wait() const -> void {
+  if (!state) {
+    return;
+  }
+
+  ensure(state->done || state->affinity != JobAffinity::MainThread ||
+             !scheduler().is_main_thread(),
+         "The main thread must run a main-thread job it waits on");
+  scheduler().wait_until_done(*state);
+  if (state->exception) {
+    std::rethrow_exception(state->exception);
+  }
+}
+
+auto JobSystem::initialise() -> void { scheduler().bind_main_thread(); }
+
+auto JobSystem::schedule(Work work, std::span<const JobHandle> dependencies,
+                         JobAffinity affinity) -> JobHandle {
+  auto job = make_ref<JobState>();
+  job->work = std::move(work);
+  job->affinity = affinity;
+
+  for (const auto &dependency : dependencies) {
+    if (!dependency.state) {
+      continue;
+    }
+
+    auto &state = *dependency.state;
+    std::scoped_lock lock(state.continuation_mutex);
+    if (!state.finished) {
+      state.continuations.push_back(job);
+      ++job->pending;
+    }
+  }
+
+  // Drops the scheduling reference, so a job without open dependencies is
+  // queued right away
+  scheduler().release(job);
+  return JobHandle{std::move(job)};
+}
+
+auto JobSystem::when_all(std::span<const JobHandle> jobs) -> JobHandle {
+  if (jobs.empty()) {
+    return JobHandle{};
+  }
+
+  return schedule(
+      [dependencies = std::vector(jobs.begin(), jobs.end())] {
+        for (const auto &dependency : dependencies) {
+          if (dependency.state && dependency.state->exception) {
+            std::rethrow_exception(dependency.state->exception);
+          }
+        }
+      },
+      jobs);
+}
+
+auto JobSystem::run_main_thread_jobs() -> u32 {
+  ensure(scheduler().is_main_thread(),
+         "Main-thread jobs must be run from the main thread");
+  return scheduler().run_main_thread_jobs();
+}
+
+auto JobSystem::run_main_thread_jobs_until(const JobHandle &job) -> void {
+  if (!job.state) {
+    return;
+  }
+
+  ensure(scheduler().is_main_thread(),
+         "Main-thread jobs must be run from the main thread");
+  scheduler().run_main_thread_jobs_until(*job.state);
+  if (job.state->exception) {
+    std::rethrow_exception(job.state->exception);
+  }
+}
+
+auto JobSystem::worker_count() -> u32 { return scheduler().worker_count(); }
+
+auto JobSystem::is_main_thread() -> bool {
+  return scheduler().is_main_thread();
+}
+
+} // namespace Core
@@ -0,0 +1,201 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "Ktx2.hpp"
+
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <string_view>
+#include <vulkan/vulkan.h>
+
+namespace Core {
+
+namespace {
+
+struct Header {
+  std::array<u8, 12> identifier{};
+  u32 vk_format{0};
+  u32 type_size{0};
+  u32 pixel_width{0};
+  u32 pixel_height{0};
+  u32 pixel_depth{0};
+  u32 layer_count{0};
+  u32 face_count{0};
+  u32 level_count{0};
+  u32 supercompression_scheme{0};
+  u32 dfd_byte_offset{0};
+  u32 dfd_byte_length{0};
+  u32 kvd_byte_offset{0};
+  u32 kvd_byte_length{0};
+  u64 sgd_byte_offset{0};
+  u64 sgd_byte_length{0};
+};
+static_assert(sizeof(Header) == 80, "KTX2 header is 80 bytes");
+
+struct LevelIndex {
+  u64 byte_offset{0};
+  u64 byte_length{0};
+  u64 uncompressed_byte_length{0};
+};
+static_assert(sizeof(LevelIndex) == 24, "KTX2 level index entry is 24 bytes");
+
+auto to_image_format(u32 vk_format) -> ImageFormat {
+  switch (static_cast<VkFormat>(vk_format)) {
+    using enum Core::ImageFormat;
+  case VK_FORMAT_R8G8B8A8_UNORM:
+    return UNORM_RGBA8;
+  case VK_FORMAT_R8G8B8A8_SRGB:
+    return SRGB_RGBA8;
+  case VK_FORMAT_R32G32B32A32_SFLOAT:
+    return SRGB_RGBA32;
+  case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+    return BC1_UNORM;
+  case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+    return BC1_SRGB;
+  case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+    return BC1_RGBA_UNORM;
+  case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+    return BC1_RGBA_SRGB;
+  case VK_FORMAT_BC3_UNORM_BLOCK:
+    return BC3_UNORM;
+  case VK_FORMAT_BC3_SRGB_BLOCK:
+    return BC3_SRGB;
+  case VK_FORMAT_BC5_UNORM_BLOCK:
+    return BC5_UNORM;
+  case VK_FORMAT_BC7_UNORM_BLOCK:
+    return BC7_UNORM;
+  case VK_FORMAT_BC7_SRGB_BLOCK:
+    return BC7_SRGB;
+  default:
+    return Undefined;
+  }
+}
+
+auto supercompression_name(u32 scheme) -> std::string_view {
+  switch (scheme) {
+  case 1:
+    return "BasisLZ";
+  case 2:
+    return "Zstandard";
+  case 3:
+    return "ZLIB";
+  default:
+    return "Unknown";
+  }
+}
+
+// Size in bytes of one texel, or of one 4x4 block for BC formats
+auto texel_block_size(ImageFormat format) -> u64 {
+  if (is_block_compressed(format)) {
+    return block_size(format);
+  }
+  return format == ImageFormat::SRGB_RGBA32 ? 16 : 4;
+}
+
+auto level_size(ImageFormat format, const Extent<u32> &extent, u32 level)
+    -> u64 {
+  u64 width = std::max(extent.width >> level, 1U);
+  u64 height = std::max(extent.height >> level, 1U);
+  if (is_block_compressed(format)) {
+    width = (width + 3) / 4;
+    height = (height + 3) / 4;
+  }
+  return width * height * texel_block_size(format);
+}
+
+} // namespace
+
+auto Ktx2Reader::is_ktx2(const FS::Path &path) -> bool {
+  return path.extension() == ".ktx2";
+}
+
+auto Ktx2Reader::parse(std::span<const u8> file)
+    -> std::optional<Ktx2Layout> {
+  Header header{};
+  if (file.size() < sizeof(Header)) {
+    warn("KTX2 file of {} bytes is too small for its header", file.size());
+    return std::nullopt;
+  }
+  std::memcpy(&header, file.data(), sizeof(Header));
+
+  if (header.identifier != identifier) {
+    warn("File is not a KTX2 container");
+    return std::nullopt;
+  }
+  if (header.supercompression_scheme != 0) {
+    warn("KTX2 supercompression scheme {} ({}) is not supported",
+         header.supercompression_scheme,
+         supercompression_name(header.supercompression_scheme));
+    return std::nullopt;
+  }
+  if (header.pixel_depth > 1 || header.layer_count > 1 ||
+      header.face_count != 1 || header.pixel_width == 0 ||
+      header.pixel_height == 0) {
+    warn("Only 2D KTX2 textures with one layer and face are supported");
+    return std::nullopt;
+  }
+
+  const auto format = to_image_format(header.vk_format);
+  if (format == ImageFormat::Undefined) {
+    warn("KTX2 vkFormat {} has no matching ImageFormat", header.vk_format);
+    return std::nullopt;
+  }
+
+  // A level count of zero asks the loader to generate mips; we upload the
+  // single stored level as is
+  const auto level_count = std::max(header.level_count, 1U);
+  const auto max_levels = static_cast<u32>(
+      std::bit_width(std::max(header.pixel_width, header.pixel_height)));
+  if (level_count > max_levels) {
+    warn("KTX2 file has {} levels, at most {} fit its extent", level_count,
+         max_levels);
+    return std::nullopt;
+  }
+  const auto index_end =
+      sizeof(Header) + static_cast<u64>(level_count) * sizeof(LevelIndex);
+  if (file.size() < index_end) {
+    warn("KTX2 level index of {} levels is truncated", level_count);
+    return std::nullopt;
+  }
+
+  Ktx2Layout layout{
+      .format = format,
+      .extent = {header.pixel_width, header.pixel_height},
+  };
+
+  std::vector<LevelIndex> levels(level_count);
+  std::memcpy(levels.data(), file.data() + sizeof(Header),
+              levels.size() * sizeof(LevelIndex));
+
+  // Levels are stored smallest first, so the payload starts at the last one
+  u64 payload_begin = std::numeric_limits<u64>::max();
+  u64 payload_end = 0;
+  const auto alignment = std::lcm(texel_block_size(format), u64{4});
+  for (u32 level = 0; level < level_count; ++level) {
+    const auto offset = levels[level].byte_offset;
+    const auto length = levels[level].byte_length;
+    const auto expected = level_size(format, layout.extent, level);
+    if (length < expected || offset > file.size() ||
+        length > file.size() - offset || offset % alignment != 0) {
+      warn("KTX2 level {} at {} with {} bytes is invalid, expected {} bytes",
+           level, offset, length, expected);
+      return std::nullopt;
+    }
+    payload_begin = std::min(payload_begin, offset);
+    payload_end = std::max(payload_end, offset + length);
+  }
+
+  layout.payload_offset = payload_begin;
+  layout.payload_size = payload_end - payload_begin;
+  layout.level_offsets.reserve(level_count);
+  for (const auto &level : levels) {
+    layout.level_offsets.push_back(level.byte_offset - payload_begin);
+  }
+  return layout;
+}
+
+} // namespace Core
@@ -3,6 +3,7 @@
 #include "Logger.hpp"
 
 #include <cctype>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <string_view>
@@ -10,7 +11,14 @@
 
 namespace Core {
 
-Logger::Logger() : current_level(get_log_level_from_environment()) {
+Logger::Logger()
+    : current_level(get_log_level_from_environment()),
+      records(new Record[queue_capacity]) {
+  static_assert((queue_capacity & (queue_capacity - 1)) == 0,
+                "Queue capacity must be a power of two");
+  for (usize i = 0; i < queue_capacity; ++i) {
+    records[i].sequence.store(i, std::memory_order_relaxed);
+  }
   worker = std::jthread(
       [this](const std::stop_token &stop_token) { process_queue(stop_token); });
 }
@@ -26,34 +34,142 @@ Logger::~Logger() { stop_all(); }
 
 void Logger::stop_all() {
   // If the worker thread is already stopped, return
-  if (exit_flag)
+  if (exit_flag.exchange(true))
     return;
 
-  exit_flag = true;
+  {
+    std::scoped_lock lock(wake_mutex);
+  }
   cv.notify_one();
   worker.join();
 }
 
-void Logger::log(std::string &&message, LogLevel level) {
-  std::lock_guard lock(queue_mutex);
-  log_queue.emplace(std::move(message), level);
-  cv.notify_one();
+auto Logger::claim(u64 &position) -> Record & {
+  position = tail.load(std::memory_order_relaxed);
+  while (true) {
+    auto &record = records[position & (queue_capacity - 1)];
+    const auto sequence = record.sequence.load(std::memory_order_acquire);
+    const auto difference =
+        static_cast<i64>(sequence) - static_cast<i64>(position);
+    if (difference == 0) {
+      if (tail.compare_exchange_weak(position, position + 1,
+                                     std::memory_order_relaxed)) {
+        return record;
+      }
+    } else if (difference < 0) {
+      // Full, let the background thread catch up
+      {
+        std::scoped_lock lock(wake_mutex);
+      }
+      cv.notify_one();
+      std::this_thread::yield();
+      position = tail.load(std::memory_order_relaxed);
+    } else {
+      position = tail.load(std::memory_order_relaxed);
+    }
+  }
 }
 
-void Logger::process_queue(const std::stop_token &stop_token) {
-  while (!stop_token.stop_requested()) {
-    std::unique_lock lock(queue_mutex);
-    cv.wait(lock, [this] { return !log_queue.empty() || exit_flag; });
+void Logger::publish(Record &record, u64 position) {
+  const auto level = record.level;
+  record.sequence.store(position + 1, std::memory_order_release);
 
-    if (exit_flag && log_queue.empty())
+  // The background thread wakes up on its timer, only errors and a filling
+  // queue are worth waking it early for
+  if (!consumer_sleeping.load(std::memory_order_relaxed)) {
+    return;
+  }
+  const auto consumed = head.load(std::memory_order_relaxed);
+  const auto pending = position + 1 > consumed ? position + 1 - consumed : 0;
+  if (level == LogLevel::Error || pending >= queue_capacity / 2) {
+    cv.notify_one();
+  }
+}
+
+void Logger::write_immediately(LogLevel level, std::string_view message) {
+  std::string output;
+  append_line(level, message, output);
+  write(output);
+}
+
+void Logger::write(std::string_view output) {
+  if (const auto current = sink.load(); current != nullptr) {
+    current(output);
+    return;
+  }
+  std::fwrite(output.data(), 1, output.size(), stdout);
+  std::fflush(stdout);
+}
+
+auto Logger::drain(std::string &output) -> usize {
+  usize count = 0;
+  auto position = head.load(std::memory_order_relaxed);
+  while (true) {
+    auto &record = records[position & (queue_capacity - 1)];
+    if (record.sequence.load(std::memory_order_acquire) != position + 1) {
       break;
+    }
+
+    append_record(record, output);
+    if (record.level == LogLevel::Error) {
+      errors_pending = true;
+    }
+    record.overflow.clear();
+    record.sequence.store(position + queue_capacity,
+                          std::memory_order_release);
+    ++position;
+    head.store(position, std::memory_order_relaxed);
+    ++count;
+  }
+  return count;
+}
+
+void Logger::process_queue(const std::stop_token &stop_token) {
+  using Clock = std::chrono::steady_clock;
+
+  std::string output;
+  output.reserve(flush_threshold * 2);
+  auto last_flush = Clock::now();
 
-    while (!log_queue.empty()) {
-      auto &&log_message = log_queue.front();
-      process_single(log_message);
-      log_queue.pop();
+  const auto flush = [&] {
+    if (!output.empty()) {
+      write(output);
+      output.clear();
+    }
+    errors_pending = false;
+    last_flush = Clock::now();
+  };
+
+  while (!stop_token.stop_requested()) {
+    const auto drained = drain(output);
+    if (output.size() >= flush_threshold || errors_pending ||
+        Clock::now() - last_flush >= flush_interval) {
+      flush();
+    }
+
+    if (exit_flag) {
+      // Producers may still be finishing their records
+      if (drained == 0 && head.load() == tail.load()) {
+        break;
+      }
+      continue;
+    }
+    if (drained > 0) {
+      continue;
     }
+
+    std::unique_lock lock(wake_mutex);
+    consumer_sleeping = true;
+    // Only woken early by errors and a filling queue, see publish
+    cv.wait_for(lock, flush_interval, [this] {
+      return exit_flag || tail.load(std::memory_order_relaxed) !=
+                              head.load(std::memory_order_relaxed);
+    });
+    consumer_sleeping = false;
   }
+
+  drain(output);
+  flush();
 }
 
 namespace AnsiColor {
@@ -66,28 +182,54 @@ static constexpr auto Blue = "\033[34m"sv;    // Trace
 static constexpr auto Magenta = "\033[95m"sv; // Warn
 } // namespace AnsiColor
 
-void Logger::process_single(const BackgroundLogMessage &message) {
-  switch (message.level) {
+void Logger::append_record(const Record &record, std::string &output) {
+  if (record.formatter == nullptr) {
+    const auto message =
+        record.overflow.empty()
+            ? std::string_view{reinterpret_cast<const char *>(
+                                   record.payload.data()),
+                               record.size}
+            : std::string_view{record.overflow};
+    append_line(record.level, message, output);
+    return;
+  }
+
+  std::string message;
+  try {
+    record.formatter(record.format, record.payload.data(), message);
+  } catch (const std::exception &exception) {
+    message = fmt::format("Could not format '{}': {}", record.format,
+                          exception.what());
+  }
+  append_line(record.level, message, output);
+}
+
+void Logger::append_line(LogLevel level, std::string_view message,
+                         std::string &output) {
+  const auto append = [&](std::string_view colour, std::string_view tag) {
+    output += colour;
+    output += tag;
+    output += message;
+    output += AnsiColor::Reset;
+    output += '\n';
+  };
+
+  switch (level) {
     using enum Core::LogLevel;
   case Trace:
-    std::cout << AnsiColor::Blue << "[TRACE] " << message.message
-              << AnsiColor::Reset << std::endl;
+    append(AnsiColor::Blue, "[TRACE] ");
     break;
   case Debug:
-    std::cout << AnsiColor::Yellow << "[DEBUG] " << message.message
-              << AnsiColor::Reset << std::endl;
+    append(AnsiColor::Yellow, "[DEBUG] ");
     break;
   case Info:
-    std::cout << AnsiColor::Green << "[INFO] " << message.message
-              << AnsiColor::Reset << std::endl;
+    append(AnsiColor::Green, "[INFO] ");
     break;
   case Warn:
-    std::cout << AnsiColor::Magenta << "[WARN] " << message.message
-              << AnsiColor::Reset << std::endl;
+    append(AnsiColor::Magenta, "[WARN] ");
     break;
   case Error:
-    std::cout << AnsiColor::Red << "[ERROR] " << message.message
-              << AnsiColor::Reset << std::endl;
+    append(AnsiColor::Red, "[ERROR] ");
     break;
   case None:
     break;
@@ -96,6 +238,8 @@ void Logger::process_single(const BackgroundLogMessage &message) {
 
 void Logger::set_level(LogLevel level) { current_level = level; }
 
+void Logger::set_sink(Detail::LogSink new_sink) { sink = new_sink; }
+
 LogLevel Logger::get_level() const { return current_level; }
 
 auto to_lower(const std::string &str) {
@@ -0,0 +1,24 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "MappedFile.hpp"
+
+#include <memory>
+
+#ifdef _WIN32
+#include "windows/include/MappedFile.hpp"
+#else
+#include "linux/include/MappedFile.hpp"
+#endif
+
+namespace Core {
+
+auto MappedFile::construct(const FS::Path &path)
+    -> std::unique_ptr<MappedFile> {
+#ifdef _WIN32
+  return std::make_unique<Windows::MappedFile>(path);
+#else
+  return std::make_unique<Linux::MappedFile>(path);
+#endif
+}
+
+} // namespace Core
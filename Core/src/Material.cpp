@@ -2,12 +2,17 @@
 
 #include "Material.hpp"
 
+#include "BindlessTextures.hpp"
 #include "BufferSet.hpp"
 #include "CommandBuffer.hpp"
 #include "Config.hpp"
 #include "Containers.hpp"
+#include "ContentHash.hpp"
 #include "Pipeline.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <fmt/format.h>
 #include <string_view>
 #include <unordered_map>
 #include <vulkan/vulkan_core.h>
@@ -16,6 +21,10 @@
 
 namespace Core {
 
+namespace {
+std::atomic<u32> next_material_id{0};
+} // namespace
+
 auto Material::construct(const Device &device, const Shader &shader)
     -> Scope<Material> {
   return Scope<Material>(new Material(device, shader));
@@ -27,12 +36,19 @@ auto Material::construct_reference(const Device &device, const Shader &shader)
 }
 
 Material::Material(const Device &dev, const Shader &input_shader)
-    : device(&dev), shader(&input_shader),
+    : device(&dev), shader(&input_shader), id(next_material_id++),
       write_descriptors(Config::frame_count),
-      dirty_descriptor_sets(Config::frame_count, false) {
+      dirty_descriptor_sets(Config::frame_count, false),
+      persistent_sets(Config::frame_count),
+      descriptor_keys(Config::frame_count),
+      written_in_frame(Config::frame_count, 0),
+      transient_sets(Config::frame_count, false),
+      dynamic_offsets(Config::frame_count) {
   initialise_constant_buffer();
 }
 
+Material::~Material() { release_persistent_sets(); }
+
 auto Material::on_resize(const Extent<u32> &) -> void {
   initialise_constant_buffer();
   resident_descriptors.clear();
@@ -40,9 +56,11 @@ auto Material::on_resize(const Extent<u32> &) -> void {
   pending_descriptors.clear();
   texture_references.clear();
   image_references.clear();
+  bindless_textures.clear();
   write_descriptors.resize(write_descriptors.size());
   dirty_descriptor_sets.resize(dirty_descriptor_sets.size());
   identifiers.clear();
+  invalidate_descriptor_sets();
 }
 
 auto Material::construct_buffers() -> void {}
@@ -123,6 +141,7 @@ auto Material::bind_impl(const CommandBuffer &command_buffer,
                          const VkPipelineBindPoint &bind_point, u32 frame,
                          VkDescriptorSet additional_set) const -> void {
   auto &[frame_sets] = descriptor_sets.at(frame);
+  const auto &offsets = dynamic_offsets.at(frame);
 
   if (frame_sets.empty()) {
     return;
@@ -135,116 +154,204 @@ auto Material::bind_impl(const CommandBuffer &command_buffer,
 
   vkCmdBindDescriptorSets(command_buffer.get_command_buffer(), bind_point,
                           layout, 0, static_cast<u32>(copy.size()), copy.data(),
-                          0, nullptr);
+                          static_cast<u32>(offsets.size()), offsets.data());
 }
 
-auto Material::update_for_rendering(
-    FrameIndex frame_index, const std::vector<std::vector<VkWriteDescriptorSet>>
-                                &buffer_set_write_descriptors) -> void {
-  auto &frame_write_descriptors = write_descriptors[frame_index];
-
-  for (const auto &descriptor : resident_descriptors | std::views::values) {
-    if (descriptor->type == PendingDescriptorType::Image2D) {
-      auto &image = descriptor->image;
-      if (descriptor->write_set.pImageInfo != nullptr &&
-          image->get_descriptor_info().imageView !=
-              descriptor->write_set.pImageInfo->imageView) {
-        pending_descriptors.emplace_back(descriptor);
-        invalidate_descriptor_sets();
-      }
+auto Material::compute_descriptor_key(
+    const std::vector<VkWriteDescriptorSet> &buffer_writes) const -> usize {
+  usize key = 0;
+  for (const auto &write : buffer_writes) {
+    hash_combine(key, write.dstBinding);
+    if (write.pBufferInfo != nullptr) {
+      hash_combine(key, write.pBufferInfo->buffer);
+      hash_combine(key, write.pBufferInfo->offset);
+      hash_combine(key, write.pBufferInfo->range);
     }
   }
 
-  std::vector<VkDescriptorImageInfo> array_image_infos;
+  for (const auto &[binding, pd] : resident_descriptors) {
+    hash_combine(key, binding);
+    if (pd->type == PendingDescriptorType::Texture2D) {
+      hash_combine(key, pd->texture->hash());
+      hash_combine(key, pd->texture->get_image().hash());
+      hash_combine(key, pd->texture->get_image_info().imageLayout);
+    } else if (pd->type == PendingDescriptorType::Image2D) {
+      hash_combine(key, pd->image->hash());
+      hash_combine(key, pd->image->get_descriptor_info().imageLayout);
+    }
+  }
 
-  dirty_descriptor_sets[frame_index] = false;
-  frame_write_descriptors.clear();
+  for (const auto &[binding, pd] : resident_descriptor_arrays) {
+    hash_combine(key, binding);
+    for (const auto &texture : pd->textures) {
+      hash_combine(key, texture->hash());
+      hash_combine(key, texture->get_image().hash());
+    }
+  }
+  return key;
+}
 
-  if (!buffer_set_write_descriptors.empty()) {
-    for (const auto &write : buffer_set_write_descriptors[frame_index]) {
-      frame_write_descriptors.push_back(write);
+auto Material::release_persistent_sets() -> void {
+  const auto &descriptor_resource = device->get_descriptor_resource();
+  for (auto &frame_sets : persistent_sets) {
+    for (const auto &persistent : frame_sets) {
+      descriptor_resource->free_persistent_descriptor_set(persistent);
     }
+    frame_sets.clear();
   }
+  descriptor_sets.clear();
+  std::ranges::fill(descriptor_keys, std::nullopt);
+}
+
+auto Material::update_for_rendering(
+    FrameIndex frame_index,
+    const std::vector<std::vector<VkWriteDescriptorSet>>
+        &buffer_set_write_descriptors,
+    std::span<const u32> frame_dynamic_offsets) -> void {
+  refresh_bindless_indices();
+
+  auto &offsets = dynamic_offsets[frame_index];
+  offsets.assign(frame_dynamic_offsets.begin(), frame_dynamic_offsets.end());
+  offsets.resize(shader->get_dynamic_bindings().size(), 0);
+
+  static const std::vector<VkWriteDescriptorSet> no_buffer_writes{};
+  const auto &buffer_writes = buffer_set_write_descriptors.empty()
+                                  ? no_buffer_writes
+                                  : buffer_set_write_descriptors[frame_index];
+
+  // Nothing bound has changed since this frame in flight was last written,
+  // so its sets are still valid. Transient sets only live for one frame.
+  const auto key = compute_descriptor_key(buffer_writes);
+  const auto frame_counter =
+      device->get_descriptor_resource()->get_frame_counter();
+  const auto written_this_frame =
+      descriptor_keys[frame_index].has_value() &&
+      written_in_frame[frame_index] == frame_counter;
+  if (!dirty_descriptor_sets[frame_index] &&
+      descriptor_keys[frame_index] == key &&
+      (!transient_sets[frame_index] || written_this_frame)) {
+    return;
+  }
+
+  auto &frame_write_descriptors = write_descriptors[frame_index];
+  frame_write_descriptors.clear();
+  frame_write_descriptors.insert(frame_write_descriptors.end(),
+                                 buffer_writes.begin(), buffer_writes.end());
+  const auto buffer_write_count = frame_write_descriptors.size();
 
   for (const auto &pd : resident_descriptors | std::views::values) {
     if (pd->type == PendingDescriptorType::Texture2D) {
-      auto &texture = pd->texture;
-      pd->image_info = texture->get_image().get_descriptor_info();
-      pd->write_set.pImageInfo = &pd->image_info;
+      pd->image_info = pd->texture->get_image().get_descriptor_info();
     } else if (pd->type == PendingDescriptorType::Image2D) {
-      auto &image = pd->image;
-      pd->image_info = image->get_descriptor_info();
-      pd->write_set.pImageInfo = &pd->image_info;
+      pd->image_info = pd->image->get_descriptor_info();
     }
-
+    pd->write_set.pImageInfo = &pd->image_info;
     frame_write_descriptors.push_back(pd->write_set);
   }
 
   for (const auto &pd : resident_descriptor_arrays | std::views::values) {
+    pd->image_infos.clear();
     if (pd->type == PendingDescriptorType::Texture2D) {
       for (const auto &texture : pd->textures) {
-        array_image_infos.emplace_back(
+        pd->image_infos.emplace_back(
             texture->get_image().get_descriptor_info());
       }
     }
-    pd->write_set.pImageInfo = array_image_infos.data();
-    pd->write_set.descriptorCount = static_cast<u32>(array_image_infos.size());
+    pd->write_set.pImageInfo = pd->image_infos.data();
+    pd->write_set.descriptorCount = static_cast<u32>(pd->image_infos.size());
     frame_write_descriptors.push_back(pd->write_set);
   }
 
-  static constexpr auto is_image = [](const auto &write_set) {
-    return write_set.pImageInfo != nullptr;
+  // Buffers live in set 0 and images in set 1.
+  const auto writes = std::span{frame_write_descriptors};
+  const std::array<std::span<VkWriteDescriptorSet>, 2> writes_per_set{
+      writes.first(buffer_write_count),
+      writes.subspan(buffer_write_count),
   };
 
-  std::unordered_map<u32, std::vector<VkWriteDescriptorSet>> split_by_type;
-  split_by_type.try_emplace(0, 0);
-  split_by_type.try_emplace(1, 0);
+  // A set which may already be recorded this frame cannot be rewritten, so
+  // a mid-frame rebind gets transient sets from the per-frame pool instead.
+  auto &frame_sets = persistent_sets[frame_index];
+  auto &current_sets = descriptor_sets[frame_index].descriptor_sets;
+  current_sets.clear();
+  for (u32 set = 0; set < writes_per_set.size(); ++set) {
+    if (!shader->has_descriptor_set(set)) {
+      continue;
+    }
 
-  for (const auto &write_set : frame_write_descriptors) {
-    if (is_image(write_set)) {
-      split_by_type.at(1).push_back(write_set);
+    VkDescriptorSet target{nullptr};
+    if (written_this_frame) {
+      target = shader->allocate_descriptor_set(set).descriptor_sets.at(0);
     } else {
-      split_by_type.at(0).push_back(write_set);
+      if (frame_sets.size() <= set) {
+        frame_sets.resize(set + 1);
+      }
+      if (frame_sets[set].set == nullptr) {
+        frame_sets[set] = shader->allocate_persistent_descriptor_set(set);
+      }
+      target = frame_sets[set].set;
     }
-  }
 
-  auto &current_sets = descriptor_sets[frame_index].descriptor_sets;
-  current_sets = {};
-  if (shader->has_descriptor_set(0)) {
-    auto descriptor_set_0 = shader->allocate_descriptor_set(0);
-    std::ranges::for_each(
-        split_by_type.at(0).begin(), split_by_type.at(0).end(),
-        [&set = descriptor_set_0](VkWriteDescriptorSet &value) {
-          value.dstSet = set.descriptor_sets.at(0);
-        });
+    for (auto &write : writes_per_set[set]) {
+      write.dstSet = target;
+    }
     vkUpdateDescriptorSets(device->get_device(),
-                           static_cast<u32>(split_by_type.at(0).size()),
-                           split_by_type.at(0).data(), 0, nullptr);
+                           static_cast<u32>(writes_per_set[set].size()),
+                           writes_per_set[set].data(), 0, nullptr);
+    current_sets.push_back(target);
+  }
 
-    current_sets.push_back(descriptor_set_0.descriptor_sets.at(0));
+  if (shader->uses_bindless_textures()) {
+    current_sets.push_back(
+        device->get_bindless_textures()->get_descriptor_set());
   }
 
-  if (shader->has_descriptor_set(1)) {
-    auto descriptor_set_1 = shader->allocate_descriptor_set(1);
-    std::ranges::for_each(
-        split_by_type.at(1).begin(), split_by_type.at(1).end(),
-        [&set = descriptor_set_1](VkWriteDescriptorSet &value) {
-          value.dstSet = set.descriptor_sets.at(0);
-        });
-    vkUpdateDescriptorSets(device->get_device(),
-                           static_cast<u32>(split_by_type.at(1).size()),
-                           split_by_type.at(1).data(), 0, nullptr);
+  descriptor_keys[frame_index] = key;
+  written_in_frame[frame_index] = frame_counter;
+  transient_sets[frame_index] = written_this_frame;
+  dirty_descriptor_sets[frame_index] = false;
+  pending_descriptors.clear();
+}
 
-    current_sets.push_back(descriptor_set_1.descriptor_sets.at(0));
+auto Material::set_bindless(std::string_view name, const Image &image,
+                            const Texture *texture) -> bool {
+  auto *bindless = device->get_bindless_textures();
+  if (bindless == nullptr || !shader->uses_bindless_textures()) {
+    return false;
   }
 
-  pending_descriptors.clear();
+  const auto found = find_uniform(fmt::format("pc.{}", name));
+  if (!found) {
+    return false;
+  }
+
+  const auto offset = (*found)->get_offset();
+  const auto index = bindless->index_of(image);
+  constant_buffer.write(&index, sizeof(u32), offset);
+  if (texture != nullptr) {
+    bindless_textures.insert_or_assign(offset, texture);
+  } else {
+    bindless_textures.erase(offset);
+  }
+  return true;
+}
+
+auto Material::refresh_bindless_indices() -> void {
+  if (bindless_textures.empty()) {
+    return;
+  }
+
+  auto *bindless = device->get_bindless_textures();
+  for (const auto &[offset, texture] : bindless_textures) {
+    const auto index = bindless->index_of(texture->get_image());
+    constant_buffer.write(&index, sizeof(u32), offset);
+  }
 }
 
 auto Material::set(std::string_view name, const Texture &texture) -> bool {
   const auto resource = find_resource(name);
   if (!resource)
-    return false;
+    return set_bindless(name, texture.get_image(), &texture);
 
   const auto &found_resource = *resource;
   const u32 binding = found_resource->get_register();
@@ -278,7 +385,7 @@ auto Material::set(std::string_view name, const Texture &texture) -> bool {
 auto Material::set(const std::string_view name, const Image &image) -> bool {
   const auto resource = find_resource(name);
   if (!resource)
-    return false;
+    return set_bindless(name, image);
 
   const auto &found_resource = *resource;
 
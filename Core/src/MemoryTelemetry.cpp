@@ -0,0 +1,266 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "MemoryTelemetry.hpp"
+
+#include "Allocator.hpp"
+#include "Containers.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fmt/format.h>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <ranges>
+#include <vk_mem_alloc.h>
+
+namespace Core {
+
+namespace {
+
+struct CategoryCounters {
+  std::atomic<u64> live_bytes{0};
+  std::atomic<u64> live_allocations{0};
+  std::atomic<u64> peak_bytes{0};
+};
+
+struct TelemetryState {
+  std::array<CategoryCounters, memory_category_count> categories{};
+  std::atomic<u64> frame{0};
+  std::atomic<u32> allocations_this_frame{0};
+  std::atomic<u32> frees_this_frame{0};
+  std::atomic<u32> allocations_last_frame{0};
+  std::atomic<u32> frees_last_frame{0};
+
+  std::mutex resources_mutex{};
+  Container::StringLikeMap<NamedMemoryUsage> resources{};
+};
+
+auto state() -> TelemetryState & {
+  static TelemetryState telemetry{};
+  return telemetry;
+}
+
+auto counters(MemoryCategory category) -> CategoryCounters & {
+  return state().categories.at(static_cast<usize>(category));
+}
+
+auto escape_json(std::string_view text) -> std::string {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (const auto character : text) {
+    switch (character) {
+    case '"':
+      escaped += "\\\"";
+      break;
+    case '\\':
+      escaped += "\\\\";
+      break;
+    case '\n':
+      escaped += "\\n";
+      break;
+    default:
+      if (static_cast<unsigned char>(character) < 0x20) {
+        escaped += fmt::format("\\u{:04x}", static_cast<u32>(character));
+      } else {
+        escaped += character;
+      }
+    }
+  }
+  return escaped;
+}
+
+} // namespace
+
+auto to_string(MemoryCategory category) -> std::string_view {
+  switch (category) {
+    using enum MemoryCategory;
+  case Vertex:
+    return "vertex";
+  case Index:
+    return "index";
+  case Uniform:
+    return "uniform";
+  case Storage:
+    return "storage";
+  case Image:
+    return "image";
+  case Staging:
+    return "staging";
+  case Frame:
+    return "frame";
+  default:
+    return "other";
+  }
+}
+
+auto MemoryTelemetry::record_allocation(MemoryCategory category,
+                                        std::string_view name, u64 bytes)
+    -> void {
+  auto &category_counters = counters(category);
+  const auto live = category_counters.live_bytes.fetch_add(bytes) + bytes;
+  category_counters.live_allocations.fetch_add(1);
+  auto peak = category_counters.peak_bytes.load();
+  while (peak < live &&
+         !category_counters.peak_bytes.compare_exchange_weak(peak, live)) {
+  }
+  state().allocations_this_frame.fetch_add(1, std::memory_order_relaxed);
+
+  std::scoped_lock lock{state().resources_mutex};
+  auto &resources = state().resources;
+  auto found = resources.find(name);
+  if (found == resources.end()) {
+    found = resources
+                .try_emplace(std::string{name},
+                             NamedMemoryUsage{
+                                 .resource_name = std::string{name},
+                                 .category = category,
+                             })
+                .first;
+  }
+  found->second.live_bytes += bytes;
+  found->second.live_allocations++;
+}
+
+auto MemoryTelemetry::record_free(MemoryCategory category,
+                                  std::string_view name, u64 bytes) -> void {
+  auto &category_counters = counters(category);
+  category_counters.live_bytes.fetch_sub(bytes);
+  category_counters.live_allocations.fetch_sub(1);
+  state().frees_this_frame.fetch_add(1, std::memory_order_relaxed);
+
+  std::scoped_lock lock{state().resources_mutex};
+  auto &resources = state().resources;
+  const auto found = resources.find(name);
+  if (found == resources.end()) {
+    return;
+  }
+  found->second.live_bytes -= std::min(found->second.live_bytes, bytes);
+  if (--found->second.live_allocations == 0) {
+    resources.erase(found);
+  }
+}
+
+auto MemoryTelemetry::begin_frame() -> void {
+  auto &telemetry = state();
+  const auto frame = telemetry.frame.fetch_add(1) + 1;
+  telemetry.allocations_last_frame =
+      telemetry.allocations_this_frame.exchange(0);
+  telemetry.frees_last_frame = telemetry.frees_this_frame.exchange(0);
+
+  // Lets VMA refresh its budget numbers once per frame
+  if (auto *allocator = Allocator::get_allocator(); allocator != nullptr) {
+    vmaSetCurrentFrameIndex(allocator, static_cast<u32>(frame));
+  }
+}
+
+auto MemoryTelemetry::snapshot() -> MemorySnapshot {
+  auto &telemetry = state();
+  MemorySnapshot snapshot{
+      .frame = telemetry.frame.load(),
+      .allocations_last_frame = telemetry.allocations_last_frame.load(),
+      .frees_last_frame = telemetry.frees_last_frame.load(),
+  };
+  for (usize index = 0; index < memory_category_count; ++index) {
+    const auto &category_counters = telemetry.categories.at(index);
+    snapshot.categories.at(index) = {
+        .live_bytes = category_counters.live_bytes.load(),
+        .live_allocations = category_counters.live_allocations.load(),
+        .peak_bytes = category_counters.peak_bytes.load(),
+    };
+  }
+
+  {
+    std::scoped_lock lock{telemetry.resources_mutex};
+    snapshot.resources.reserve(telemetry.resources.size());
+    for (const auto &usage : telemetry.resources | std::views::values) {
+      snapshot.resources.push_back(usage);
+    }
+  }
+  std::ranges::sort(snapshot.resources, std::greater{},
+                    &NamedMemoryUsage::live_bytes);
+
+  auto *allocator = Allocator::get_allocator();
+  if (allocator == nullptr) {
+    return snapshot;
+  }
+
+  const VkPhysicalDeviceMemoryProperties *memory_properties{nullptr};
+  vmaGetMemoryProperties(allocator, &memory_properties);
+  std::vector<VmaBudget> budgets(memory_properties->memoryHeapCount);
+  vmaGetHeapBudgets(allocator, budgets.data());
+  for (u32 heap = 0; heap < memory_properties->memoryHeapCount; ++heap) {
+    const auto &budget = budgets.at(heap);
+    snapshot.heaps.push_back({
+        .heap_index = heap,
+        .device_local = (memory_properties->memoryHeaps[heap].flags &
+                         VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0,
+        .block_bytes = budget.statistics.blockBytes,
+        .allocation_bytes = budget.statistics.allocationBytes,
+        .usage = budget.usage,
+        .budget = budget.budget,
+    });
+  }
+  return snapshot;
+}
+
+auto MemoryTelemetry::to_json(const MemorySnapshot &snapshot) -> std::string {
+  std::string json;
+  auto out = std::back_inserter(json);
+  fmt::format_to(out,
+                 "{{\n  \"frame\": {},\n  \"allocations_last_frame\": {},\n"
+                 "  \"frees_last_frame\": {},\n  \"categories\": {{",
+                 snapshot.frame, snapshot.allocations_last_frame,
+                 snapshot.frees_last_frame);
+  for (usize index = 0; index < memory_category_count; ++index) {
+    const auto &usage = snapshot.categories.at(index);
+    fmt::format_to(out,
+                   "{}\n    \"{}\": {{\"live_bytes\": {}, "
+                   "\"live_allocations\": {}, \"peak_bytes\": {}}}",
+                   index == 0 ? "" : ",",
+                   to_string(static_cast<MemoryCategory>(index)),
+                   usage.live_bytes, usage.live_allocations, usage.peak_bytes);
+  }
+
+  fmt::format_to(out, "\n  }},\n  \"resources\": [");
+  for (usize index = 0; index < snapshot.resources.size(); ++index) {
+    const auto &usage = snapshot.resources.at(index);
+    fmt::format_to(out,
+                   "{}\n    {{\"name\": \"{}\", \"category\": \"{}\", "
+                   "\"live_bytes\": {}, \"live_allocations\": {}}}",
+                   index == 0 ? "" : ",", escape_json(usage.resource_name),
+                   to_string(usage.category), usage.live_bytes,
+                   usage.live_allocations);
+  }
+
+  fmt::format_to(out, "\n  ],\n  \"heaps\": [");
+  for (usize index = 0; index < snapshot.heaps.size(); ++index) {
+    const auto &heap = snapshot.heaps.at(index);
+    fmt::format_to(out,
+                   "{}\n    {{\"index\": {}, \"device_local\": {}, "
+                   "\"block_bytes\": {}, \"allocation_bytes\": {}, "
+                   "\"usage\": {}, \"budget\": {}}}",
+                   index == 0 ? "" : ",", heap.heap_index, heap.device_local,
+                   heap.block_bytes, heap.allocation_bytes, heap.usage,
+                   heap.budget);
+  }
+  fmt::format_to(out, "\n  ]\n}}\n");
+  return json;
+}
+
+auto MemoryTelemetry::dump_json(const FS::Path &path) -> bool {
+  const auto json = to_json(snapshot());
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  file.write(json.data(), static_cast<std::streamsize>(json.size()));
+  if (!file) {
+    warn("Failed to write memory telemetry to {}", path);
+    return false;
+  }
+
+  info("Wrote memory telemetry to {}", path);
+  return true;
+}
+
+} // namespace Core
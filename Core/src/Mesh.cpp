@@ -2,9 +2,14 @@
 
 #include "Mesh.hpp"
 
+#include "Config.hpp"
+#include "JobSystem.hpp"
 #include "Logger.hpp"
 #include "Material.hpp"
+#include "MeshCache.hpp"
 #include "SceneRenderer.hpp"
+#include "StagingUploader.hpp"
+#include "TextureStreamer.hpp"
 
 #include <assimp/DefaultLogger.hpp>
 #include <assimp/Importer.hpp>
@@ -15,7 +20,10 @@
 #include <assimp/scene.h>
 #include <assimp/texture.h>
 #include <assimp/types.h>
+#include <atomic>
+#include <optional>
 #include <stb_image.h>
+#include <string_view>
 
 namespace Core {
 
@@ -41,6 +49,16 @@ auto Mesh::get_material(u32 index) const -> Material * {
   return nullptr;
 }
 
+auto Mesh::get_streamed_textures(u32 submesh_index) const
+    -> std::span<const Texture *const> {
+  if (const auto it = submesh_to_material_index.find(submesh_index);
+      it != submesh_to_material_index.end() &&
+      it->second < material_textures.size()) {
+    return material_textures.at(it->second);
+  }
+  return {};
+}
+
 struct InMemoryImageLoader {
   explicit InMemoryImageLoader(const void *input_data,
                                std::integral auto input_width,
@@ -161,6 +179,8 @@ auto traverse_nodes(auto &submeshes, auto &importer, aiNode *node,
   }
 }
 
+static std::atomic<u32> next_mesh_id{0};
+
 static constexpr u32 mesh_import_flags =
     aiProcess_Triangulate | aiProcess_GenUVCoords | aiProcess_CalcTangentSpace |
     aiProcess_OptimizeMeshes | aiProcess_OptimizeGraph | aiProcess_FlipUVs;
@@ -171,24 +191,78 @@ auto Mesh::import_from(const Device &device, const FS::Path &file_path)
 }
 
 Mesh::Mesh(const Device &dev, const FS::Path &path)
-    : device(&dev), file_path(path) {
+    : device(&dev), file_path(path), id(next_mesh_id++) {
+  default_shader = SceneRenderer::construct_geometry_shader(*device);
+
+  std::vector<MeshMaterial> material_descriptions;
+  const auto cache_key = MeshCache::key_for(file_path, mesh_import_flags);
+  if (auto cached = cache_key ? MeshCache::load(file_path, *cache_key)
+                              : std::nullopt) {
+    // Straight from the mapped file into the GPU buffers
+    submeshes = std::move(cached->submeshes);
+    material_descriptions = std::move(cached->materials);
+    create_buffers(cached->vertices, cached->indices);
+    debug("Loaded mesh '{}' from the mesh cache", file_path.filename());
+  } else {
+    if (!import_with_assimp(material_descriptions)) {
+      return;
+    }
+    create_buffers(vertices, indices);
+
+    if (cache_key) {
+      MeshCache::store(file_path, *cache_key, vertices, indices, submeshes,
+                       material_descriptions);
+    }
+  }
+
+  for (u32 submesh_index = 0; submesh_index < submeshes.size();
+       submesh_index++) {
+    const auto &submesh = submeshes[submesh_index];
+    submesh_indices.push_back(submesh_index);
+    material_to_submesh_indices[submesh.material_index].push_back(
+        submesh_index);
+    submesh_to_material_index[submesh_index] = submesh.material_index;
+
+    const auto &submesh_aabb = submesh.bounding_box;
+    const auto min = glm::vec3(submesh.transform * submesh_aabb.min_vector());
+    const auto max = glm::vec3(submesh.transform * submesh_aabb.max_vector());
+    bounding_box.update(min, max);
+  }
+
+  stream_textures(material_descriptions);
+
+  materials.reserve(material_descriptions.size());
+  material_textures.reserve(material_descriptions.size());
+  for (const auto &description : material_descriptions) {
+    materials.push_back(bind_material(description));
+
+    auto &textures = material_textures.emplace_back();
+    for (const auto *key : {&description.albedo_map, &description.normal_map,
+                            &description.metallic_map}) {
+      if (const auto found = mesh_owned_textures.find(*key);
+          found != mesh_owned_textures.end()) {
+        textures.push_back(found->second.get());
+      }
+    }
+  }
+}
+
+auto Mesh::import_with_assimp(std::vector<MeshMaterial> &material_descriptions)
+    -> bool {
   importer = make_scope<ImporterImpl, Mesh::Deleter>();
   importer->importer = make_scope<Assimp::Importer>();
 
-  default_shader = Shader::construct(*device, FS::shader("Basic.vert.spv"),
-                                     FS::shader("Basic.frag.spv"));
-
   const aiScene *loaded_scene =
       importer->importer->ReadFile(file_path.string(), mesh_import_flags);
   if (loaded_scene == nullptr) {
     error("Mesh", "Failed to load mesh file: {0}", file_path.string());
-    return;
+    return false;
   }
 
   importer->scene = loaded_scene;
 
   if (!importer->scene->HasMeshes()) {
-    return;
+    return false;
   }
 
   u32 vertex_count = 0;
@@ -198,7 +272,7 @@ Mesh::Mesh(const Device &dev, const FS::Path &path)
 
   submeshes.reserve(num_meshes);
   for (u32 submesh_index = 0; submesh_index < num_meshes; submesh_index++) {
-    aiMesh *mesh = importer->scene->mMeshes[submesh_index];
+    const aiMesh *mesh = importer->scene->mMeshes[submesh_index];
 
     Submesh &submesh = submeshes.emplace_back();
     submesh.base_vertex = vertex_count;
@@ -207,312 +281,246 @@ Mesh::Mesh(const Device &dev, const FS::Path &path)
     submesh.vertex_count = mesh->mNumVertices;
     submesh.index_count = mesh->mNumFaces * 3;
     // submesh.mesh_name = mesh->mName.C_Str();
-    submesh_indices.push_back(submesh_index);
-    material_to_submesh_indices[submesh.material_index].push_back(
-        submesh_index);
-    submesh_to_material_index[submesh_index] = submesh.material_index;
 
     vertex_count += mesh->mNumVertices;
     index_count += submesh.index_count;
 
     ensure(mesh->HasPositions(), "Meshes require positions.");
     ensure(mesh->HasNormals(), "Meshes require normals.");
-
-    // Vertices
-    auto &submesh_aabb = submesh.bounding_box;
-    for (std::size_t i = 0; i < mesh->mNumVertices; i++) {
-      Vertex vertex{};
-      vertex.pos = {mesh->mVertices[i].x, mesh->mVertices[i].y,
-                    mesh->mVertices[i].z};
-      vertex.normals = {mesh->mNormals[i].x, mesh->mNormals[i].y,
-                        mesh->mNormals[i].z};
-      submesh_aabb.update(vertex.pos);
-
-      if (mesh->HasTangentsAndBitangents()) {
-        vertex.tangents = {mesh->mTangents[i].x, mesh->mTangents[i].y,
-                           mesh->mTangents[i].z};
-        vertex.bitangents = {mesh->mBitangents[i].x, mesh->mBitangents[i].y,
-                             mesh->mBitangents[i].z};
-      }
-
-      if (mesh->HasTextureCoords(0)) {
-        vertex.uvs = {mesh->mTextureCoords[0][i].x,
-                      mesh->mTextureCoords[0][i].y};
-      }
-
-      vertices.push_back(vertex);
-    }
-
-    // Indices
-    for (std::size_t i = 0; i < mesh->mNumFaces; i++) {
-      ensure(mesh->mFaces[i].mNumIndices == 3, "Must have 3 indices.");
-      const Index index = {
-          mesh->mFaces[i].mIndices[0],
-          mesh->mFaces[i].mIndices[1],
-          mesh->mFaces[i].mIndices[2],
-      };
-      indices.push_back(index);
-    }
   }
 
-  vertex_buffer = Buffer::construct(*device, vertices.size() * sizeof(Vertex),
-                                    Buffer::Type::Vertex, 0);
-  vertex_buffer->write(std::span{vertices});
-  index_buffer = Buffer::construct(*device, indices.size() * sizeof(Index),
-                                   Buffer::Type::Index, 0);
-  index_buffer->write(std::span{indices});
+  // Every submesh owns a disjoint range of the vertex and index arrays, so
+  // the conversions can run concurrently.
+  vertices.resize(vertex_count);
+  indices.resize(index_count / 3);
+  JobSystem::parallel_for(0, num_meshes, 1, [this](usize submesh_index) {
+    convert_submesh(*importer->scene->mMeshes[submesh_index],
+                    submeshes[submesh_index]);
+  }).wait();
 
   traverse_nodes(submeshes, importer, importer->scene->mRootNode);
 
-  for (const auto &submesh : submeshes) {
-    const auto &submesh_aabb = submesh.bounding_box;
-    const auto min = glm::vec3(submesh.transform * submesh_aabb.min_vector());
-    const auto max = glm::vec3(submesh.transform * submesh_aabb.max_vector());
-
-    bounding_box.update(min, max);
-  }
-
-  // Materials
-  const auto &white_texture = SceneRenderer::get_white_texture();
-  const auto num_materials = importer->scene->mNumMaterials;
-  const std::span materials_span{importer->scene->mMaterials, num_materials};
-
+  const std::span materials_span{importer->scene->mMaterials,
+                                 importer->scene->mNumMaterials};
   if (materials_span.empty()) {
-    auto submesh_material =
-        Material::construct_reference(*device, *default_shader);
-
-    static constexpr auto default_roughness_and_albedo = 0.8F;
-    auto vec_default_roughness_and_albedo = glm::vec3(0.8F);
-    submesh_material->set("pc.albedo_colour", vec_default_roughness_and_albedo);
-    submesh_material->set("pc.emission", 0.1F);
-    submesh_material->set("pc.metalness", 0.1F);
-    submesh_material->set("pc.roughness", default_roughness_and_albedo);
-    submesh_material->set("pc.use_normal_map", 0.0F);
-
-    submesh_material->set("albedo_map", white_texture);
-    submesh_material->set("diffuse_map", white_texture);
-    submesh_material->set("normal_map", white_texture);
-    submesh_material->set("metallic_map", white_texture);
-    submesh_material->set("roughness_map", white_texture);
-    submesh_material->set("ao_map", white_texture);
-    submesh_material->set("specular_map", white_texture);
-    materials.push_back(submesh_material);
-
-    return;
+    material_descriptions.push_back({
+        .albedo_colour = glm::vec4{0.8F, 0.8F, 0.8F, 1.0F},
+        .emission = 0.1F,
+        .metalness = 0.1F,
+        .roughness = 0.8F,
+    });
+    return true;
   }
 
-  materials.resize(num_materials);
-
-  std::size_t i = 0;
+  material_descriptions.reserve(materials_span.size());
   for (const auto *ai_material : materials_span) {
-    auto ai_material_name = ai_material->GetName();
-    // convert to std::string
-    const std::string material_name = ai_material_name.C_Str();
-
-    auto submesh_material =
-        Material::construct_reference(*device, *default_shader);
-    materials[i++] = submesh_material;
-    submesh_material->set("albedo_map", white_texture);
-    submesh_material->set("diffuse_map", white_texture);
-    submesh_material->set("normal_map", white_texture);
-    submesh_material->set("metallic_map", white_texture);
-    submesh_material->set("roughness_map", white_texture);
-    submesh_material->set("ao_map", white_texture);
-    submesh_material->set("specular_map", white_texture);
-
-    aiString ai_tex_path;
-    glm::vec4 albedo_colour{0.8F, 0.8F, 0.8F, 1.0F};
-    float emission = 0.2F;
-    if (aiColor3D ai_colour;
-        ai_material->Get(AI_MATKEY_COLOR_DIFFUSE, ai_colour) == AI_SUCCESS) {
-      albedo_colour = {ai_colour.r, ai_colour.g, ai_colour.b, 1.0F};
-    }
-
-    if (aiColor3D ai_emission;
-        ai_material->Get(AI_MATKEY_COLOR_EMISSIVE, ai_emission) == AI_SUCCESS) {
-      emission = ai_emission.r;
-    }
+    material_descriptions.push_back(describe_material(*ai_material));
+  }
+  return true;
+}
 
-    submesh_material->set("pc.albedo_colour", albedo_colour);
-    submesh_material->set("pc.emission", emission);
+auto Mesh::create_buffers(std::span<const Vertex> vertex_data,
+                          std::span<const Index> index_data) -> void {
+  // Geometry is immutable after import, keep it in device-local memory and
+  // upload both buffers in one staging submission.
+  const auto upload_batch = device->get_staging_uploader().batch();
+  const auto name = file_path.filename().string();
+  vertex_buffer = Buffer::construct(
+      *device, vertex_data.size_bytes(), Buffer::Type::Vertex, 0,
+      Buffer::Mode::Static, Buffer::Role::Data, name + " Vertices");
+  vertex_buffer->write(vertex_data);
+  index_buffer = Buffer::construct(
+      *device, index_data.size_bytes(), Buffer::Type::Index, 0,
+      Buffer::Mode::Static, Buffer::Role::Data, name + " Indices");
+  index_buffer->write(index_data);
+}
 
-    float shininess{};
-    float metalness{0.0F};
-    if (ai_material->Get(AI_MATKEY_SHININESS, shininess) != aiReturn_SUCCESS) {
-      shininess = 80.0F; // Default value
+void Mesh::convert_submesh(const aiMesh &mesh, Submesh &submesh) {
+  auto &submesh_aabb = submesh.bounding_box;
+  for (u32 i = 0; i < mesh.mNumVertices; i++) {
+    Vertex &vertex = vertices[submesh.base_vertex + i];
+    vertex.pos = {mesh.mVertices[i].x, mesh.mVertices[i].y,
+                  mesh.mVertices[i].z};
+    vertex.normals = {mesh.mNormals[i].x, mesh.mNormals[i].y,
+                      mesh.mNormals[i].z};
+    submesh_aabb.update(vertex.pos);
+
+    if (mesh.HasTangentsAndBitangents()) {
+      vertex.tangents = {mesh.mTangents[i].x, mesh.mTangents[i].y,
+                         mesh.mTangents[i].z};
+      vertex.bitangents = {mesh.mBitangents[i].x, mesh.mBitangents[i].y,
+                           mesh.mBitangents[i].z};
     }
 
-    if (ai_material->Get(AI_MATKEY_REFLECTIVITY, metalness) !=
-        aiReturn_SUCCESS) {
-      metalness = 0.0F;
+    if (mesh.HasTextureCoords(0)) {
+      vertex.uvs = {mesh.mTextureCoords[0][i].x, mesh.mTextureCoords[0][i].y};
     }
+  }
 
-    handle_albedo_map(white_texture, ai_material, *submesh_material,
-                      ai_tex_path);
-    handle_normal_map(white_texture, ai_material, *submesh_material,
-                      ai_tex_path);
-
-    auto roughness = 1.0F - glm::sqrt(shininess / 100.0f);
-    handle_roughness_map(white_texture, ai_material, *submesh_material,
-                         ai_tex_path, roughness);
-    handle_metalness_map(white_texture, ai_material, *submesh_material,
-                         metalness);
+  const auto first_face = submesh.base_index / 3;
+  for (u32 i = 0; i < mesh.mNumFaces; i++) {
+    ensure(mesh.mFaces[i].mNumIndices == 3, "Must have 3 indices.");
+    indices[first_face + i] = {
+        mesh.mFaces[i].mIndices[0],
+        mesh.mFaces[i].mIndices[1],
+        mesh.mFaces[i].mIndices[2],
+    };
   }
 }
 
-void Mesh::handle_albedo_map(const Texture &white_texture,
-                             const aiMaterial *ai_material,
-                             Material &submesh_material, aiString ai_tex_path) {
-  const bool has_albedo_map =
-      ai_material->GetTexture(aiTextureType_DIFFUSE, 0, &ai_tex_path) ==
-      AI_SUCCESS;
-  auto fallback = !has_albedo_map;
-  if (const std::string key = ai_tex_path.C_Str(); has_albedo_map) {
-    bool texture = false;
-    if (const auto *ai_texture_embedded =
-            importer->scene->GetEmbeddedTexture(key.c_str())) {
-      ensure(false, "No support for embedded textures");
-    } else {
-      mesh_owned_textures.try_emplace(key, read_texture_from_file_path(key));
-      texture = true;
-    }
+auto Mesh::describe_material(const aiMaterial &ai_material) const
+    -> MeshMaterial {
+  MeshMaterial description{};
+  if (aiColor3D ai_colour;
+      ai_material.Get(AI_MATKEY_COLOR_DIFFUSE, ai_colour) == AI_SUCCESS) {
+    description.albedo_colour = {ai_colour.r, ai_colour.g, ai_colour.b, 1.0F};
+  }
 
-    if (texture) {
-      info("{}", key);
-      const auto &texture = mesh_owned_textures.at(key);
-      submesh_material.set("albedo_map", *texture);
-      auto albedo_colour = glm::vec3(1.0F);
-      submesh_material.set("pc.albedo_colour", albedo_colour);
-    } else {
-      fallback = true;
-    }
+  if (aiColor3D ai_emission;
+      ai_material.Get(AI_MATKEY_COLOR_EMISSIVE, ai_emission) == AI_SUCCESS) {
+    description.emission = ai_emission.r;
   }
 
-  if (fallback) {
-    submesh_material.set("albedo_map", white_texture);
+  float shininess{};
+  if (ai_material.Get(AI_MATKEY_SHININESS, shininess) != aiReturn_SUCCESS) {
+    shininess = 80.0F; // Default value
   }
-}
+  description.roughness = 1.0F - glm::sqrt(shininess / 100.0f);
 
-void Mesh::handle_normal_map(const Texture &white_texture,
-                             const aiMaterial *ai_material,
-                             Material &submesh_material, aiString ai_tex_path) {
-  auto has_normal_map = ai_material->GetTexture(aiTextureType_NORMALS, 0,
-                                                &ai_tex_path) == AI_SUCCESS;
-  auto fallback = !has_normal_map;
-  if (const std::string key = ai_tex_path.C_Str(); has_normal_map) {
-    bool texture = false;
-    if (const auto *ai_texture_embedded =
-            importer->scene->GetEmbeddedTexture(ai_tex_path.C_Str())) {
-      ensure(false, "Embedded textures are not supported.");
-    } else {
-      mesh_owned_textures.try_emplace(key, read_texture_from_file_path(key));
-      texture = true;
-    }
+  if (ai_material.Get(AI_MATKEY_REFLECTIVITY, description.metalness) !=
+      aiReturn_SUCCESS) {
+    description.metalness = 0.0F;
+  }
 
-    if (texture) {
-      submesh_material.set("normal_map", *mesh_owned_textures.at(key));
-      submesh_material.set("pc.use_normal_map", 1.0F);
-    } else {
-      fallback = true;
+  const auto texture_path =
+      [&](aiTextureType type) -> std::optional<std::string> {
+    aiString ai_tex_path;
+    if (ai_material.GetTexture(type, 0, &ai_tex_path) != AI_SUCCESS) {
+      return std::nullopt;
     }
+    ensure(importer->scene->GetEmbeddedTexture(ai_tex_path.C_Str()) ==
+               nullptr,
+           "Embedded textures are not supported.");
+    return ai_tex_path.C_Str();
+  };
+
+  if (auto albedo_map = texture_path(aiTextureType_DIFFUSE)) {
+    description.albedo_map = std::move(*albedo_map);
+    description.albedo_colour = glm::vec4{1.0F};
   }
 
-  if (fallback) {
-    submesh_material.set("normal_map", white_texture);
-    submesh_material.set("pc.use_normal_map", 0.0F);
+  if (auto normal_map = texture_path(aiTextureType_NORMALS)) {
+    description.normal_map = std::move(*normal_map);
+    description.use_normal_map = 1.0F;
   }
-}
 
-void Mesh::handle_roughness_map(const Texture &white_texture,
-                                const aiMaterial *ai_material,
-                                Material &submesh_material,
-                                aiString ai_tex_path, float roughness) {
-  const auto has_roughness_map =
-      ai_material->GetTexture(aiTextureType_SHININESS, 0, &ai_tex_path) ==
-      AI_SUCCESS;
-  auto fallback = !has_roughness_map;
-  if (const std::string key = ai_tex_path.C_Str(); has_roughness_map) {
-    bool texture = false;
-    if (const auto *ai_texture_embedded =
-            importer->scene->GetEmbeddedTexture(ai_tex_path.C_Str())) {
-      ensure(false, "Embedded textures are not supported.");
-
-    } else {
-      mesh_owned_textures.try_emplace(key, read_texture_from_file_path(key));
+  for (u32 property_index = 0; property_index < ai_material.mNumProperties;
+       property_index++) {
+    const auto *prop = ai_material.mProperties[property_index];
+    if (prop->mType != aiPTI_String ||
+        std::string_view{prop->mKey.data} != "$raw.ReflectionFactor|file") {
+      continue;
     }
 
-    if (texture) {
-      submesh_material.set("roughness_map", *mesh_owned_textures.at(key));
-      submesh_material.set("pc.roughness", 1.0F);
-    } else {
-      fallback = true;
-    }
+    const auto str_length = *std::bit_cast<u32 *>(prop->mData);
+    std::string str(prop->mData + 4, str_length);
+    ensure(importer->scene->GetEmbeddedTexture(str.data()) == nullptr,
+           "Embedded textures are not supported.");
+    description.metallic_map = std::move(str);
+    description.metalness = 1.0F;
+    break;
   }
 
-  if (fallback) {
-    submesh_material.set("roughness_map", white_texture);
-    submesh_material.set("pc.roughness", roughness);
-  }
+  return description;
 }
 
-void Mesh::handle_metalness_map(const Texture &white_texture,
-                                const aiMaterial *ai_material,
-                                Material &submesh_material, float metalness) {
-  bool has_metalness_texture = false;
-  for (u32 property_index = 0; property_index < ai_material->mNumProperties;
-       property_index++) {
-    if (const auto *prop = ai_material->mProperties[property_index];
-        prop->mType == aiPTI_String) {
-      const auto str_length = *std::bit_cast<u32 *>(prop->mData);
-      std::string str(prop->mData + 4, str_length);
-
-      if (const std::string key = prop->mKey.data;
-          key == "$raw.ReflectionFactor|file") {
-        bool texture = false;
-        if (const auto *ai_texture_embedded =
-                importer->scene->GetEmbeddedTexture(str.data())) {
-          ensure(false, "Embedded textures are not supported.");
-        } else {
-          mesh_owned_textures.try_emplace(key,
-                                          read_texture_from_file_path(str));
-          texture = true;
-        }
-
-        if (texture) {
-          has_metalness_texture = true;
-          submesh_material.set("metallic_map", *mesh_owned_textures.at(key));
-          submesh_material.set("pc.metalness", 1.0F);
-        } else {
-          error("Mesh", "Could not load texture: {0}", str);
-        }
-        break;
+void Mesh::stream_textures(std::span<const MeshMaterial> descriptions) {
+  // BC7 keeps every channel, so the shaders sample these like RGBA8
+  const auto compress =
+      Config::compress_mesh_textures &&
+      device->check_support(Feature::TextureCompressionBC);
+
+  // Every referenced file is decoded once, on the JobSystem. Compressed
+  // textures are transcoded on first use and read from the texture cache
+  // afterwards, others get their mip chain built on the CPU.
+  auto &streamer = device->get_texture_streamer();
+  for (const auto &description : descriptions) {
+    for (const auto *key : {&description.albedo_map, &description.normal_map,
+                            &description.metallic_map}) {
+      if (key->empty() || mesh_owned_textures.contains(*key)) {
+        continue;
       }
+
+      const TextureProperties properties{
+          .format = ImageFormat::UNORM_RGBA8,
+          .path = resolve_texture_path(*key),
+          .usage = ImageUsage::Sampled | ImageUsage::TransferDst |
+                   ImageUsage::TransferSrc,
+          .layout = ImageLayout::ShaderReadOnlyOptimal,
+      };
+      mesh_owned_textures.try_emplace(
+          *key,
+          streamer.stream(
+              properties,
+              [path = properties.path,
+               compress]() -> std::optional<CompressedTexture> {
+                if (compress) {
+                  if (auto compressed = TextureCompressor::load_or_compress(
+                          path, ImageFormat::BC7_UNORM, true)) {
+                    return compressed;
+                  }
+                }
+
+                Extent<u32> extent{};
+                const auto pixels = load_databuffer_from_file(path, extent);
+                if (!pixels.valid()) {
+                  return std::nullopt;
+                }
+                return TextureCompressor::compress(
+                    pixels.span(), extent, ImageFormat::UNORM_RGBA8,
+                    TextureCompressor::full_level_count(extent));
+              }));
     }
   }
+}
 
-  auto fallback = !has_metalness_texture;
-  if (fallback) {
-    submesh_material.set("metallic_map", white_texture);
-    submesh_material.set("pc.metalness", metalness);
-  }
+auto Mesh::bind_material(const MeshMaterial &description) -> Ref<Material> {
+  const auto &white_texture = SceneRenderer::get_white_texture();
+  const auto texture_or_white = [&](const std::string &key) -> const Texture & {
+    if (key.empty()) {
+      return white_texture;
+    }
+    return *mesh_owned_textures.at(key);
+  };
+
+  auto submesh_material =
+      Material::construct_reference(*device, *default_shader);
+  submesh_material->set("albedo_map", texture_or_white(description.albedo_map));
+  submesh_material->set("diffuse_map", white_texture);
+  submesh_material->set("normal_map", texture_or_white(description.normal_map));
+  submesh_material->set("metallic_map",
+                        texture_or_white(description.metallic_map));
+  submesh_material->set("roughness_map", white_texture);
+  submesh_material->set("ao_map", white_texture);
+  submesh_material->set("specular_map", white_texture);
+
+  submesh_material->set("pc.albedo_colour", description.albedo_colour);
+  submesh_material->set("pc.emission", description.emission);
+  submesh_material->set("pc.metalness", description.metalness);
+  submesh_material->set("pc.roughness", description.roughness);
+  submesh_material->set("pc.use_normal_map", description.use_normal_map);
+  return submesh_material;
 }
 
-auto Mesh::read_texture_from_file_path(const std::string &texture_path) const
-    -> Scope<Texture> {
+auto Mesh::resolve_texture_path(const std::string &texture_path) const
+    -> FS::Path {
   auto path = FS::resolve(file_path.parent_path() / texture_path);
 
   if (!FS::exists(path)) {
     path = FS::resolve(file_path.parent_path() / "textures" / texture_path);
   }
 
-  return Texture::construct_shader(
-      *device, {
-                   .format = ImageFormat::UNORM_RGBA8,
-                   .path = path,
-                   .usage = ImageUsage::Sampled | ImageUsage::TransferDst |
-                            ImageUsage::TransferSrc,
-                   .layout = ImageLayout::ShaderReadOnlyOptimal,
-               });
+  return path;
 }
 
 } // namespace Core
@@ -0,0 +1,276 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "MeshCache.hpp"
+
+#include "ContentHash.hpp"
+#include "DataBuffer.hpp"
+#include "Logger.hpp"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+
+namespace Core {
+
+namespace {
+
+static_assert(std::is_trivially_copyable_v<Vertex>);
+static_assert(std::is_trivially_copyable_v<Index>);
+static_assert(std::is_trivially_copyable_v<Submesh>);
+
+constexpr std::array<char, 4> magic{'V', 'K', 'M', 'C'};
+
+struct Header {
+  std::array<char, 4> magic{};
+  u32 version{0};
+  u64 key{0};
+  // Layout changes of the stored structs invalidate the entry as well
+  u32 vertex_stride{0};
+  u32 index_stride{0};
+  u32 submesh_stride{0};
+  u32 material_count{0};
+  u64 vertex_count{0};
+  u64 index_count{0};
+  u64 submesh_count{0};
+  u64 payload_size{0};
+  u64 payload_hash{0};
+};
+
+struct MaterialRecord {
+  glm::vec4 albedo_colour{};
+  float emission{};
+  float metalness{};
+  float roughness{};
+  float use_normal_map{};
+};
+
+class PayloadWriter {
+public:
+  auto write(const void *data, usize size) -> void {
+    const auto *bytes = static_cast<const u8 *>(data);
+    payload.insert(payload.end(), bytes, bytes + size);
+  }
+
+  template <typename T> auto write(std::span<const T> values) -> void {
+    write(values.data(), values.size_bytes());
+  }
+
+  auto write(const std::string &value) -> void {
+    const auto length = static_cast<u32>(value.size());
+    write(&length, sizeof(length));
+    write(value.data(), value.size());
+  }
+
+  [[nodiscard]] auto get_payload() const -> const auto & { return payload; }
+
+private:
+  std::vector<u8> payload{};
+};
+
+class PayloadReader {
+public:
+  explicit PayloadReader(std::span<const u8> input) : payload(input) {}
+
+  [[nodiscard]] auto read(usize size) -> std::span<const u8> {
+    if (failed || offset + size > payload.size()) {
+      failed = true;
+      return {};
+    }
+    const auto bytes = payload.subspan(offset, size);
+    offset += size;
+    return bytes;
+  }
+
+  template <typename T> auto read_into(T &value) -> void {
+    if (const auto bytes = read(sizeof(T)); !bytes.empty()) {
+      std::memcpy(&value, bytes.data(), sizeof(T));
+    }
+  }
+
+  auto read_into(std::string &value) -> void {
+    u32 length{0};
+    read_into(length);
+    const auto bytes = read(length);
+    value.assign(bytes.begin(), bytes.end());
+  }
+
+  [[nodiscard]] auto ok() const -> bool { return !failed; }
+
+private:
+  std::span<const u8> payload;
+  usize offset{0};
+  bool failed{false};
+};
+
+} // namespace
+
+auto MeshCache::path_for(const FS::Path &source) -> FS::Path {
+  // Disambiguates models with the same file name in different directories
+  const auto absolute = FS::resolve(source).string();
+  const auto path_hash = content_hash(
+      {reinterpret_cast<const u8 *>(absolute.data()), absolute.size()});
+  return FS::mesh_cache(fmt::format("{}-{:016x}.vkmesh",
+                                    source.stem().string(), path_hash));
+}
+
+auto MeshCache::key_for(const FS::Path &source, u32 import_flags)
+    -> std::optional<u64> {
+  const auto source_file = MappedFile::construct(source);
+  if (!source_file->is_valid()) {
+    return std::nullopt;
+  }
+
+  const auto seed = (static_cast<u64>(version) << 32) | import_flags;
+  return content_hash(source_file->data(), seed);
+}
+
+auto MeshCache::load(const FS::Path &source, u64 key)
+    -> std::optional<Contents> {
+  const auto cache_path = path_for(source);
+  if (!FS::exists(cache_path)) {
+    return std::nullopt;
+  }
+
+  auto file = MappedFile::construct(cache_path);
+  if (!file->is_valid() || file->data().size() < sizeof(Header)) {
+    return std::nullopt;
+  }
+
+  const auto bytes = file->data();
+  Header header{};
+  std::memcpy(&header, bytes.data(), sizeof(Header));
+  const auto payload = bytes.subspan(sizeof(Header));
+  if (header.magic != magic || header.version != version ||
+      header.key != key || header.vertex_stride != sizeof(Vertex) ||
+      header.index_stride != sizeof(Index) ||
+      header.submesh_stride != sizeof(Submesh) ||
+      header.payload_size != payload.size()) {
+    info("Mesh cache for '{}' is stale, rebuilding.", source.filename());
+    return std::nullopt;
+  }
+
+  if (content_hash(payload) != header.payload_hash) {
+    warn("Mesh cache for '{}' is corrupt, rebuilding.", source.filename());
+    return std::nullopt;
+  }
+
+  PayloadReader reader{payload};
+  const auto vertex_bytes = reader.read(header.vertex_count * sizeof(Vertex));
+  const auto index_bytes = reader.read(header.index_count * sizeof(Index));
+  const auto submesh_bytes =
+      reader.read(header.submesh_count * sizeof(Submesh));
+
+  Contents contents{};
+  contents.submeshes.resize(header.submesh_count);
+  if (!submesh_bytes.empty()) {
+    std::memcpy(contents.submeshes.data(), submesh_bytes.data(),
+                submesh_bytes.size());
+  }
+
+  contents.materials.resize(header.material_count);
+  for (auto &material : contents.materials) {
+    MaterialRecord record{};
+    reader.read_into(record);
+    material.albedo_colour = record.albedo_colour;
+    material.emission = record.emission;
+    material.metalness = record.metalness;
+    material.roughness = record.roughness;
+    material.use_normal_map = record.use_normal_map;
+    reader.read_into(material.albedo_map);
+    reader.read_into(material.normal_map);
+    reader.read_into(material.metallic_map);
+  }
+
+  if (!reader.ok()) {
+    warn("Mesh cache for '{}' is truncated, rebuilding.", source.filename());
+    return std::nullopt;
+  }
+
+  contents.vertices = {reinterpret_cast<const Vertex *>(vertex_bytes.data()),
+                       header.vertex_count};
+  contents.indices = {reinterpret_cast<const Index *>(index_bytes.data()),
+                      header.index_count};
+  contents.file = std::move(file);
+  return contents;
+}
+
+auto MeshCache::store(const FS::Path &source, u64 key,
+                      std::span<const Vertex> vertices,
+                      std::span<const Index> indices,
+                      std::span<const Submesh> submeshes,
+                      std::span<const MeshMaterial> materials) -> bool {
+  PayloadWriter writer;
+  writer.write(vertices);
+  writer.write(indices);
+  writer.write(submeshes);
+  for (const auto &material : materials) {
+    const MaterialRecord record{
+        .albedo_colour = material.albedo_colour,
+        .emission = material.emission,
+        .metalness = material.metalness,
+        .roughness = material.roughness,
+        .use_normal_map = material.use_normal_map,
+    };
+    writer.write(&record, sizeof(record));
+    writer.write(material.albedo_map);
+    writer.write(material.normal_map);
+    writer.write(material.metallic_map);
+  }
+
+  const auto &payload = writer.get_payload();
+  const Header header{
+      .magic = magic,
+      .version = version,
+      .key = key,
+      .vertex_stride = sizeof(Vertex),
+      .index_stride = sizeof(Index),
+      .submesh_stride = sizeof(Submesh),
+      .material_count = static_cast<u32>(materials.size()),
+      .vertex_count = vertices.size(),
+      .index_count = indices.size(),
+      .submesh_count = submeshes.size(),
+      .payload_size = payload.size(),
+      .payload_hash = content_hash(payload),
+  };
+
+  if (FS::mkdir_safe("mesh_cache")) {
+    info("Created folder '{}'.", "mesh_cache");
+  }
+
+  // Written next to the entry and renamed over it, so a crash mid-write never
+  // leaves a truncated entry behind
+  const auto cache_path = path_for(source);
+  auto temporary_path = cache_path;
+  temporary_path += ".tmp";
+  {
+    std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+    if (!file) {
+      warn("Failed to open mesh cache file at {}", temporary_path);
+      return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(payload.data()),
+               static_cast<std::streamsize>(payload.size()));
+    if (!file) {
+      warn("Failed to write mesh cache file at {}", temporary_path);
+      return false;
+    }
+  }
+
+  std::error_code error_code;
+  std::filesystem::rename(temporary_path, cache_path, error_code);
+  if (error_code) {
+    warn("Failed to move mesh cache into place at {}: {}", cache_path,
+         error_code.message());
+    std::filesystem::remove(temporary_path, error_code);
+    return false;
+  }
+
+  debug("Stored mesh cache for '{}' at {} ({})", source.filename(), cache_path,
+        human_readable_size(sizeof(header) + payload.size()));
+  return true;
+}
+
+} // namespace Core
@@ -0,0 +1,481 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "MipGenerator.hpp"
+
+#include "Buffer.hpp"
+#include "Device.hpp"
+#include "Filesystem.hpp"
+#include "Image.hpp"
+#include "Logger.hpp"
+#include "Pipeline.hpp"
+#include "Shader.hpp"
+#include "StagingUploader.hpp"
+#include "Verify.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace Core {
+
+namespace {
+// Matches the push constants of MipGeneration.comp
+struct MipParameters {
+  u32 width{0};
+  u32 height{0};
+  u32 mip_count{0};
+  u32 workgroup_count{0};
+  u32 counter_index{0};
+  u32 srgb{0};
+};
+
+// Texels of level 0 reduced by one workgroup, per axis
+constexpr u32 workgroup_tile_size = 64;
+// Level 6 of a 4096 texture is the 64x64 tile the last workgroup reduces
+constexpr u32 max_compute_extent = 4096;
+
+auto full_range(const Image &image, u32 base_level, u32 level_count)
+    -> VkImageSubresourceRange {
+  return {
+      .aspectMask = image.get_aspect_mask(),
+      .baseMipLevel = base_level,
+      .levelCount = level_count,
+      .baseArrayLayer = 0,
+      .layerCount = 1,
+  };
+}
+} // namespace
+
+MipGenerator::Batch::Batch(MipGenerator &mips) : generator(&mips) {
+  generator->batch_depth++;
+}
+
+MipGenerator::Batch::~Batch() {
+  try {
+    generator->end_batch();
+  } catch (...) {
+    error("Failed to generate mips");
+  }
+}
+
+auto MipGenerator::construct(const Device &device) -> Scope<MipGenerator> {
+  return Scope<MipGenerator>(new MipGenerator(device));
+}
+
+MipGenerator::MipGenerator(const Device &dev) : device(&dev) {
+  command_buffer = CommandBuffer::construct(*device,
+                                            {
+                                                .queue_type =
+                                                    Queue::Type::Graphics,
+                                                .count = 1,
+                                            });
+
+  try {
+    shader =
+        Shader::construct(*device, FS::shader("MipGeneration.comp.spv"));
+    pipeline = Pipeline::construct(
+        *device, PipelineConfiguration{"MipGeneration",
+                                       PipelineStage::Compute, *shader});
+  } catch (const std::exception &exc) {
+    warn("Compute mip generation is unavailable, using blits: {}",
+         exc.what());
+    pipeline.reset();
+    shader.reset();
+    return;
+  }
+
+  const VkSamplerCreateInfo sampler_create_info{
+      .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+      .magFilter = VK_FILTER_LINEAR,
+      .minFilter = VK_FILTER_LINEAR,
+      .mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+      .addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE,
+      .maxLod = 0.0F,
+  };
+  verify(vkCreateSampler(device->get_device(), &sampler_create_info, nullptr,
+                         &sampler),
+         "vkCreateSampler", "Failed to create mip generation sampler");
+
+  reserve_counters(16);
+}
+
+MipGenerator::~MipGenerator() {
+  try {
+    flush();
+  } catch (...) {
+    error("Failed to generate pending mips");
+  }
+  vkDestroySampler(device->get_device(), sampler, nullptr);
+  command_buffer.reset();
+  counters.reset();
+  pipeline.reset();
+  shader.reset();
+}
+
+auto MipGenerator::supports_compute(const Device &device,
+                                    const ImageProperties &properties)
+    -> bool {
+  static constexpr auto empty = ImageUsage{0};
+  if (!properties.mip_info.valid() ||
+      properties.tiling != ImageTiling::Optimal ||
+      (properties.usage & ImageUsage::Sampled) == empty ||
+      (properties.usage & ImageUsage::Storage) != empty) {
+    return false;
+  }
+  if (properties.format != ImageFormat::UNORM_RGBA8 &&
+      properties.format != ImageFormat::SRGB_RGBA8) {
+    return false;
+  }
+  if (properties.extent.width > max_compute_extent ||
+      properties.extent.height > max_compute_extent) {
+    return false;
+  }
+
+  // sRGB images are written through a UNORM view of the same texels
+  VkFormatProperties format_properties{};
+  vkGetPhysicalDeviceFormatProperties(device.get_physical_device(),
+                                      VK_FORMAT_R8G8B8A8_UNORM,
+                                      &format_properties);
+  return (format_properties.optimalTilingFeatures &
+          VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT) != 0;
+}
+
+auto MipGenerator::end_batch() -> void {
+  ensure(batch_depth > 0, "Mip batch ended without being started");
+  if (--batch_depth == 0) {
+    flush();
+  }
+}
+
+auto MipGenerator::enqueue(const Image &image) -> void {
+  if (!image.get_properties().mip_info.valid()) {
+    return;
+  }
+
+  pending.push_back(&image);
+  if (batch_depth == 0) {
+    flush();
+  }
+}
+
+auto MipGenerator::reserve_counters(u32 count) -> void {
+  if (count <= counter_capacity) {
+    return;
+  }
+
+  // Nothing is in flight between flushes, so the old buffer can go
+  counter_capacity = std::bit_ceil(count);
+  std::vector<u32> zeroes(counter_capacity, 0);
+  counters = Buffer::construct(*device, zeroes.size() * sizeof(u32),
+                               Buffer::Type::Storage, "Mip Generator Counters");
+  counters->write(std::span{zeroes});
+}
+
+auto MipGenerator::flush() -> void {
+  // Level 0 of every pending image must have landed first
+  device->get_staging_uploader().flush();
+  if (pending.empty()) {
+    return;
+  }
+
+  const auto uses_compute = [this](const Image *image) {
+    return pipeline != nullptr &&
+           supports_compute(*device, image->get_properties());
+  };
+  const auto compute_count =
+      static_cast<u32>(std::ranges::count_if(pending, uses_compute));
+  reserve_counters(compute_count);
+
+  command_buffer->begin(0);
+  const auto vk_command_buffer = command_buffer->get_command_buffer();
+  if (compute_count > 0) {
+    pipeline->bind(*command_buffer);
+  }
+
+  u32 counter_index = 0;
+  for (const auto *image : pending) {
+    if (uses_compute(image)) {
+      record_compute(vk_command_buffer, *image, counter_index++);
+    } else {
+      record_blits(vk_command_buffer, *image);
+    }
+  }
+  command_buffer->end_and_submit();
+
+  debug("Generated mips for {} images ({} with compute) in one submission",
+        pending.size(), compute_count);
+  pending.clear();
+
+  for (const auto &set : transient_sets) {
+    device->get_descriptor_resource()->free_persistent_descriptor_set(set);
+  }
+  for (auto *view : transient_views) {
+    vkDestroyImageView(device->get_device(), view, nullptr);
+  }
+  transient_sets.clear();
+  transient_views.clear();
+}
+
+auto MipGenerator::create_level_view(const Image &image, u32 level,
+                                     VkFormat format, VkImageUsageFlags usage)
+    -> VkImageView {
+  // sRGB images carry the storage bit as extended usage, which views in the
+  // sRGB format must leave out
+  const VkImageViewUsageCreateInfo usage_info{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_USAGE_CREATE_INFO,
+      .usage = usage,
+  };
+  const VkImageViewCreateInfo view_create_info{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .pNext = &usage_info,
+      .image = image.get_image(),
+      .viewType = VK_IMAGE_VIEW_TYPE_2D,
+      .format = format,
+      .subresourceRange = full_range(image, level, 1),
+  };
+
+  VkImageView view{nullptr};
+  verify(vkCreateImageView(device->get_device(), &view_create_info, nullptr,
+                           &view),
+         "vkCreateImageView", "Failed to create mip level view");
+  transient_views.push_back(view);
+  return view;
+}
+
+auto MipGenerator::record_compute(VkCommandBuffer buffer, const Image &image,
+                                  u32 counter_index) -> void {
+  const auto &properties = image.get_properties();
+  const auto level_count = properties.mip_info.mips;
+  const auto mip_count = std::min(level_count - 1, max_compute_mips);
+  const auto final_layout = image.get_descriptor_info().imageLayout;
+
+  // Level 0 is sampled, every other level is only written
+  const std::array to_generate{
+      VkImageMemoryBarrier{
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+          .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+          .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+          .newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .image = image.get_image(),
+          .subresourceRange = full_range(image, 0, 1),
+      },
+      VkImageMemoryBarrier{
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          .srcAccessMask = 0,
+          .dstAccessMask =
+              VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+          .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+          .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .image = image.get_image(),
+          .subresourceRange = full_range(image, 1, level_count - 1),
+      },
+  };
+  vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, static_cast<u32>(to_generate.size()),
+                       to_generate.data());
+
+  const auto source_view =
+      create_level_view(image, 0, to_vulkan_format(properties.format),
+                        VK_IMAGE_USAGE_SAMPLED_BIT);
+  const VkDescriptorImageInfo source_info{
+      .sampler = sampler,
+      .imageView = source_view,
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+  };
+
+  std::array<VkDescriptorImageInfo, max_compute_mips> level_infos{};
+  for (u32 i = 0; i < max_compute_mips; ++i) {
+    if (i < mip_count) {
+      level_infos[i] = {
+          .imageView = create_level_view(image, i + 1,
+                                         VK_FORMAT_R8G8B8A8_UNORM,
+                                         VK_IMAGE_USAGE_STORAGE_BIT),
+          .imageLayout = VK_IMAGE_LAYOUT_GENERAL,
+      };
+    } else {
+      // Never written, but every array element must be valid
+      level_infos[i] = level_infos[mip_count - 1];
+    }
+  }
+
+  const auto &set = transient_sets.emplace_back(
+      shader->allocate_persistent_descriptor_set(0));
+  const std::array writes{
+      VkWriteDescriptorSet{
+          .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+          .dstSet = set.set,
+          .dstBinding = 0,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+          .pImageInfo = &source_info,
+      },
+      VkWriteDescriptorSet{
+          .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+          .dstSet = set.set,
+          .dstBinding = 1,
+          .descriptorCount = max_compute_mips,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+          .pImageInfo = level_infos.data(),
+      },
+      VkWriteDescriptorSet{
+          .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+          .dstSet = set.set,
+          .dstBinding = 2,
+          .descriptorCount = 1,
+          .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+          .pBufferInfo = &counters->get_descriptor_info(),
+      },
+  };
+  vkUpdateDescriptorSets(device->get_device(), static_cast<u32>(writes.size()),
+                         writes.data(), 0, nullptr);
+
+  const auto &extent = properties.extent;
+  const auto groups_x =
+      (extent.width + workgroup_tile_size - 1) / workgroup_tile_size;
+  const auto groups_y =
+      (extent.height + workgroup_tile_size - 1) / workgroup_tile_size;
+  const MipParameters parameters{
+      .width = extent.width,
+      .height = extent.height,
+      .mip_count = mip_count,
+      .workgroup_count = groups_x * groups_y,
+      .counter_index = counter_index,
+      .srgb = properties.format == ImageFormat::SRGB_RGBA8 ? 1U : 0U,
+  };
+
+  vkCmdBindDescriptorSets(buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                          pipeline->get_pipeline_layout(), 0, 1, &set.set, 0,
+                          nullptr);
+  vkCmdPushConstants(buffer, pipeline->get_pipeline_layout(),
+                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(parameters),
+                     &parameters);
+  vkCmdDispatch(buffer, groups_x, groups_y, 1);
+
+  const std::array to_final{
+      VkImageMemoryBarrier{
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          .srcAccessMask = VK_ACCESS_SHADER_READ_BIT,
+          .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+          .oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+          .newLayout = final_layout,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .image = image.get_image(),
+          .subresourceRange = full_range(image, 0, 1),
+      },
+      VkImageMemoryBarrier{
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+          .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+          .oldLayout = VK_IMAGE_LAYOUT_GENERAL,
+          .newLayout = final_layout,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .image = image.get_image(),
+          .subresourceRange = full_range(image, 1, level_count - 1),
+      },
+  };
+  vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0,
+                       nullptr, static_cast<u32>(to_final.size()),
+                       to_final.data());
+}
+
+auto MipGenerator::record_blits(VkCommandBuffer buffer,
+                                const Image &image) const -> void {
+  const auto &properties = image.get_properties();
+  const auto aspect = image.get_aspect_mask();
+  const auto final_layout = image.get_descriptor_info().imageLayout;
+
+  VkImageMemoryBarrier barrier{};
+  barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+  barrier.image = image.get_image();
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.subresourceRange = full_range(image, 0, 1);
+  auto &&[mip_width, mip_height] = properties.extent.as<i32>();
+
+  // Every level is in TRANSFER_DST_OPTIMAL after the upload
+  for (u32 i = 1; i < properties.mip_info.mips; i++) {
+    barrier.subresourceRange.baseMipLevel = i - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &barrier);
+
+    VkImageBlit blit{};
+    blit.srcOffsets[0] = {
+        0,
+        0,
+        0,
+    };
+    blit.srcOffsets[1] = {
+        mip_width,
+        mip_height,
+        1,
+    };
+    blit.srcSubresource.aspectMask = aspect;
+    blit.srcSubresource.mipLevel = i - 1;
+    blit.srcSubresource.baseArrayLayer = 0;
+    blit.srcSubresource.layerCount = 1;
+    blit.dstOffsets[0] = {
+        0,
+        0,
+        0,
+    };
+    blit.dstOffsets[1] = {
+        mip_width > 1 ? mip_width / 2 : 1,
+        mip_height > 1 ? mip_height / 2 : 1,
+        1,
+    };
+    blit.dstSubresource.aspectMask = aspect;
+    blit.dstSubresource.mipLevel = i;
+    blit.dstSubresource.baseArrayLayer = 0;
+    blit.dstSubresource.layerCount = 1;
+
+    vkCmdBlitImage(buffer, image.get_image(),
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image.get_image(),
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit,
+                   VK_FILTER_LINEAR);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    barrier.newLayout = final_layout;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+    vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &barrier);
+
+    if (mip_width > 1) {
+      mip_width /= 2;
+    }
+    if (mip_height > 1) {
+      mip_height /= 2;
+    }
+  }
+
+  barrier.subresourceRange.baseMipLevel = properties.mip_info.mips - 1;
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.newLayout = final_layout;
+  barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+  vkCmdPipelineBarrier(buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+}
+
+} // namespace Core
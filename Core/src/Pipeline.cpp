@@ -3,14 +3,11 @@
 #include "Pipeline.hpp"
 
 #include "Device.hpp"
-#include "Filesystem.hpp"
 #include "Framebuffer.hpp"
 #include "Logger.hpp"
+#include "PipelineCache.hpp"
 #include "Verify.hpp"
 
-#include <filesystem>
-#include <fstream>
-
 namespace Core {
 namespace PipelineHelpers {
 
@@ -128,62 +125,6 @@ constexpr auto to_vulkan_face_mode(FaceMode face_mode) -> VkFrontFace {
   throw NotFoundException{"Missing face mode"};
 }
 
-auto try_load_pipeline_cache(const std::string &pipeline_name)
-    -> std::vector<u8> {
-  if (const auto cache_path = FS::pipeline_cache(pipeline_name + ".cache");
-      std::filesystem::exists(cache_path)) {
-    info("Pipeline cache exists. Loading...");
-    auto cache_file = std::ifstream{cache_path};
-    if (!cache_file) {
-      info("Failed to open pipeline cache file at {}", cache_path.string());
-    } else {
-      auto cache_data = std::vector<u8>(std::filesystem::file_size(cache_path));
-      cache_file.read(std::bit_cast<char *>(cache_data.data()),
-                      cache_data.size());
-      return cache_data;
-    }
-  } else {
-    info("Pipeline cache does not exist. Creating...");
-  }
-
-  return {};
-}
-
-auto save_cache(auto &device, auto pipeline_cache, const std::string &name) {
-  if (name.empty()) {
-    return;
-  }
-
-  if (std::filesystem::exists(name + ".cache")) {
-    info("Pipeline cache exists. Overwriting...");
-  }
-
-  if (FS::mkdir_safe("pipeline_cache")) {
-    info("Created folder '{}'.", "pipeline_cache");
-  }
-
-  const auto output_path = FS::pipeline_cache(name + ".cache");
-  debug("Saving pipeline cache to {}", output_path.string());
-  std::ofstream file{output_path.c_str(), std::ios::binary};
-  if (!file) {
-    info("Failed to open pipeline cache file at {}", name + ".cache");
-    return;
-  }
-
-  auto pipeline_cache_size = size_t{0};
-  verify(vkGetPipelineCacheData(device.get_device(), pipeline_cache,
-                                &pipeline_cache_size, nullptr),
-         "vkGetPipelineCacheData", "Failed to get pipeline cache data");
-
-  auto pipeline_cache_data = std::vector<u8>(pipeline_cache_size);
-  verify(vkGetPipelineCacheData(device.get_device(), pipeline_cache,
-                                &pipeline_cache_size,
-                                pipeline_cache_data.data()),
-         "vkGetPipelineCacheData", "Failed to get pipeline cache data");
-
-  file.write(reinterpret_cast<const char *>(pipeline_cache_data.data()),
-             pipeline_cache_data.size());
-}
 } // namespace PipelineHelpers
 
 auto Pipeline::construct(const Device &dev,
@@ -199,14 +140,7 @@ Pipeline::Pipeline(const Device &dev,
 }
 
 Pipeline::~Pipeline() {
-  try {
-    PipelineHelpers::save_cache(device, pipeline_cache, name);
-  } catch (const std::exception &exc) {
-    error("Pipeline save_cache exception: {}", exc.what());
-  }
-
   vkDestroyPipelineLayout(device.get_device(), pipeline_layout, nullptr);
-  vkDestroyPipelineCache(device.get_device(), pipeline_cache, nullptr);
   vkDestroyPipeline(device.get_device(), pipeline, nullptr);
 }
 
@@ -249,19 +183,6 @@ auto Pipeline::construct_pipeline(const PipelineConfiguration &configuration)
                                 &pipeline_layout),
          "vkCreatePipelineLayout", "Failed to create pipeline layout");
 
-  const auto maybe_empty_pipeline_cache_data =
-      PipelineHelpers::try_load_pipeline_cache(name);
-  VkPipelineCacheCreateInfo pipeline_cache_create_info{};
-  pipeline_cache_create_info.sType =
-      VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
-  pipeline_cache_create_info.initialDataSize =
-      maybe_empty_pipeline_cache_data.size();
-  pipeline_cache_create_info.pInitialData =
-      maybe_empty_pipeline_cache_data.data();
-
-  vkCreatePipelineCache(device.get_device(), &pipeline_cache_create_info,
-                        nullptr, &pipeline_cache);
-
   VkComputePipelineCreateInfo compute_pipeline_create_info{};
   compute_pipeline_create_info.sType =
       VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -277,10 +198,14 @@ auto Pipeline::construct_pipeline(const PipelineConfiguration &configuration)
 
   compute_pipeline_create_info.stage = shader_stage_create_info;
 
-  verify(vkCreateComputePipelines(device.get_device(), pipeline_cache, 1,
+  auto &pipeline_cache = device.get_pipeline_cache();
+  const auto start = PipelineCache::Clock::now();
+  verify(vkCreateComputePipelines(device.get_device(),
+                                  pipeline_cache.get_cache(), 1,
                                   &compute_pipeline_create_info, nullptr,
                                   &pipeline),
          "vkCreateComputePipelines", "Failed to create compute pipeline");
+  pipeline_cache.record_creation(name, PipelineCache::Clock::now() - start);
 }
 
 GraphicsPipeline::GraphicsPipeline(
@@ -292,7 +217,6 @@ GraphicsPipeline::GraphicsPipeline(
 GraphicsPipeline::~GraphicsPipeline() {
   auto vk_device = device->get_device();
   vkDestroyPipelineLayout(vk_device, pipeline_layout, nullptr);
-  vkDestroyPipelineCache(vk_device, pipeline_cache, nullptr);
   vkDestroyPipeline(vk_device, pipeline, nullptr);
 };
 
@@ -568,9 +492,13 @@ auto GraphicsPipeline::construct_pipeline(
   pipeline_create_info.basePipelineHandle = VK_NULL_HANDLE;
   pipeline_create_info.basePipelineIndex = -1;
 
-  verify(vkCreateGraphicsPipelines(device->get_device(), pipeline_cache, 1,
+  auto &pipeline_cache = device->get_pipeline_cache();
+  const auto start = PipelineCache::Clock::now();
+  verify(vkCreateGraphicsPipelines(device->get_device(),
+                                   pipeline_cache.get_cache(), 1,
                                    &pipeline_create_info, nullptr, &pipeline),
          "vkCreateGraphicsPipelines", "Failed to construct graphics pipeline.");
+  pipeline_cache.record_creation(name, PipelineCache::Clock::now() - start);
 }
 
 } // namespace Core
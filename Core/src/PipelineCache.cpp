@@ -0,0 +1,238 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "PipelineCache.hpp"
+
+#include "Config.hpp"
+#include "DataBuffer.hpp"
+#include "Device.hpp"
+#include "Logger.hpp"
+#include "MappedFile.hpp"
+#include "Verify.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace Core {
+
+static auto get_cache_data(VkDevice device, VkPipelineCache cache)
+    -> std::vector<u8> {
+  auto size = usize{0};
+  verify(vkGetPipelineCacheData(device, cache, &size, nullptr),
+         "vkGetPipelineCacheData", "Failed to get pipeline cache size");
+
+  std::vector<u8> data(size);
+  verify(vkGetPipelineCacheData(device, cache, &size, data.data()),
+         "vkGetPipelineCacheData", "Failed to get pipeline cache data");
+  data.resize(size);
+  return data;
+}
+
+static auto create_cache(VkDevice device, std::span<const u8> initial_data)
+    -> VkPipelineCache {
+  const VkPipelineCacheCreateInfo create_info{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .initialDataSize = initial_data.size(),
+      .pInitialData = initial_data.data(),
+  };
+  VkPipelineCache cache{nullptr};
+  verify(vkCreatePipelineCache(device, &create_info, nullptr, &cache),
+         "vkCreatePipelineCache", "Failed to create pipeline cache");
+  return cache;
+}
+
+PipelineCache::PipelineCache(const Device &dev) : device(&dev) {
+  const auto properties = device->get_device_properties();
+  // One file per GPU, so machines with several do not overwrite each other
+  path = FS::pipeline_cache(fmt::format(
+      "pipelines-{:04x}-{:04x}.cache", properties.vendorID,
+      properties.deviceID));
+
+  const auto start = Clock::now();
+  const auto initial_data = load_compatible(path, properties);
+  cache = create_cache(device->get_device(), initial_data);
+  warm = !initial_data.empty();
+  merge_legacy_caches(properties);
+  last_save = Clock::now();
+
+  info("Loaded {} pipeline cache ({}) in {:.2f}ms", warm ? "warm" : "cold",
+       human_readable_size(initial_data.size()),
+       std::chrono::duration<floating, std::milli>(last_save - start).count());
+}
+
+PipelineCache::~PipelineCache() {
+  if (const auto count = created_count.load(); count > 0) {
+    info("Created {} pipelines in {:.2f}ms with a {} cache", count,
+         static_cast<floating>(created_microseconds.load()) / 1000.0F,
+         warm ? "warm" : "cold");
+  }
+
+  try {
+    save();
+  } catch (const std::exception &exc) {
+    error("Pipeline cache save exception: {}", exc.what());
+  }
+  vkDestroyPipelineCache(device->get_device(), cache, nullptr);
+}
+
+auto PipelineCache::is_compatible(std::span<const u8> blob,
+                                  const VkPhysicalDeviceProperties &properties)
+    -> bool {
+  VkPipelineCacheHeaderVersionOne header{};
+  if (blob.size() < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, blob.data(), sizeof(header));
+
+  return header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         header.headerSize >= sizeof(header) &&
+         header.headerSize <= blob.size() &&
+         header.vendorID == properties.vendorID &&
+         header.deviceID == properties.deviceID &&
+         std::ranges::equal(header.pipelineCacheUUID,
+                            properties.pipelineCacheUUID);
+}
+
+auto PipelineCache::load_compatible(
+    const FS::Path &file_path,
+    const VkPhysicalDeviceProperties &properties) const -> std::vector<u8> {
+  if (!FS::exists(file_path)) {
+    return {};
+  }
+
+  const auto file = MappedFile::construct(file_path);
+  if (!file->is_valid()) {
+    warn("Failed to open pipeline cache at {}", file_path);
+    return {};
+  }
+
+  const auto blob = file->data();
+  if (!is_compatible(blob, properties)) {
+    info("Pipeline cache at {} was written by another driver or GPU, "
+         "ignoring it.",
+         file_path);
+    return {};
+  }
+  return {blob.begin(), blob.end()};
+}
+
+auto PipelineCache::merge_legacy_caches(
+    const VkPhysicalDeviceProperties &properties) -> void {
+  // Earlier versions wrote one cache per pipeline name. Fold any compatible
+  // ones into the device cache once and remove them.
+  std::error_code error_code;
+  const auto directory = path.parent_path();
+  if (!std::filesystem::is_directory(directory, error_code)) {
+    return;
+  }
+
+  std::vector<VkPipelineCache> legacy_caches;
+  std::vector<FS::Path> legacy_paths;
+  for (const auto &entry :
+       std::filesystem::directory_iterator{directory, error_code}) {
+    const auto &entry_path = entry.path();
+    if (entry_path.extension() != ".cache" ||
+        entry_path.filename().string().starts_with("pipelines-")) {
+      continue;
+    }
+
+    if (const auto data = load_compatible(entry_path, properties);
+        !data.empty()) {
+      legacy_caches.push_back(create_cache(device->get_device(), data));
+    }
+    legacy_paths.push_back(entry_path);
+  }
+
+  if (!legacy_caches.empty()) {
+    verify(vkMergePipelineCaches(device->get_device(), cache,
+                                 static_cast<u32>(legacy_caches.size()),
+                                 legacy_caches.data()),
+           "vkMergePipelineCaches", "Failed to merge pipeline caches");
+    dirty = true;
+    warm = true;
+  }
+  for (auto *legacy : legacy_caches) {
+    vkDestroyPipelineCache(device->get_device(), legacy, nullptr);
+  }
+  for (const auto &legacy_path : legacy_paths) {
+    std::filesystem::remove(legacy_path, error_code);
+  }
+
+  if (!legacy_paths.empty()) {
+    info("Merged {} of {} per-pipeline caches into {}", legacy_caches.size(),
+         legacy_paths.size(), path.filename());
+  }
+}
+
+auto PipelineCache::record_creation(std::string_view name,
+                                    Clock::duration elapsed) -> void {
+  const auto microseconds =
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+  created_microseconds += static_cast<u64>(microseconds);
+  ++created_count;
+  dirty = true;
+
+  info("Created pipeline '{}' in {:.2f}ms ({} cache)", name,
+       static_cast<floating>(microseconds) / 1000.0F, warm ? "warm" : "cold");
+}
+
+auto PipelineCache::save_if_due() -> void {
+  if (!dirty.load(std::memory_order_relaxed)) {
+    return;
+  }
+
+  static constexpr auto interval =
+      std::chrono::seconds{Config::pipeline_cache_save_interval};
+  if (Clock::now() - last_save < interval) {
+    return;
+  }
+  save();
+}
+
+auto PipelineCache::save() -> bool {
+  std::scoped_lock lock{save_mutex};
+  if (!dirty.exchange(false)) {
+    return true;
+  }
+  last_save = Clock::now();
+
+  const auto data = get_cache_data(device->get_device(), cache);
+  if (FS::mkdir_safe("pipeline_cache")) {
+    info("Created folder '{}'.", "pipeline_cache");
+  }
+
+  // Written next to the cache and renamed over it, so a crash mid-write
+  // never leaves a truncated cache behind
+  auto temporary_path = path;
+  temporary_path += ".tmp";
+  {
+    std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char *>(data.data()),
+               static_cast<std::streamsize>(data.size()));
+    if (!file) {
+      warn("Failed to write pipeline cache at {}", temporary_path);
+      dirty = true;
+      return false;
+    }
+  }
+
+  std::error_code error_code;
+  std::filesystem::rename(temporary_path, path, error_code);
+  if (error_code) {
+    warn("Failed to move pipeline cache into place at {}: {}", path,
+         error_code.message());
+    std::filesystem::remove(temporary_path, error_code);
+    dirty = true;
+    return false;
+  }
+
+  debug("Saved pipeline cache to {} ({})", path,
+        human_readable_size(data.size()));
+  return true;
+}
+
+auto PipelineCache::construct(const Device &device) -> Scope<PipelineCache> {
+  return Scope<PipelineCache>{new PipelineCache(device)};
+}
+
+} // namespace Core
@@ -0,0 +1,27 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "PipelineCompiler.hpp"
+
+#include "JobSystem.hpp"
+
+namespace Core {
+
+auto PipelineCompiler::compile(const Device &device,
+                               PipelineConfiguration configuration)
+    -> std::future<Scope<Pipeline>> {
+  return JobSystem::submit(
+      [&device, configuration = std::move(configuration)] {
+        return Pipeline::construct(device, configuration);
+      });
+}
+
+auto PipelineCompiler::compile(const Device &device,
+                               GraphicsPipelineConfiguration configuration)
+    -> std::future<Scope<GraphicsPipeline>> {
+  return JobSystem::submit(
+      [&device, configuration = std::move(configuration)] {
+        return GraphicsPipeline::construct(device, configuration);
+      });
+}
+
+} // namespace Core
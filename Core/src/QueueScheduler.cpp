@@ -0,0 +1,172 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "QueueScheduler.hpp"
+
+#include "Verify.hpp"
+
+namespace Core {
+
+QueueScheduler::QueueScheduler(const Device &dev) : device(&dev) {}
+
+auto QueueScheduler::construct(const Device &device)
+    -> Scope<QueueScheduler> {
+  return Scope<QueueScheduler>(new QueueScheduler(device));
+}
+
+auto QueueScheduler::get_pending_handoff_count(Queue::Type consumer) const
+    -> usize {
+  const auto found = handoffs.find(consumer);
+  return found == handoffs.end() ? 0 : found->second.size();
+}
+
+auto QueueScheduler::get_pending_wait_count(Queue::Type consumer) const
+    -> usize {
+  const auto found = waits.find(consumer);
+  return found == waits.end() ? 0 : found->second.size();
+}
+
+auto QueueScheduler::family_of(Queue::Type type) const -> u32 {
+  // Without a dedicated family the work runs on the graphics family
+  if (const auto family = device->get_family_index(type)) {
+    return *family;
+  }
+  return *device->get_family_index(Queue::Type::Graphics);
+}
+
+auto QueueScheduler::release(const CommandBuffer &producer,
+                             Queue::Type consumer,
+                             const ImageHandoff &handoff) -> void {
+  ensure(handoff.image != nullptr, "Cannot hand off an empty image");
+
+  const auto producer_type = producer.get_queue_type();
+  const auto source_family = family_of(producer_type);
+  const auto destination_family = family_of(consumer);
+
+  // Same family: the acquire barrier alone orders the access
+  if (source_family != destination_family) {
+    VkImageMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = handoff.source_access,
+        .dstAccessMask = 0,
+        .oldLayout = handoff.layout,
+        .newLayout = handoff.layout,
+        .srcQueueFamilyIndex = source_family,
+        .dstQueueFamilyIndex = destination_family,
+        .image = handoff.image->get_image(),
+        .subresourceRange =
+            {
+                .aspectMask = handoff.image->get_aspect_mask(),
+                .baseMipLevel = 0,
+                .levelCount = VK_REMAINING_MIP_LEVELS,
+                .baseArrayLayer = 0,
+                .layerCount = VK_REMAINING_ARRAY_LAYERS,
+            },
+    };
+    vkCmdPipelineBarrier(producer.get_command_buffer(), handoff.source_stage,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+  }
+
+  handoffs[consumer].push_back({
+      .producer = producer_type,
+      .handoff = handoff,
+  });
+  produced_for[producer_type] |= handoff.destination_stage;
+}
+
+auto QueueScheduler::acquire_pending(const CommandBuffer &consumer) -> void {
+  const auto consumer_type = consumer.get_queue_type();
+  if (!handoffs.contains(consumer_type)) {
+    return;
+  }
+
+  std::vector<VkImageMemoryBarrier> barriers;
+  VkPipelineStageFlags destination_stages{0};
+  VkPipelineStageFlags source_stages{0};
+  for (const auto &[producer, handoff] : handoffs.at(consumer_type)) {
+    const auto source_family = family_of(producer);
+    const auto destination_family = family_of(consumer_type);
+    const auto is_transfer = source_family != destination_family;
+
+    barriers.push_back({
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask =
+            is_transfer ? VkAccessFlags{0} : handoff.source_access,
+        .dstAccessMask = handoff.destination_access,
+        .oldLayout = handoff.layout,
+        .newLayout = handoff.layout,
+        .srcQueueFamilyIndex =
+            is_transfer ? source_family : VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex =
+            is_transfer ? destination_family : VK_QUEUE_FAMILY_IGNORED,
+        .image = handoff.image->get_image(),
+        .subresourceRange =
+            {
+                .aspectMask = handoff.image->get_aspect_mask(),
+                .baseMipLevel = 0,
+                .levelCount = VK_REMAINING_MIP_LEVELS,
+                .baseArrayLayer = 0,
+                .layerCount = VK_REMAINING_ARRAY_LAYERS,
+            },
+    });
+    source_stages |= is_transfer ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+                                 : handoff.source_stage;
+    destination_stages |= handoff.destination_stage;
+  }
+  handoffs.erase(consumer_type);
+
+  vkCmdPipelineBarrier(consumer.get_command_buffer(), source_stages,
+                       destination_stages, 0, 0, nullptr, 0, nullptr,
+                       static_cast<u32>(barriers.size()), barriers.data());
+}
+
+auto QueueScheduler::submit(CommandBuffer &command_buffer,
+                            std::span<const SubmitWait> extra_waits)
+    -> GpuFuture {
+  const auto queue_type = command_buffer.get_queue_type();
+
+  std::vector<SubmitWait> queue_waits;
+  if (waits.contains(queue_type)) {
+    queue_waits = std::move(waits.at(queue_type));
+    waits.erase(queue_type);
+  }
+  // A producer waited on explicitly and through a handoff is waited on once
+  for (const auto &wait : extra_waits) {
+    const auto found =
+        std::ranges::find_if(queue_waits, [&wait](const auto &queued) {
+          return queued.future.get_semaphore() ==
+                 wait.future.get_semaphore();
+        });
+    if (found == queue_waits.end()) {
+      queue_waits.push_back(wait);
+      continue;
+    }
+    if (found->future.get_value() < wait.future.get_value()) {
+      found->future = wait.future;
+    }
+    found->stage |= wait.stage;
+  }
+
+  auto future = command_buffer.end_and_submit_async(queue_waits);
+
+  // Everything handed off by this submission is waited on by its consumers
+  if (produced_for.contains(queue_type)) {
+    for (const auto &[consumer, pending] : handoffs) {
+      const auto produced_here =
+          std::ranges::any_of(pending, [queue_type](const auto &handoff) {
+            return handoff.producer == queue_type;
+          });
+      if (produced_here) {
+        waits[consumer].push_back({
+            .future = future,
+            .stage = produced_for.at(queue_type),
+        });
+      }
+    }
+    produced_for.erase(queue_type);
+  }
+
+  return future;
+}
+
+} // namespace Core
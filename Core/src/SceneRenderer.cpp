@@ -2,10 +2,74 @@
 
 #include "SceneRenderer.hpp"
 
+#include "CommandDispatcher.hpp"
+#include "ContentHash.hpp"
+#include "JobSystem.hpp"
+#include "PipelineCompiler.hpp"
+#include "TextureStreamer.hpp"
+
+#include <algorithm>
 #include <glm/glm.hpp>
 
 namespace Core {
 
+static constexpr auto cull_group_size = 64U;
+
+/**
+ * @brief Gribb-Hartmann plane extraction. The near plane is taken from the
+ * [-w, w] depth convention, which is conservative for [0, w].
+ */
+static auto extract_frustum_planes(const glm::mat4 &view_projection,
+                                   std::span<glm::vec4, 6> planes) -> void {
+  const auto row = [&matrix = view_projection](u32 index) {
+    return glm::vec4{matrix[0][index], matrix[1][index], matrix[2][index],
+                     matrix[3][index]};
+  };
+
+  planes[0] = row(3) + row(0);
+  planes[1] = row(3) - row(0);
+  planes[2] = row(3) + row(1);
+  planes[3] = row(3) - row(1);
+  planes[4] = row(3) + row(2);
+  planes[5] = row(3) - row(2);
+
+  for (auto &plane : planes) {
+    plane /= glm::length(glm::vec3{plane});
+  }
+}
+
+/**
+ * @brief The fraction of the viewport covered by the projected box, per
+ * axis. A box crossing the near plane covers all of it.
+ */
+static auto projected_coverage(const glm::mat4 &clip_from_local,
+                               const AABB &box) -> glm::vec2 {
+  const auto min = glm::vec3{box.min_vector()};
+  const auto max = glm::vec3{box.max_vector()};
+
+  glm::vec2 low{1.0F};
+  glm::vec2 high{-1.0F};
+  for (u32 corner = 0; corner < 8; ++corner) {
+    const glm::vec4 local{
+        (corner & 1U) != 0 ? max.x : min.x,
+        (corner & 2U) != 0 ? max.y : min.y,
+        (corner & 4U) != 0 ? max.z : min.z,
+        1.0F,
+    };
+    const auto clip = clip_from_local * local;
+    if (clip.w <= 0.0F) {
+      return glm::vec2{1.0F};
+    }
+    const auto ndc = glm::vec2{clip} / clip.w;
+    low = glm::min(low, ndc);
+    high = glm::max(high, ndc);
+  }
+
+  low = glm::clamp(low, -1.0F, 1.0F);
+  high = glm::clamp(high, -1.0F, 1.0F);
+  return glm::max(high - low, glm::vec2{0.0F}) * 0.5F;
+}
+
 template <Core::Buffer::Type T>
 auto create_or_get_write_descriptor_for(u32 frames_in_flight,
                                         Core::BufferSet<T> *buffer_set,
@@ -58,7 +122,9 @@ auto create_or_get_write_descriptor_for(u32 frames_in_flight,
         VkWriteDescriptorSet wds = {};
         wds.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         wds.descriptorCount = 1;
-        wds.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        wds.descriptorType = vulkan_shader.is_dynamic_binding(binding)
+                                 ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC
+                                 : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         wds.pBufferInfo = &stored_buffer->get_descriptor_info();
         wds.dstBinding = stored_buffer->get_binding();
         write_descriptors[frame].push_back(wds);
@@ -76,7 +142,9 @@ auto create_or_get_write_descriptor_for(u32 frames_in_flight,
         VkWriteDescriptorSet wds = {};
         wds.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         wds.descriptorCount = 1;
-        wds.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        wds.descriptorType = vulkan_shader.is_dynamic_binding(binding)
+                                 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+                                 : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         wds.pBufferInfo = &stored_buffer->get_descriptor_info();
         wds.dstBinding = stored_buffer->get_binding();
         write_descriptors[frame].push_back(wds);
@@ -96,8 +164,26 @@ auto SceneRenderer::destroy(const Device &device) -> void {
   black_texture.reset();
 }
 
-auto SceneRenderer::begin_renderpass(const CommandBuffer &buffer,
+static auto set_viewport_and_scissor(const CommandBuffer &buffer,
                                      const Framebuffer &framebuffer) -> void {
+  VkViewport viewport = {};
+  viewport.x = 0.0F;
+  viewport.y = static_cast<float>(framebuffer.get_height());
+  viewport.width = static_cast<float>(framebuffer.get_width());
+  viewport.height = -static_cast<float>(framebuffer.get_height());
+  viewport.minDepth = 1.0F;
+  viewport.maxDepth = 0.0F;
+  vkCmdSetViewport(buffer.get_command_buffer(), 0, 1, &viewport);
+
+  VkRect2D scissor = {};
+  scissor.extent.width = framebuffer.get_width();
+  scissor.extent.height = framebuffer.get_height();
+  vkCmdSetScissor(buffer.get_command_buffer(), 0, 1, &scissor);
+}
+
+auto SceneRenderer::begin_renderpass(const CommandBuffer &buffer,
+                                     const Framebuffer &framebuffer,
+                                     VkSubpassContents contents) -> void {
   VkRenderPassBeginInfo render_pass_begin_info = {};
   render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
   render_pass_begin_info.renderPass = framebuffer.get_render_pass();
@@ -111,22 +197,12 @@ auto SceneRenderer::begin_renderpass(const CommandBuffer &buffer,
       static_cast<u32>(clear_values.size());
   render_pass_begin_info.pClearValues = clear_values.data();
   vkCmdBeginRenderPass(buffer.get_command_buffer(), &render_pass_begin_info,
-                       VK_SUBPASS_CONTENTS_INLINE);
+                       contents);
 
-  // Scissors and viewport
-  VkViewport viewport = {};
-  viewport.x = 0.0F;
-  viewport.y = static_cast<float>(framebuffer.get_height());
-  viewport.width = static_cast<float>(framebuffer.get_width());
-  viewport.height = -static_cast<float>(framebuffer.get_height());
-  viewport.minDepth = 1.0F;
-  viewport.maxDepth = 0.0F;
-  vkCmdSetViewport(buffer.get_command_buffer(), 0, 1, &viewport);
-
-  VkRect2D scissor = {};
-  scissor.extent.width = framebuffer.get_width();
-  scissor.extent.height = framebuffer.get_height();
-  vkCmdSetScissor(buffer.get_command_buffer(), 0, 1, &scissor);
+  // Only execute commands are allowed in a subpass of secondary buffers
+  if (contents == VK_SUBPASS_CONTENTS_INLINE) {
+    set_viewport_and_scissor(buffer, framebuffer);
+  }
 }
 
 auto SceneRenderer::explicit_clear(const CommandBuffer &buffer,
@@ -213,20 +289,11 @@ auto SceneRenderer::bind_vertex_buffer(const CommandBuffer &buffer,
 auto SceneRenderer::submit_static_mesh(const Mesh *mesh,
                                        const glm::mat4 &transform) -> void {
   for (const auto &submesh : mesh->get_submeshes()) {
-    CommandKey key{mesh, submesh};
-
-    auto &command = draw_commands[key];
-    command.mesh_ptr = mesh;
-    command.submesh_index = submesh;
-    command.transforms_and_instances.push_back(transform);
-    command.material = mesh->get_material(submesh);
+    draw_list.submit(mesh, submesh, mesh->get_material(submesh), transform);
 
     if (mesh->casts_shadows()) {
-      auto &shadow_command = shadow_draw_commands[key];
-      shadow_command.mesh_ptr = mesh;
-      shadow_command.submesh_index = submesh;
-      shadow_command.transforms_and_instances.push_back(transform);
-      shadow_command.material = shadow_material.get();
+      shadow_draw_list.submit(mesh, submesh, shadow_material.get(),
+                              transform);
     }
   }
 }
@@ -345,72 +412,132 @@ auto SceneRenderer::begin_frame(const Device &device, u32 frame,
                          writes.data(), 0, nullptr);
 }
 
-auto SceneRenderer::shadow_pass(const CommandBuffer &buffer, u32 frame)
+auto SceneRenderer::build_queue(RenderQueue &queue, const DrawList &draws,
+                                const GraphicsPipeline &pipeline) -> void {
+  queue.clear();
+  const auto pipeline_id = static_cast<u32>(pipeline.hash());
+  for (u32 draw = 0; draw < draws.size(); ++draw) {
+    if (draws.get_instance_count(draw) == 0) {
+      continue;
+    }
+    const auto *material = draws.get_material(draw);
+    queue.push(RenderQueue::make_key(
+                   pipeline_id, material != nullptr ? material->get_id() : 0,
+                   draws.get_mesh(draw)->get_id(),
+                   draws.get_submesh_index(draw)),
+               draw);
+  }
+  queue.sort();
+}
+
+auto SceneRenderer::bind_mesh_buffers(const CommandBuffer &buffer,
+                                      RenderQueue::Statistics &statistics,
+                                      const Mesh &mesh, BoundState &bound)
     -> void {
-  bind_pipeline(buffer, *shadow_pipeline);
-  for (const auto &[mesh_ptr, submesh_index, transforms_and_instances,
-                    material] : shadow_draw_commands | std::views::values) {
-    const auto &transforms = ssbos->get(2, frame);
-    transforms->write(transforms_and_instances.data(),
-                      transforms_and_instances.size() * sizeof(glm::mat4));
+  const auto *vertex_buffer = mesh.get_vertex_buffer().get();
+  const auto vertex_elided = vertex_buffer == bound.vertex_buffer;
+  if (!vertex_elided) {
+    bind_vertex_buffer(buffer, *vertex_buffer);
+    bound.vertex_buffer = vertex_buffer;
+  }
+  statistics.count_bind(vertex_elided);
 
-    const auto &submesh = mesh_ptr->get_submesh(submesh_index);
+  const auto *index_buffer = mesh.get_index_buffer().get();
+  const auto index_elided = index_buffer == bound.index_buffer;
+  if (!index_elided) {
+    bind_index_buffer(buffer, *index_buffer);
+    bound.index_buffer = index_buffer;
+  }
+  statistics.count_bind(index_elided);
+}
 
-    if (material) {
-      update_material_for_rendering(FrameIndex{frame}, *material, ubos.get(),
-                                    ssbos.get());
-      material->bind(buffer, *shadow_pipeline, frame);
+auto SceneRenderer::prepare_materials(Pass pass, u32 frame) -> void {
+  const auto is_shadow = pass == Pass::Shadow;
+  const auto &draws = is_shadow ? shadow_draw_list : draw_list;
+  const auto &queue = is_shadow ? shadow_queue : geometry_queue;
+
+  // Entries are sorted by material, so each one is seen in a single run
+  const Material *previous = nullptr;
+  for (const auto &entry : queue.get_entries()) {
+    auto *material = draws.get_material(entry.index);
+    if (material == nullptr || material == previous) {
+      continue;
     }
+    previous = material;
 
-    bind_vertex_buffer(buffer, *mesh_ptr->get_vertex_buffer());
-    bind_index_buffer(buffer, *mesh_ptr->get_index_buffer());
+    if (!is_shadow) {
+      material->set("shadow_map", *shadow_framebuffer->get_depth_image());
+    }
+    update_material_for_rendering(FrameIndex{frame}, *material, ubos.get(),
+                                  ssbos.get());
+  }
 
-    draw(buffer, {
-                     .index_count = submesh.index_count,
-                     .instance_count =
-                         static_cast<u32>(transforms_and_instances.size()),
-                     .first_index = submesh.base_index,
-                 });
+  if (!is_shadow) {
+    update_material_for_rendering(FrameIndex{frame}, *grid_material,
+                                  ubos.get(), ssbos.get());
   }
 }
 
-auto SceneRenderer::geometry_pass(const CommandBuffer &buffer, u32 frame)
-    -> void {
-  bind_pipeline(buffer, *geometry_pipeline);
-  for (auto &&[mesh_ptr, submesh_index, transforms_and_instances, material] :
-       draw_commands | std::views::values) {
+auto SceneRenderer::record_draws(const CommandBuffer &buffer, u32 frame,
+                                 Pass pass,
+                                 std::span<const RenderQueue::Entry> entries,
+                                 RenderQueue::Statistics &statistics) -> void {
+  const auto is_shadow = pass == Pass::Shadow;
+  const auto &draws = is_shadow ? shadow_draw_list : draw_list;
+  const auto &pipeline = is_shadow ? *shadow_pipeline : *geometry_pipeline;
 
-    const auto &transforms = ssbos->get(2, frame);
-    transforms->write(transforms_and_instances.data(),
-                      transforms_and_instances.size() * sizeof(glm::mat4));
+  // Not bind_pipeline, which tracks state shared between recording threads
+  pipeline.bind(buffer);
+  BoundState bound{};
+  for (const auto &entry : entries) {
+    const auto draw = entry.index;
+    // The first draw of a batch records the indirect draw for all of them
+    const auto command = draws.get_draw_index(draw);
+    const auto batch_index =
+        gpu_driven ? draw_cull_data.at(command).batch_index : 0;
+    if (gpu_driven &&
+        indirect_batches.at(batch_index).first_command != command) {
+      continue;
+    }
 
-    const auto &submesh = mesh_ptr->get_submesh(submesh_index);
+    const auto *mesh_ptr = draws.get_mesh(draw);
+    const auto *material = draws.get_material(draw);
+    const auto &submesh = mesh_ptr->get_submesh(draws.get_submesh_index(draw));
 
+    // Draws are sorted by material, so its sets and constants only change
+    // when the material does.
     if (material) {
-      material->set("shadow_map", *shadow_framebuffer->get_depth_image());
-      update_material_for_rendering(FrameIndex{frame}, *material, ubos.get(),
-                                    ssbos.get());
-      material->bind(buffer, *geometry_pipeline, frame);
+      const auto elided = material == bound.material;
+      if (!elided) {
+        material->bind(buffer, pipeline, frame);
+        if (!is_shadow) {
+          push_constants(buffer, pipeline, *material);
+        }
+        bound.material = material;
+      }
+      statistics.count_bind(elided);
     }
 
-    bind_vertex_buffer(buffer, *mesh_ptr->get_vertex_buffer());
-    bind_index_buffer(buffer, *mesh_ptr->get_index_buffer());
+    bind_mesh_buffers(buffer, statistics, *mesh_ptr, bound);
+    statistics.count_draw();
 
-    push_constants(buffer, *geometry_pipeline, *material);
+    if (gpu_driven) {
+      draw_indirect(buffer, frame, batch_index);
+      continue;
+    }
 
-    draw(buffer, {
-                     .index_count = submesh.index_count,
-                     .instance_count =
-                         static_cast<u32>(transforms_and_instances.size()),
-                     .first_index = submesh.base_index,
-                 });
+    this->draw(buffer, {
+                           .index_count = submesh.index_count,
+                           .instance_count = draws.get_instance_count(draw),
+                           .first_index = submesh.base_index,
+                           .first_instance = draws.get_first_instance(draw),
+                       });
   }
 }
 
-auto SceneRenderer::grid_pass(const CommandBuffer &buffer, u32 frame) -> void {
-  bind_pipeline(buffer, *grid_pipeline);
-  update_material_for_rendering(FrameIndex{frame}, *grid_material, ubos.get(),
-                                ssbos.get());
+auto SceneRenderer::record_grid(const CommandBuffer &buffer, u32 frame)
+    -> void {
+  grid_pipeline->bind(buffer);
   grid_material->bind(buffer, *grid_pipeline, frame);
   const auto &grid_submesh = grid_mesh->get_submesh(0);
 
@@ -426,22 +553,305 @@ auto SceneRenderer::grid_pass(const CommandBuffer &buffer, u32 frame) -> void {
                });
 }
 
-auto SceneRenderer::flush(const CommandBuffer &buffer, u32 frame) -> void {
-  begin_renderpass(buffer, *shadow_framebuffer);
-  shadow_pass(buffer, frame);
-  end_renderpass(buffer);
+auto SceneRenderer::record_pass(const CommandBuffer &buffer, u32 frame,
+                                Pass pass) -> void {
+  const auto is_shadow = pass == Pass::Shadow;
+  auto &queue = is_shadow ? shadow_queue : geometry_queue;
+  const auto &framebuffer =
+      is_shadow ? *shadow_framebuffer : *geometry_framebuffer;
+  const auto entries = queue.get_entries();
+
+  prepare_materials(pass, frame);
+
+  const auto entry_count = static_cast<u32>(entries.size());
+  if (entry_count < parallel_draw_threshold) {
+    begin_renderpass(buffer, framebuffer);
+    if (!is_shadow) {
+      record_grid(buffer, frame);
+    }
+    RenderQueue::Statistics statistics{};
+    record_draws(buffer, frame, pass, entries, statistics);
+    queue.add_statistics(statistics);
+    end_renderpass(buffer);
+    return;
+  }
+
+  const auto chunk_count = std::min(
+      chunk_slots,
+      (entry_count + minimum_draws_per_chunk - 1) / minimum_draws_per_chunk);
+  const auto chunk_size = (entry_count + chunk_count - 1) / chunk_count;
+  const auto &chunk_buffers =
+      secondary_command_buffers.at(static_cast<usize>(pass));
+
+  std::array<RenderQueue::Statistics, chunk_slots> statistics{};
+  const auto record_chunk = [this, &framebuffer, &chunk_buffers, &statistics,
+                             entries, entry_count, chunk_size, frame,
+                             pass](usize chunk_index) {
+    const auto chunk = static_cast<u32>(chunk_index);
+    const auto first = chunk * chunk_size;
+    const auto count = std::min(chunk_size, entry_count - first);
+    auto &secondary = *chunk_buffers.at(chunk);
+    const VkCommandBufferInheritanceInfo inheritance{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+        .renderPass = framebuffer.get_render_pass(),
+        .subpass = 0,
+        .framebuffer = framebuffer.get_framebuffer(),
+    };
+    VkCommandBufferBeginInfo begin_info{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+                 VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+        .pInheritanceInfo = &inheritance,
+    };
+    secondary.begin(frame, begin_info);
+    set_viewport_and_scissor(secondary, framebuffer);
+    // The subpass only executes secondary buffers, so the grid goes first
+    if (pass == Pass::Geometry && chunk == 0) {
+      record_grid(secondary, frame);
+    }
+    record_draws(secondary, frame, pass, entries.subspan(first, count),
+                 statistics.at(chunk));
+    secondary.end();
+  };
+  // Rethrows anything thrown while recording a chunk
+  JobSystem::parallel_for(0, chunk_count, 1, record_chunk).wait();
+
+  std::vector<VkCommandBuffer> secondaries;
+  secondaries.reserve(chunk_count);
+  for (u32 chunk = 0; chunk < chunk_count; ++chunk) {
+    secondaries.push_back(chunk_buffers.at(chunk)->get_command_buffer());
+    queue.add_statistics(statistics.at(chunk));
+  }
 
-  begin_renderpass(buffer, *geometry_framebuffer);
-  grid_pass(buffer, frame);
-  geometry_pass(buffer, frame);
+  begin_renderpass(buffer, framebuffer,
+                   VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+  vkCmdExecuteCommands(buffer.get_command_buffer(),
+                       static_cast<u32>(secondaries.size()),
+                       secondaries.data());
   end_renderpass(buffer);
+}
+
+auto SceneRenderer::upload_transforms(u32 frame) -> void {
+  // Each pass is bounded by its own region, so neither crowds out the other
+  const auto transforms = std::span{transform_data.transforms};
+  auto offset =
+      draw_list.pack(transforms.first(Config::transform_buffer_size), 0);
+  offset = shadow_draw_list.pack(
+      transforms.first(offset + Config::transform_buffer_size), offset);
+  packed_instance_count = offset;
+
+  if (offset == 0) {
+    return;
+  }
 
+  if (!gpu_driven) {
+    const auto &transforms = ssbos->get(2, frame);
+    transforms->write(transform_data.transforms.data(),
+                      offset * sizeof(glm::mat4));
+    return;
+  }
+
+  instance_draw_indices.resize(offset);
+  draw_cull_data.clear();
   draw_commands.clear();
-  shadow_draw_commands.clear();
+  indirect_batches.clear();
+  build_indirect_batches(draw_list, geometry_queue, 0);
+  build_indirect_batches(shadow_draw_list, shadow_queue, 1);
+
+  extract_frustum_planes(renderer_ubo.view_projection,
+                         std::span{culling_ubo.planes}.subspan<0, 6>());
+  extract_frustum_planes(shadow_ubo.view_projection,
+                         std::span{culling_ubo.planes}.subspan<6, 6>());
+  culling_ubo.instance_count.x = offset;
+  culling_ubo.instance_count.y = static_cast<u32>(draw_commands.size());
+  ubos->get(4, frame)->write(culling_ubo);
+
+  batch_counts.assign(indirect_batches.size(), 0);
+  ssbos->get(5, frame)->write(transform_data.transforms.data(),
+                              offset * sizeof(glm::mat4));
+  // Only written by the cull pass
+  ssbos->get(2, frame)->reserve();
+  ssbos->get(6, frame)->write(std::span{instance_draw_indices});
+  ssbos->get(7, frame)->write(std::span{draw_cull_data});
+  ssbos->get(9, frame)->write(std::span{batch_counts});
+  ssbos->get(10, frame)->write(std::span{draw_commands});
+}
+
+auto SceneRenderer::hint_streamed_textures() -> void {
+  if (texture_streamer == nullptr) {
+    return;
+  }
+
+  const auto viewport = glm::vec2{extent.width, extent.height};
+  for (u32 draw = 0; draw < draw_list.size(); ++draw) {
+    const auto *mesh = draw_list.get_mesh(draw);
+    const auto submesh_index = draw_list.get_submesh_index(draw);
+    const auto textures = mesh->get_streamed_textures(submesh_index);
+    if (textures.empty()) {
+      continue;
+    }
+
+    // The largest instance decides the level every instance samples from
+    const auto &box = mesh->get_submesh(submesh_index).bounding_box;
+    const auto first_instance = draw_list.get_first_instance(draw);
+    glm::vec2 coverage{0.0F};
+    for (u32 i = 0; i < draw_list.get_instance_count(draw); ++i) {
+      const auto &transform = transform_data.transforms[first_instance + i];
+      coverage = glm::max(
+          coverage,
+          projected_coverage(renderer_ubo.view_projection * transform, box));
+    }
+
+    const auto on_screen = glm::ceil(coverage * viewport);
+    const Extent<u32> screen_extent{
+        static_cast<u32>(on_screen.x),
+        static_cast<u32>(on_screen.y),
+    };
+    for (const auto *texture : textures) {
+      texture_streamer->hint_screen_extent(*texture, screen_extent);
+    }
+  }
+}
+
+auto SceneRenderer::build_indirect_batches(DrawList &draws,
+                                           const RenderQueue &queue,
+                                           u32 frustum_index) -> void {
+  // Entries are sorted by material and mesh, so each batch is one run
+  const auto first_batch = indirect_batches.size();
+  const Material *batch_material = nullptr;
+  const Mesh *batch_mesh = nullptr;
+  for (const auto &entry : queue.get_entries()) {
+    const auto draw = entry.index;
+    const auto *material = draws.get_material(draw);
+    const auto *mesh = draws.get_mesh(draw);
+    const auto command = static_cast<u32>(draw_commands.size());
+    if (indirect_batches.size() == first_batch || material != batch_material ||
+        mesh != batch_mesh) {
+      indirect_batches.push_back({.first_command = command});
+      batch_material = material;
+      batch_mesh = mesh;
+    }
+    auto &batch = indirect_batches.back();
+    ++batch.command_count;
+
+    const auto count = draws.get_instance_count(draw);
+    const auto first_instance = draws.get_first_instance(draw);
+    const auto &submesh = mesh->get_submesh(draws.get_submesh_index(draw));
+    draws.set_draw_index(draw, command);
+    std::fill_n(instance_draw_indices.begin() + first_instance, count,
+                command);
+    draw_cull_data.push_back({
+        .aabb_min = submesh.bounding_box.min_vector(),
+        .aabb_max = submesh.bounding_box.max_vector(),
+        .frustum_index = frustum_index,
+        .instance_offset = first_instance,
+        .batch_index = static_cast<u32>(indirect_batches.size() - 1),
+        .batch_offset = batch.first_command,
+    });
+    // The cull pass fills in instanceCount
+    draw_commands.push_back({
+        .indexCount = submesh.index_count,
+        .instanceCount = 0,
+        .firstIndex = submesh.base_index,
+        .vertexOffset = 0,
+        .firstInstance = first_instance,
+    });
+  }
+}
+
+auto SceneRenderer::cull_pass(const CommandBuffer &buffer, u32 frame)
+    -> void {
+  if (!gpu_driven || packed_instance_count == 0) {
+    return;
+  }
+
+  cull_pipeline->bind(buffer);
+  update_material_for_rendering(FrameIndex{frame}, *cull_material, ubos.get(),
+                                ssbos.get());
+  cull_material->bind(buffer, *cull_pipeline, frame);
+
+  CommandDispatcher dispatcher{&buffer};
+  dispatcher.dispatch({
+      .group_count_x =
+          (packed_instance_count + cull_group_size - 1) / cull_group_size,
+  });
+
+  // Compaction reads the instance counts written by the cull pass
+  const VkMemoryBarrier counted{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+  };
+  vkCmdPipelineBarrier(buffer.get_command_buffer(),
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &counted, 0,
+                       nullptr, 0, nullptr);
+
+  compact_pipeline->bind(buffer);
+  update_material_for_rendering(FrameIndex{frame}, *compact_material,
+                                ubos.get(), ssbos.get());
+  compact_material->bind(buffer, *compact_pipeline, frame);
+  const auto draw_count = static_cast<u32>(draw_commands.size());
+  dispatcher.dispatch({
+      .group_count_x = (draw_count + cull_group_size - 1) / cull_group_size,
+  });
+
+  // Visible transforms are read by the vertex shaders, the compacted
+  // commands and batch counts by the indirect draws.
+  VkMemoryBarrier barrier{
+      .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+      .dstAccessMask =
+          VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+  };
+  vkCmdPipelineBarrier(buffer.get_command_buffer(),
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                           VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+                       0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+auto SceneRenderer::draw_indirect(const CommandBuffer &buffer, u32 frame,
+                                  u32 batch_index) -> void {
+  const auto &commands = ssbos->get(8, frame);
+  const auto &counts = ssbos->get(9, frame);
+  const auto &batch = indirect_batches.at(batch_index);
+  // The count is zero when every draw of the batch was culled
+  vkCmdDrawIndexedIndirectCount(
+      buffer.get_command_buffer(), commands->get_buffer(),
+      commands->get_offset() +
+          batch.first_command * sizeof(VkDrawIndexedIndirectCommand),
+      counts->get_buffer(), counts->get_offset() + batch_index * sizeof(u32),
+      batch.command_count, sizeof(VkDrawIndexedIndirectCommand));
+}
+
+auto SceneRenderer::flush(const CommandBuffer &buffer, u32 frame) -> void {
+  build_queue(shadow_queue, shadow_draw_list, *shadow_pipeline);
+  build_queue(geometry_queue, draw_list, *geometry_pipeline);
+  upload_transforms(frame);
+  hint_streamed_textures();
+  cull_pass(buffer, frame);
+
+  record_pass(buffer, frame, Pass::Shadow);
+  record_pass(buffer, frame, Pass::Geometry);
+
+  draw_list.clear();
+  shadow_draw_list.clear();
 }
 
 auto SceneRenderer::end_frame() -> void {}
 
+auto SceneRenderer::construct_geometry_shader(const Device &device)
+    -> Scope<Shader> {
+  if (device.check_support(Feature::Bindless)) {
+    return Shader::construct(device, FS::shader("BasicBindless.vert.spv"),
+                             FS::shader("BasicBindless.frag.spv"),
+                             frame_bindings);
+  }
+  return Shader::construct(device, FS::shader("Basic.vert.spv"),
+                           FS::shader("Basic.frag.spv"), frame_bindings);
+}
+
 void SceneRenderer::push_constants(const CommandBuffer &buffer,
                                    const GraphicsPipeline &pipeline,
                                    const Material &material) {
@@ -466,16 +876,28 @@ void SceneRenderer::update_material_for_rendering(
     return;
   }
 
-  auto write_descriptors =
-      create_or_get_write_descriptor_for<Buffer::Type::Uniform>(
-          Config::frame_count, ubo_set, material_for_update);
+  // The combined ubo and ssbo writes only depend on the shader and the
+  // buffer sets, so they are built once instead of copied per draw.
+  usize combined_key = material_for_update.get_shader().hash();
+  hash_combine(combined_key, static_cast<const void *>(ubo_set));
+  hash_combine(combined_key, static_cast<const void *>(sbo_set));
+
+  auto [iterator, inserted] =
+      combined_write_descriptors.try_emplace(combined_key);
+  auto &write_descriptors = iterator->second;
+  if (inserted) {
+    write_descriptors =
+        create_or_get_write_descriptor_for<Buffer::Type::Uniform>(
+            Config::frame_count, ubo_set, material_for_update);
+  }
 
-  if (sbo_set != nullptr) {
+  if (inserted && sbo_set != nullptr) {
     const auto &storage_buffer_write_sets =
         create_or_get_write_descriptor_for<Buffer::Type::Storage>(
             Config::frame_count, sbo_set, material_for_update);
 
     if (!storage_buffer_write_sets.empty()) {
+      write_descriptors.resize(Config::frame_count);
       for (u32 frame = 0; frame < Config::frame_count; ++frame) {
         auto &ubo_frame_descriptors = write_descriptors[frame];
         const auto &sbo_frame_descriptors = storage_buffer_write_sets[frame];
@@ -487,7 +909,26 @@ void SceneRenderer::update_material_for_rendering(
     }
   }
 
-  material_for_update.update_for_rendering(frame_index, write_descriptors);
+  // The writes stay the same, the transient ranges move every frame
+  const auto &shader = material_for_update.get_shader();
+  const auto &descriptor_sets =
+      shader.get_reflection_data().shader_descriptor_sets;
+  dynamic_offsets.clear();
+  // Dynamic bindings are only ever in set 0
+  for (const auto binding : shader.get_dynamic_bindings()) {
+    u32 offset = 0;
+    if (descriptor_sets[0].uniform_buffers.contains(binding)) {
+      if (ubo_set->contains(binding, frame_index)) {
+        offset = ubo_set->get(binding, frame_index)->get_dynamic_offset();
+      }
+    } else if (sbo_set != nullptr && sbo_set->contains(binding, frame_index)) {
+      offset = sbo_set->get(binding, frame_index)->get_dynamic_offset();
+    }
+    dynamic_offsets.push_back(offset);
+  }
+
+  material_for_update.update_for_rendering(frame_index, write_descriptors,
+                                           dynamic_offsets);
 }
 
 auto SceneRenderer::get_output_image() const -> const Image & {
@@ -500,6 +941,7 @@ auto SceneRenderer::get_depth_image() const -> const Image & {
 
 auto SceneRenderer::create(const Device &device, const Swapchain &swapchain)
     -> void {
+  texture_streamer = &device.get_texture_streamer();
 
   FramebufferProperties props{
       .width = swapchain.get_extent().width,
@@ -537,34 +979,19 @@ auto SceneRenderer::create(const Device &device, const Swapchain &swapchain)
   };
   shadow_framebuffer = Framebuffer::construct(device, shadow_props);
 
-  DataBuffer white_data(sizeof(u32));
-  u32 white = 0xFFFFFFFF;
-  white_data.write(&white, sizeof(u32));
-  white_texture = Texture::construct_from_buffer(
-      device,
-      {
-          .format = ImageFormat::UNORM_RGBA8,
-          .extent =
-              {
-                  1,
-                  1,
-              },
-          .usage = ImageUsage::Sampled | ImageUsage::TransferDst |
-                   ImageUsage::TransferSrc,
-          .layout = ImageLayout::ShaderReadOnlyOptimal,
-      },
-      std::move(white_data));
-
-  disarray_texture = Texture::construct(device, FS::texture("D.png"));
-  sphere_mesh = Mesh::import_from(device, FS::model("sphere.fbx"));
-  cube_mesh = Mesh::import_from(device, FS::model("cube.fbx"));
-
   shadow_shader = Shader::construct(device, FS::shader("Shadow.vert.spv"),
-                                    FS::shader("Shadow.frag.spv"));
+                                    FS::shader("Shadow.frag.spv"),
+                                    frame_bindings);
   shadow_material = Material::construct(device, *shadow_shader);
-  geometry_shader = Shader::construct(device, FS::shader("Basic.vert.spv"),
-                                      FS::shader("Basic.frag.spv"));
+  geometry_shader = construct_geometry_shader(device);
+  info("Geometry pass uses {} textures",
+       is_bindless() ? "bindless" : "per-material");
+  grid_shader = Shader::construct(device, FS::shader("Grid.vert.spv"),
+                                  FS::shader("Grid.frag.spv"), frame_bindings);
+  grid_material = Material::construct(device, *grid_shader);
 
+  // Pipelines compile on the JobSystem while the meshes and textures below
+  // load, and are waited for at the end.
   GraphicsPipelineConfiguration config{
       .name = "DefaultGraphicsPipeline",
       .shader = geometry_shader.get(),
@@ -582,11 +1009,8 @@ auto SceneRenderer::create(const Device &device, const Swapchain &swapchain)
       .cull_mode = CullMode::Back,
       .face_mode = FaceMode::CounterClockwise,
   };
-  geometry_pipeline = GraphicsPipeline::construct(device, config);
+  auto pending_geometry = PipelineCompiler::compile(device, config);
 
-  grid_shader = Shader::construct(device, FS::shader("Grid.vert.spv"),
-                                  FS::shader("Grid.frag.spv"));
-  grid_material = Material::construct(device, *grid_shader);
   GraphicsPipelineConfiguration grid_config{
       .name = "GridPipeline",
       .shader = grid_shader.get(),
@@ -604,8 +1028,7 @@ auto SceneRenderer::create(const Device &device, const Swapchain &swapchain)
       .cull_mode = CullMode::Back,
       .face_mode = FaceMode::CounterClockwise,
   };
-  grid_pipeline = GraphicsPipeline::construct(device, grid_config);
-  grid_mesh = Mesh::import_from(device, FS::model("cube.fbx"));
+  auto pending_grid = PipelineCompiler::compile(device, grid_config);
 
   GraphicsPipelineConfiguration shadow_config{
       .name = "ShadowGraphicsPipeline",
@@ -624,7 +1047,77 @@ auto SceneRenderer::create(const Device &device, const Swapchain &swapchain)
       .cull_mode = CullMode::Back,
       .face_mode = FaceMode::CounterClockwise,
   };
-  shadow_pipeline = GraphicsPipeline::construct(device, shadow_config);
+  auto pending_shadow = PipelineCompiler::compile(device, shadow_config);
+
+  std::future<Scope<Pipeline>> pending_cull;
+  std::future<Scope<Pipeline>> pending_compact;
+  supports_gpu_driven = device.check_support(Feature::DrawIndirectCount);
+  if (supports_gpu_driven) {
+    cull_shader = Shader::construct(
+        device, FS::shader("FrustumCull.comp.spv"), frame_bindings);
+    cull_material = Material::construct(device, *cull_shader);
+    pending_cull = PipelineCompiler::compile(device, PipelineConfiguration{
+                                                         "FrustumCull",
+                                                         PipelineStage::Compute,
+                                                         *cull_shader,
+                                                     });
+    compact_shader = Shader::construct(
+        device, FS::shader("CompactDraws.comp.spv"), frame_bindings);
+    compact_material = Material::construct(device, *compact_shader);
+    pending_compact =
+        PipelineCompiler::compile(device, PipelineConfiguration{
+                                              "CompactDraws",
+                                              PipelineStage::Compute,
+                                              *compact_shader,
+                                          });
+  } else {
+    info("Indirect draw counts are unsupported, culling stays on the CPU.");
+  }
+  // The pipelines exist whenever supported, so either path can be toggled
+  set_gpu_driven(Config::gpu_driven_rendering);
+
+  DataBuffer white_data(sizeof(u32));
+  u32 white = 0xFFFFFFFF;
+  white_data.write(&white, sizeof(u32));
+  white_texture = Texture::construct_from_buffer(
+      device,
+      {
+          .format = ImageFormat::UNORM_RGBA8,
+          .extent =
+              {
+                  1,
+                  1,
+              },
+          .usage = ImageUsage::Sampled | ImageUsage::TransferDst |
+                   ImageUsage::TransferSrc,
+          .layout = ImageLayout::ShaderReadOnlyOptimal,
+      },
+      std::move(white_data));
+
+  disarray_texture = Texture::construct(device, FS::texture("D.png"));
+  sphere_mesh = Mesh::import_from(device, FS::model("sphere.fbx"));
+  cube_mesh = Mesh::import_from(device, FS::model("cube.fbx"));
+
+  grid_mesh = Mesh::import_from(device, FS::model("cube.fbx"));
+
+  geometry_pipeline = pending_geometry.get();
+  grid_pipeline = pending_grid.get();
+  shadow_pipeline = pending_shadow.get();
+  if (pending_cull.valid()) {
+    cull_pipeline = pending_cull.get();
+    compact_pipeline = pending_compact.get();
+  }
+
+  for (auto &chunk_buffers : secondary_command_buffers) {
+    chunk_buffers.clear();
+    for (u32 chunk = 0; chunk < chunk_slots; ++chunk) {
+      chunk_buffers.push_back(CommandBuffer::construct(
+          device, {
+                      .queue_type = Queue::Type::Graphics,
+                      .is_primary = false,
+                  }));
+    }
+  }
 
   std::array<VkDescriptorPoolSize, 4> pool_sizes = {
       VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
@@ -689,11 +1182,27 @@ auto SceneRenderer::create(const Device &device, const Swapchain &swapchain)
                               &layout);
 
   ubos = make_scope<BufferSet<Buffer::Type::Uniform>>(device);
-  ubos->create(sizeof(RendererUBO), SetBinding(0));
-  ubos->create(sizeof(ShadowUBO), SetBinding(1));
-  ubos->create(sizeof(GridUBO), SetBinding(3));
+  ubos->create_transient(sizeof(RendererUBO), SetBinding(0));
+  ubos->create_transient(sizeof(ShadowUBO), SetBinding(1));
+  ubos->create_transient(sizeof(GridUBO), SetBinding(3));
   ssbos = make_scope<BufferSet<Buffer::Type::Storage>>(device);
-  ssbos->create(sizeof(TransformData), SetBinding(2));
+  ssbos->create_transient(sizeof(TransformData), SetBinding(2));
+
+  if (supports_gpu_driven) {
+    // At most one draw per instance
+    static constexpr auto max_draws = max_instances;
+    ubos->create_transient(sizeof(CullingUBO), SetBinding(4));
+    ssbos->create_transient(sizeof(TransformData), SetBinding(5));
+    ssbos->create(max_draws * sizeof(u32), SetBinding(6));
+    ssbos->create(max_draws * sizeof(DrawCullData), SetBinding(7));
+    // Only the compacted commands and the batch counts are read by draws
+    ssbos->create(max_draws * sizeof(VkDrawIndexedIndirectCommand),
+                  SetBinding(8), Buffer::Role::IndirectArguments);
+    ssbos->create(max_draws * sizeof(u32), SetBinding(9),
+                  Buffer::Role::IndirectArguments);
+    ssbos->create(max_draws * sizeof(VkDrawIndexedIndirectCommand),
+                  SetBinding(10));
+  }
 }
 
 } // namespace Core
@@ -2,12 +2,15 @@
 
 #include "Shader.hpp"
 
+#include "BindlessTextures.hpp"
 #include "Containers.hpp"
+#include "ContentHash.hpp"
 #include "Device.hpp"
 #include "Exception.hpp"
 #include "Logger.hpp"
 #include "Verify.hpp"
 
+#include <algorithm>
 #include <bit>
 #include <fstream>
 #include <sstream>
@@ -45,8 +48,9 @@ auto read_file(const std::filesystem::path &path) -> std::string {
 
 Shader::Shader(
     const Device &dev,
-    const std::unordered_set<PathShaderType, Hasher, std::equal_to<>> &types)
-    : device(dev) {
+    const std::unordered_set<PathShaderType, Hasher, std::equal_to<>> &types,
+    std::span<const u32> dynamic)
+    : device(dev), dynamic_bindings(dynamic.begin(), dynamic.end()) {
   std::stringstream name_stream;
   if (types.size() > 1) {
     name_stream << "Combined-";
@@ -69,19 +73,26 @@ Shader::Shader(
   reflector.reflect(descriptor_set_layouts, reflection_data);
   name = name_stream.str();
   create_descriptor_set_layouts();
+  cached_hash = compute_hash();
 }
 
 Shader::~Shader() {
   for (const auto &[type, shader_module] : shader_modules) {
     vkDestroyShaderModule(device.get_device(), shader_module, nullptr);
   }
-  for (const auto &layout : descriptor_set_layouts) {
-    vkDestroyDescriptorSetLayout(device.get_device(), layout, nullptr);
+  for (u32 set = 0; set < descriptor_set_layouts.size(); set++) {
+    if (uses_bindless_textures() && set == BindlessTextures::descriptor_set) {
+      continue;
+    }
+    vkDestroyDescriptorSetLayout(device.get_device(),
+                                 descriptor_set_layouts[set], nullptr);
   }
   debug("Destroyed Shader '{}'", name);
 }
 
-auto Shader::hash() const -> usize {
+auto Shader::hash() const -> usize { return cached_hash; }
+
+auto Shader::compute_hash() const -> usize {
   static constexpr std::hash<std::string> string_hasher;
   auto name_hash = string_hasher(name);
   if (parsed_spirv_per_stage.contains(Type::Compute)) {
@@ -93,6 +104,10 @@ auto Shader::hash() const -> usize {
   if (parsed_spirv_per_stage.contains(Type::Fragment)) {
     name_hash ^= string_hasher(parsed_spirv_per_stage.at(Type::Fragment));
   }
+  // Dynamic bindings change the set layouts
+  for (const auto binding : dynamic_bindings) {
+    hash_combine(name_hash, binding);
+  }
   return name_hash;
 }
 
@@ -139,19 +154,57 @@ auto Shader::allocate_descriptor_set(u32 set) const
   return result;
 }
 
+auto Shader::allocate_persistent_descriptor_set(u32 set) const
+    -> PersistentDescriptorSet {
+  ensure(has_descriptor_set(set), "Shader has no such descriptor set");
+
+  VkDescriptorSetAllocateInfo allocation_info = {};
+  allocation_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+  allocation_info.descriptorSetCount = 1;
+  allocation_info.pSetLayouts = &descriptor_set_layouts[set];
+  return device.get_descriptor_resource()->allocate_persistent_descriptor_set(
+      allocation_info);
+}
+
 auto Shader::create_descriptor_set_layouts() -> void {
   auto *vk_device = device.get_device();
   auto &descriptor_sets = reflection_data.shader_descriptor_sets;
 
+  const auto requested = std::move(dynamic_bindings);
+  dynamic_bindings.clear();
+  const auto make_dynamic = [&](u32 set, u32 binding) {
+    if (set != 0 || std::ranges::find(requested, binding) == requested.end()) {
+      return false;
+    }
+    dynamic_bindings.push_back(binding);
+    return true;
+  };
+
   for (u32 set = 0; set < descriptor_sets.size(); set++) {
     auto &shader_descriptor_set = descriptor_sets[set];
 
+    // The global texture array is owned by the device, and shared by every
+    // shader which declares it.
+    if (const auto *bindless = device.get_bindless_textures();
+        bindless != nullptr && set == BindlessTextures::descriptor_set &&
+        shader_descriptor_set.sampled_images.contains(
+            BindlessTextures::binding)) {
+      if (set >= descriptor_set_layouts.size()) {
+        descriptor_set_layouts.resize(static_cast<std::size_t>(set) + 1);
+      }
+      descriptor_set_layouts[set] = bindless->get_layout();
+      bindless_textures = true;
+      continue;
+    }
+
     std::vector<VkDescriptorSetLayoutBinding> layout_bindings{};
     for (const auto &[binding, uniform_buffer] :
          shader_descriptor_set.uniform_buffers) {
       VkDescriptorSetLayoutBinding &layout_binding =
           layout_bindings.emplace_back();
-      layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+      layout_binding.descriptorType =
+          make_dynamic(set, binding) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
+                                     : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
       layout_binding.descriptorCount = 1;
       layout_binding.stageFlags = uniform_buffer.shader_stage;
       layout_binding.pImmutableSamplers = nullptr;
@@ -170,7 +223,9 @@ auto Shader::create_descriptor_set_layouts() -> void {
          shader_descriptor_set.storage_buffers) {
       VkDescriptorSetLayoutBinding &layout_binding =
           layout_bindings.emplace_back();
-      layout_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+      layout_binding.descriptorType =
+          make_dynamic(set, binding) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC
+                                     : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
       layout_binding.descriptorCount = 1;
       layout_binding.stageFlags = storage_buffer.shader_stage;
       layout_binding.pImmutableSamplers = nullptr;
@@ -328,6 +383,7 @@ auto Shader::create_descriptor_set_layouts() -> void {
            "vkCreateDescriptorSetLayout",
            "Failed to create descriptor set layout");
   }
+  std::ranges::sort(dynamic_bindings);
 }
 
 auto to_shader_type(const std::filesystem::path &path) {
@@ -360,19 +416,19 @@ auto to_shader_type(const std::filesystem::path &path) {
   return from_extension;
 }
 
-auto Shader::construct(const Device &device, const std::filesystem::path &path)
-    -> Scope<Shader> {
+auto Shader::construct(const Device &device, const std::filesystem::path &path,
+                       std::span<const u32> dynamic) -> Scope<Shader> {
   PathShaderType shader_type{
       .path = path,
       .type = to_shader_type(path),
   };
-  return Scope<Shader>{new Shader{device, {shader_type}}};
+  return Scope<Shader>{new Shader{device, {shader_type}, dynamic}};
 }
 
 auto Shader::construct(const Device &device,
                        const std::filesystem::path &vertex_path,
-                       const std::filesystem::path &fragment_path)
-    -> Scope<Shader> {
+                       const std::filesystem::path &fragment_path,
+                       std::span<const u32> dynamic) -> Scope<Shader> {
   std::unordered_set<PathShaderType, Hasher, std::equal_to<>> loaded{
       {
           .path = vertex_path,
@@ -382,7 +438,7 @@ auto Shader::construct(const Device &device,
           .path = fragment_path,
           .type = Shader::Type::Fragment,
       }};
-  return Scope<Shader>{new Shader{device, loaded}};
+  return Scope<Shader>{new Shader{device, loaded, dynamic}};
 }
 
 } // namespace Core
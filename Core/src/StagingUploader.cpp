@@ -0,0 +1,336 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "StagingUploader.hpp"
+
+#include "Allocator.hpp"
+#include "Config.hpp"
+#include "Image.hpp"
+#include "Verify.hpp"
+
+#include <array>
+#include <cstring>
+#include <vk_mem_alloc.h>
+
+namespace Core {
+
+struct StagingBufferImpl {
+  VkBuffer buffer{};
+  VmaAllocation allocation{};
+  VmaAllocationInfo allocation_info{};
+
+  explicit StagingBufferImpl(u64 size) {
+    Allocator allocator{"Staging Buffer", MemoryCategory::Staging};
+    VkBufferCreateInfo buffer_create_info{};
+    buffer_create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_create_info.size = size;
+    buffer_create_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    allocation = allocator.allocate_buffer(
+        buffer, allocation_info, buffer_create_info,
+        {
+            .usage = Usage::AUTO_PREFER_HOST,
+            .creation = Creation::HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                        Creation::MAPPED_BIT,
+        });
+  }
+
+  ~StagingBufferImpl() {
+    Allocator allocator{"Staging Buffer"};
+    allocator.deallocate_buffer(allocation, buffer);
+  }
+
+  [[nodiscard]] auto mapped() const -> u8 * {
+    return static_cast<u8 *>(allocation_info.pMappedData);
+  }
+};
+
+StagingUploader::Batch::Batch(StagingUploader &staging) : uploader(&staging) {
+  uploader->batch_depth++;
+}
+
+StagingUploader::Batch::~Batch() {
+  try {
+    uploader->end_batch();
+  } catch (...) {
+    error("Failed to flush staging uploads");
+  }
+}
+
+auto StagingUploader::construct(const Device &device)
+    -> Scope<StagingUploader> {
+  return Scope<StagingUploader>(new StagingUploader(device));
+}
+
+StagingUploader::StagingUploader(const Device &dev)
+    : device(&dev),
+      ring_buffer(make_scope<StagingBufferImpl>(Config::staging_buffer_size)),
+      ring(Config::staging_buffer_size) {
+  const auto graphics_family = device->get_family_index(Queue::Type::Graphics);
+  if (const auto transfer_family =
+          device->get_family_index(Queue::Type::Transfer)) {
+    transfer_queue = Queue::Type::Transfer;
+    needs_ownership_transfer = transfer_family != graphics_family;
+  } else {
+    transfer_queue = Queue::Type::Graphics;
+  }
+
+  transfer_command_buffer = CommandBuffer::construct(
+      *device, {
+                   .queue_type = transfer_queue,
+                   .count = command_slots,
+               });
+  if (needs_ownership_transfer) {
+    acquire_command_buffer = CommandBuffer::construct(
+        *device, {
+                     .queue_type = Queue::Type::Graphics,
+                     .count = command_slots,
+                 });
+  }
+
+  info("Created staging uploader with a {} ring on the {} queue",
+       human_readable_size(Config::staging_buffer_size), transfer_queue);
+}
+
+StagingUploader::~StagingUploader() {
+  flush();
+  while (!in_flight.empty()) {
+    wait_for_oldest();
+  }
+  transfer_command_buffer.reset();
+  acquire_command_buffer.reset();
+  oversized_buffers.clear();
+  ring_buffer.reset();
+}
+
+auto StagingUploader::begin_recording() -> void {
+  if (is_recording) {
+    return;
+  }
+  transfer_command_buffer->begin(batch_id % command_slots);
+  is_recording = true;
+}
+
+auto StagingUploader::end_batch() -> void {
+  ensure(batch_depth > 0, "Staging batch ended without being started");
+  if (--batch_depth == 0) {
+    flush();
+  }
+}
+
+auto StagingUploader::stage(std::span<const u8> data, u64 alignment)
+    -> std::pair<VkBuffer, u64> {
+  retire_completed();
+  auto offset = ring.allocate(data.size(), alignment, batch_id);
+  while (!offset && !ring.empty()) {
+    // The only place the uploader blocks: wait for the oldest submission,
+    // submitting this batch first if it alone fills the ring
+    if (in_flight.empty()) {
+      flush();
+      begin_recording();
+    }
+    wait_for_oldest();
+    offset = ring.allocate(data.size(), alignment, batch_id);
+  }
+
+  if (offset) {
+    std::memcpy(ring_buffer->mapped() + *offset, data.data(), data.size());
+    return {ring_buffer->buffer, *offset};
+  }
+
+  // Larger than the whole ring, gets its own buffer for this batch
+  auto &oversized = oversized_buffers.emplace_back(
+      make_scope<StagingBufferImpl>(data.size()));
+  std::memcpy(oversized->mapped(), data.data(), data.size());
+  return {oversized->buffer, 0};
+}
+
+auto StagingUploader::upload(VkBuffer destination, std::span<const u8> data,
+                             u64 destination_offset) -> void {
+  if (data.empty()) {
+    return;
+  }
+
+  begin_recording();
+  const auto [source, source_offset] = stage(data, 4);
+
+  const VkBufferCopy copy{
+      .srcOffset = source_offset,
+      .dstOffset = destination_offset,
+      .size = data.size(),
+  };
+  vkCmdCopyBuffer(transfer_command_buffer->get_command_buffer(), source,
+                  destination, 1, &copy);
+
+  if (needs_ownership_transfer) {
+    VkBufferMemoryBarrier release{
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = 0,
+        .srcQueueFamilyIndex = *device->get_family_index(transfer_queue),
+        .dstQueueFamilyIndex =
+            *device->get_family_index(Queue::Type::Graphics),
+        .buffer = destination,
+        .offset = destination_offset,
+        .size = data.size(),
+    };
+    vkCmdPipelineBarrier(transfer_command_buffer->get_command_buffer(),
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         1, &release, 0, nullptr);
+
+    auto &acquire = buffer_acquires.emplace_back(release);
+    acquire.srcAccessMask = 0;
+    acquire.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+  }
+
+  if (batch_depth == 0) {
+    flush();
+  }
+}
+
+auto StagingUploader::upload(const Image &image, std::span<const u8> data,
+                             std::span<const VkBufferImageCopy> regions,
+                             VkImageLayout final_layout) -> void {
+  if (data.empty() || regions.empty()) {
+    return;
+  }
+
+  begin_recording();
+  // Texel block sizes are at most 16 bytes
+  const auto [source, source_offset] = stage(data, 16);
+
+  const auto command_buffer = transfer_command_buffer->get_command_buffer();
+  const VkImageSubresourceRange range{
+      .aspectMask = image.get_aspect_mask(),
+      .baseMipLevel = 0,
+      .levelCount = VK_REMAINING_MIP_LEVELS,
+      .baseArrayLayer = 0,
+      .layerCount = VK_REMAINING_ARRAY_LAYERS,
+  };
+
+  VkImageMemoryBarrier to_transfer{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcAccessMask = 0,
+      .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image.get_image(),
+      .subresourceRange = range,
+  };
+  vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &to_transfer);
+
+  std::vector<VkBufferImageCopy> copies{regions.begin(), regions.end()};
+  for (auto &copy : copies) {
+    copy.bufferOffset += source_offset;
+  }
+  vkCmdCopyBufferToImage(command_buffer, source, image.get_image(),
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         static_cast<u32>(copies.size()), copies.data());
+
+  VkImageMemoryBarrier to_final{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+      .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+      .dstAccessMask = VK_ACCESS_SHADER_READ_BIT,
+      .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      .newLayout = final_layout,
+      .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+      .image = image.get_image(),
+      .subresourceRange = range,
+  };
+
+  if (needs_ownership_transfer) {
+    // Release here, the graphics queue acquires it with the same transition
+    to_final.dstAccessMask = 0;
+    to_final.srcQueueFamilyIndex = *device->get_family_index(transfer_queue);
+    to_final.dstQueueFamilyIndex =
+        *device->get_family_index(Queue::Type::Graphics);
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &to_final);
+
+    auto &acquire = image_acquires.emplace_back(to_final);
+    acquire.srcAccessMask = 0;
+    acquire.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  } else {
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &to_final);
+  }
+
+  if (batch_depth == 0) {
+    flush();
+  }
+}
+
+auto StagingUploader::flush() -> GpuFuture {
+  if (!is_recording) {
+    return in_flight.empty() ? GpuFuture{} : in_flight.back().future;
+  }
+  is_recording = false;
+
+  if (!needs_ownership_transfer) {
+    // Buffer copies become visible to everything recorded afterwards
+    VkMemoryBarrier barrier{
+        .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+        .srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT,
+    };
+    vkCmdPipelineBarrier(transfer_command_buffer->get_command_buffer(),
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0,
+                         nullptr, 0, nullptr);
+  }
+
+  auto future = transfer_command_buffer->end_and_submit_async();
+
+  if (needs_ownership_transfer) {
+    // Chained to the semaphore wait, so later graphics submissions are
+    // ordered after the copies without the CPU waiting for them
+    acquire_command_buffer->begin(batch_id % command_slots);
+    vkCmdPipelineBarrier(acquire_command_buffer->get_command_buffer(),
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+                         static_cast<u32>(buffer_acquires.size()),
+                         buffer_acquires.data(),
+                         static_cast<u32>(image_acquires.size()),
+                         image_acquires.data());
+    const std::array waits{SubmitWait{
+        .future = future,
+        .stage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+    }};
+    future = acquire_command_buffer->end_and_submit_async(waits);
+    buffer_acquires.clear();
+    image_acquires.clear();
+  }
+
+  in_flight.push_back({
+      .id = batch_id++,
+      .future = future,
+      .oversized_buffers = std::move(oversized_buffers),
+  });
+  oversized_buffers.clear();
+  return future;
+}
+
+auto StagingUploader::retire_completed() -> void {
+  while (!in_flight.empty() && in_flight.front().future.is_ready()) {
+    ring.retire(in_flight.front().id);
+    in_flight.pop_front();
+  }
+}
+
+auto StagingUploader::wait_for_oldest() -> void {
+  if (in_flight.empty()) {
+    return;
+  }
+  in_flight.front().future.wait();
+  ring.retire(in_flight.front().id);
+  in_flight.pop_front();
+}
+
+} // namespace Core
@@ -4,6 +4,7 @@
 
 #include "DataBuffer.hpp"
 #include "Formatters.hpp"
+#include "MappedFile.hpp"
 #include "Types.hpp"
 #include "Verify.hpp"
 
@@ -19,6 +20,9 @@ auto Texture::empty_with_size(const Device &device, usize size,
 
 auto Texture::construct(const Device &device,
                         const TextureProperties &properties) -> Scope<Texture> {
+  if (Ktx2Reader::is_ktx2(properties.path)) {
+    return construct_ktx2(device, properties);
+  }
   return Scope<Texture>(new Texture(device, properties));
 }
 
@@ -30,6 +34,9 @@ auto Texture::construct_shader(const Device &device,
   ensure(properties.layout == ImageLayout::ShaderReadOnlyOptimal,
          "Texture must be ShaderReadOnlyOptimal");
 
+  if (Ktx2Reader::is_ktx2(properties.path)) {
+    return construct_ktx2(device, properties);
+  }
   return Scope<Texture>(new Texture(device, properties));
 }
 
@@ -61,11 +68,50 @@ auto Texture::construct_from_buffer(const Device &device,
   return texture;
 }
 
+auto Texture::construct_compressed(const Device &device,
+                                   const TextureProperties &props,
+                                   CompressedTexture &&compressed)
+    -> Scope<Texture> {
+  return Scope<Texture>(new Texture(device, props, std::move(compressed)));
+}
+
+auto Texture::construct_ktx2(const Device &device,
+                             const TextureProperties &properties)
+    -> Scope<Texture> {
+  const auto file = MappedFile::construct(properties.path);
+  if (!file->is_valid()) {
+    throw NotFoundException(fmt::format("Texture file '{}' does not exist!",
+                                        properties.path.string()));
+  }
+
+  const auto layout = Ktx2Reader::parse(file->data());
+  if (!layout) {
+    throw BaseException(fmt::format("Texture file '{}' is not a usable KTX2",
+                                    properties.path.string()));
+  }
+  if (is_block_compressed(layout->format) &&
+      !device.check_support(Feature::TextureCompressionBC)) {
+    warn("Texture file '{}' is block compressed, which the device does not "
+         "support",
+         properties.path.string());
+    throw BaseException(fmt::format("Texture file '{}' needs BC support",
+                                    properties.path.string()));
+  }
+  return Scope<Texture>(
+      new Texture(device, properties, file->data(), *layout));
+}
+
 Texture::~Texture() {
   debug("Destroyed Texture '{}', size: {}", properties.identifier,
         human_readable_size(cached_size));
 }
 
+static auto allocation_name(const TextureProperties &properties)
+    -> std::string {
+  return properties.path.empty() ? properties.identifier
+                                 : properties.path.string();
+}
+
 static auto calculate_mips(const Extent<u32> &ext) {
   auto max_dimension = std::max(ext.width, ext.height);
   return static_cast<u32>(std::ceil(std::log2(max_dimension))) + 1;
@@ -92,6 +138,7 @@ Texture::Texture(const Device &dev, usize size, const Extent<u32> &extent)
           .max_filter = SamplerFilter::Linear,
           .address_mode = SamplerAddressMode::Repeat,
           .border_color = SamplerBorderColor::FloatOpaqueBlack,
+          .debug_name = allocation_name(properties),
       },
       data_buffer);
   debug("Created texture '{}', {} with size: {}", properties.identifier,
@@ -109,6 +156,8 @@ Texture::Texture(const Device &dev, const TextureProperties &props,
   } else {
     identifier = properties.path.filename().string();
   }
+  properties.identifier = identifier;
+  cached_size = data_buffer.size();
 
   u32 mip_count = 1;
   if (properties.mip_generation.strategy == MipGenerationStrategy::Unused) {
@@ -138,6 +187,7 @@ Texture::Texture(const Device &dev, const TextureProperties &props,
                                 .max_filter = properties.max_filter,
                                 .address_mode = properties.address_mode,
                                 .border_color = properties.border_color,
+                                .debug_name = allocation_name(properties),
                             },
                             data_buffer);
 
@@ -145,6 +195,86 @@ Texture::Texture(const Device &dev, const TextureProperties &props,
         properties.extent, human_readable_size(cached_size));
 }
 
+Texture::Texture(const Device &dev, const TextureProperties &props,
+                 CompressedTexture &&compressed)
+    : device(&dev), properties(props),
+      data_buffer(std::move(compressed.data)) {
+  ensure(data_buffer.valid(), "Compressed texture must have size > 0");
+  ensure(is_block_compressed(compressed.format),
+         "Compressed texture must have a block compressed format");
+
+  properties.format = compressed.format;
+  properties.extent = compressed.extent;
+  if (properties.path.empty()) {
+    properties.identifier =
+        fmt::format("Compressed-Size{}", data_buffer.size());
+  } else {
+    properties.identifier = properties.path.filename().string();
+  }
+  cached_size = data_buffer.size();
+
+  const auto mip_count = static_cast<u32>(compressed.level_offsets.size());
+  image = make_scope<Image>(*device,
+                            ImageProperties{
+                                .extent = properties.extent,
+                                .mip_info =
+                                    {
+                                        .mips = mip_count,
+                                        .use_mips = true,
+                                    },
+                                .format = properties.format,
+                                .tiling = properties.tiling,
+                                .usage = properties.usage,
+                                .layout = properties.layout,
+                                .min_filter = properties.min_filter,
+                                .max_filter = properties.max_filter,
+                                .address_mode = properties.address_mode,
+                                .border_color = properties.border_color,
+                                .debug_name = allocation_name(properties),
+                            },
+                            data_buffer.span(), compressed.level_offsets);
+
+  debug("Created compressed texture '{}', {} with {} mips and size: {}",
+        properties.identifier, properties.extent, mip_count,
+        human_readable_size(cached_size));
+}
+
+Texture::Texture(const Device &dev, const TextureProperties &props,
+                 std::span<const u8> file, const Ktx2Layout &layout)
+    : device(&dev), properties(props) {
+  const auto payload = file.subspan(layout.payload_offset, layout.payload_size);
+
+  properties.format = layout.format;
+  properties.extent = layout.extent;
+  properties.identifier = properties.path.filename().string();
+  cached_size = payload.size();
+
+  const auto mip_count = static_cast<u32>(layout.level_offsets.size());
+  image = make_scope<Image>(*device,
+                            ImageProperties{
+                                .extent = properties.extent,
+                                .mip_info =
+                                    {
+                                        .mips = mip_count,
+                                        .use_mips = true,
+                                    },
+                                .format = properties.format,
+                                .tiling = properties.tiling,
+                                .usage = properties.usage,
+                                .layout = properties.layout,
+                                .min_filter = properties.min_filter,
+                                .max_filter = properties.max_filter,
+                                .address_mode = properties.address_mode,
+                                .border_color = properties.border_color,
+                                .debug_name = allocation_name(properties),
+                            },
+                            payload, layout.level_offsets);
+
+  debug("Created KTX2 texture '{}', {} with {} mips and size: {}",
+        properties.identifier, properties.extent, mip_count,
+        human_readable_size(cached_size));
+}
+
 Texture::Texture(const Device &dev, const TextureProperties &props)
     : device(&dev), properties(props),
       data_buffer(
@@ -184,6 +314,7 @@ Texture::Texture(const Device &dev, const TextureProperties &props)
                                 .max_filter = properties.max_filter,
                                 .address_mode = properties.address_mode,
                                 .border_color = properties.border_color,
+                                .debug_name = allocation_name(properties),
                             },
                             data_buffer);
   cached_size = data_buffer.size();
@@ -201,6 +332,16 @@ auto Texture::hash() const -> usize {
   return name_hash ^ data_buffer.hash();
 }
 
+auto Texture::replace_image(Scope<Image> replacement, ImageFormat format,
+                            const Extent<u32> &full_extent,
+                            usize resident_size) -> Scope<Image> {
+  properties.format = format;
+  properties.extent = full_extent;
+  cached_size = resident_size;
+  std::swap(image, replacement);
+  return replacement;
+}
+
 auto Texture::valid() const noexcept -> bool {
   return data_buffer.valid() && image != nullptr;
 }
@@ -212,6 +353,11 @@ auto Texture::get_image_info() const noexcept -> const VkDescriptorImageInfo & {
 auto Texture::get_image() const noexcept -> const Image & { return *image; }
 
 auto Texture::write_to_file(const FS::Path &path) const -> bool {
+  // Block compressed and KTX2 textures keep no decoded pixels
+  if (is_block_compressed(properties.format) || !data_buffer.valid()) {
+    return false;
+  }
+
   // ensure that parent path exists
   if (const auto parent_path = FS::resolve(path).parent_path();
       !FS::exists(parent_path)) {
@@ -230,4 +376,31 @@ auto Texture::write_to_file(const FS::Path &path) const -> bool {
   return true;
 }
 
+auto TextureCacheConstructor::decode(const TextureProperties &properties)
+    -> Decoded {
+  if (Ktx2Reader::is_ktx2(properties.path)) {
+    return {};
+  }
+
+  Decoded decoded{};
+  decoded.pixels = load_databuffer_from_file(properties.path, decoded.extent);
+  return decoded;
+}
+
+auto TextureCacheConstructor::construct(const Device &device,
+                                        const TextureProperties &properties,
+                                        Decoded &&decoded) -> Scope<Texture> {
+  if (Ktx2Reader::is_ktx2(properties.path)) {
+    return Texture::construct(device, properties);
+  }
+  if (!decoded.pixels.valid()) {
+    return nullptr;
+  }
+
+  auto decoded_properties = properties;
+  decoded_properties.extent = decoded.extent;
+  return Texture::construct_from_buffer(device, decoded_properties,
+                                        std::move(decoded.pixels));
+}
+
 } // namespace Core
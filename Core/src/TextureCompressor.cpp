@@ -0,0 +1,684 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "TextureCompressor.hpp"
+
+#include "ContentHash.hpp"
+#include "Logger.hpp"
+#include "MappedFile.hpp"
+#include "Verify.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <stb_image.h>
+#include <thread>
+
+namespace Core {
+
+namespace {
+
+constexpr std::array<char, 4> magic{'V', 'K', 'T', 'C'};
+
+struct Header {
+  std::array<char, 4> magic{};
+  u32 version{0};
+  u64 key{0};
+  u32 format{0};
+  u32 width{0};
+  u32 height{0};
+  u32 level_count{0};
+  u64 payload_size{0};
+  u64 payload_hash{0};
+};
+
+template <usize Channels> using Colour = std::array<float, Channels>;
+template <usize Channels> using Texels = std::array<Colour<Channels>, 16>;
+
+template <usize Channels>
+auto to_texels(std::span<const u8, 64> rgba) -> Texels<Channels> {
+  Texels<Channels> texels{};
+  for (usize i = 0; i < texels.size(); ++i) {
+    for (usize channel = 0; channel < Channels; ++channel) {
+      texels[i][channel] = static_cast<float>(rgba[i * 4 + channel]);
+    }
+  }
+  return texels;
+}
+
+template <usize Channels>
+auto distance_squared(const Colour<Channels> &lhs, const Colour<Channels> &rhs)
+    -> float {
+  float distance = 0.0F;
+  for (usize channel = 0; channel < Channels; ++channel) {
+    const auto delta = lhs[channel] - rhs[channel];
+    distance += delta * delta;
+  }
+  return distance;
+}
+
+template <usize Channels, usize Count>
+auto nearest(const std::array<Colour<Channels>, Count> &palette,
+             const Colour<Channels> &colour) -> u32 {
+  u32 best = 0;
+  auto best_distance = std::numeric_limits<float>::max();
+  for (u32 i = 0; i < Count; ++i) {
+    if (const auto distance = distance_squared(palette[i], colour);
+        distance < best_distance) {
+      best = i;
+      best_distance = distance;
+    }
+  }
+  return best;
+}
+
+/**
+ * Fits a line through the texels along their principal axis, found by power
+ * iteration on the covariance matrix, and returns the extreme projections
+ * onto it as the low and high endpoints.
+ */
+template <usize Channels>
+auto fit_endpoints(const Texels<Channels> &texels)
+    -> std::pair<Colour<Channels>, Colour<Channels>> {
+  Colour<Channels> mean{};
+  for (const auto &texel : texels) {
+    for (usize channel = 0; channel < Channels; ++channel) {
+      mean[channel] += texel[channel] / static_cast<float>(texels.size());
+    }
+  }
+
+  std::array<Colour<Channels>, Channels> covariance{};
+  for (const auto &texel : texels) {
+    for (usize row = 0; row < Channels; ++row) {
+      for (usize column = 0; column < Channels; ++column) {
+        covariance[row][column] +=
+            (texel[row] - mean[row]) * (texel[column] - mean[column]);
+      }
+    }
+  }
+
+  // The row of the widest channel is never orthogonal to the principal axis,
+  // unlike the bounding box diagonal
+  usize widest = 0;
+  for (usize channel = 1; channel < Channels; ++channel) {
+    if (covariance[channel][channel] > covariance[widest][widest]) {
+      widest = channel;
+    }
+  }
+  if (covariance[widest][widest] <= 0.0F) {
+    return {mean, mean};
+  }
+
+  auto axis = covariance[widest];
+  for (u32 iteration = 0; iteration < 8; ++iteration) {
+    Colour<Channels> next{};
+    float largest = 0.0F;
+    for (usize row = 0; row < Channels; ++row) {
+      for (usize column = 0; column < Channels; ++column) {
+        next[row] += covariance[row][column] * axis[column];
+      }
+      largest = std::max(largest, std::abs(next[row]));
+    }
+    if (largest <= 0.0F) {
+      break;
+    }
+    for (usize channel = 0; channel < Channels; ++channel) {
+      axis[channel] = next[channel] / largest;
+    }
+  }
+
+  const auto length = std::sqrt(distance_squared(axis, Colour<Channels>{}));
+  for (auto &component : axis) {
+    component /= length;
+  }
+
+  auto low = std::numeric_limits<float>::max();
+  auto high = std::numeric_limits<float>::lowest();
+  for (const auto &texel : texels) {
+    float projection = 0.0F;
+    for (usize channel = 0; channel < Channels; ++channel) {
+      projection += (texel[channel] - mean[channel]) * axis[channel];
+    }
+    low = std::min(low, projection);
+    high = std::max(high, projection);
+  }
+
+  Colour<Channels> low_endpoint{};
+  Colour<Channels> high_endpoint{};
+  for (usize channel = 0; channel < Channels; ++channel) {
+    low_endpoint[channel] =
+        std::clamp(mean[channel] + axis[channel] * low, 0.0F, 255.0F);
+    high_endpoint[channel] =
+        std::clamp(mean[channel] + axis[channel] * high, 0.0F, 255.0F);
+  }
+  return {low_endpoint, high_endpoint};
+}
+
+auto store_le(u8 *output, u64 value, usize bytes) -> void {
+  for (usize i = 0; i < bytes; ++i) {
+    output[i] = static_cast<u8>(value >> (8 * i));
+  }
+}
+
+auto pack_565(const Colour<3> &colour) -> u16 {
+  const auto quantise = [](float value, float max) {
+    return static_cast<u16>(std::lround(value * max / 255.0F));
+  };
+  return static_cast<u16>((quantise(colour[0], 31.0F) << 11) |
+                          (quantise(colour[1], 63.0F) << 5) |
+                          quantise(colour[2], 31.0F));
+}
+
+auto unpack_565(u16 packed) -> Colour<3> {
+  const auto red = (packed >> 11) & 0x1F;
+  const auto green = (packed >> 5) & 0x3F;
+  const auto blue = packed & 0x1F;
+  return {
+      static_cast<float>((red << 3) | (red >> 2)),
+      static_cast<float>((green << 2) | (green >> 4)),
+      static_cast<float>((blue << 3) | (blue >> 2)),
+  };
+}
+
+auto encode_bc1(std::span<const u8, 64> rgba, u8 *block) -> void {
+  const auto texels = to_texels<3>(rgba);
+  const auto [low, high] = fit_endpoints(texels);
+
+  auto colour_0 = pack_565(high);
+  auto colour_1 = pack_565(low);
+  // colour_0 > colour_1 selects the opaque four colour mode
+  if (colour_0 < colour_1) {
+    std::swap(colour_0, colour_1);
+  }
+
+  u32 indices = 0;
+  if (colour_0 != colour_1) {
+    std::array<Colour<3>, 4> palette{unpack_565(colour_0),
+                                     unpack_565(colour_1)};
+    for (usize channel = 0; channel < 3; ++channel) {
+      palette[2][channel] =
+          (2.0F * palette[0][channel] + palette[1][channel]) / 3.0F;
+      palette[3][channel] =
+          (palette[0][channel] + 2.0F * palette[1][channel]) / 3.0F;
+    }
+    for (u32 i = 0; i < texels.size(); ++i) {
+      indices |= nearest(palette, texels[i]) << (2 * i);
+    }
+  }
+
+  store_le(block, colour_0, 2);
+  store_le(block + 2, colour_1, 2);
+  store_le(block + 4, indices, 4);
+}
+
+auto encode_bc4(std::span<const u8, 64> rgba, usize channel, u8 *block)
+    -> void {
+  std::array<Colour<1>, 16> values{};
+  u8 low = 255;
+  u8 high = 0;
+  for (usize i = 0; i < values.size(); ++i) {
+    const auto value = rgba[i * 4 + channel];
+    values[i][0] = static_cast<float>(value);
+    low = std::min(low, value);
+    high = std::max(high, value);
+  }
+
+  // high > low selects the mode with six interpolated values
+  u64 indices = 0;
+  if (high != low) {
+    std::array<Colour<1>, 8> palette{};
+    palette[0][0] = high;
+    palette[1][0] = low;
+    for (u32 i = 1; i < 7; ++i) {
+      palette[i + 1][0] =
+          (static_cast<float>(7 - i) * high + static_cast<float>(i) * low) /
+          7.0F;
+    }
+    for (u32 i = 0; i < values.size(); ++i) {
+      indices |= static_cast<u64>(nearest(palette, values[i])) << (3 * i);
+    }
+  }
+
+  block[0] = high;
+  block[1] = low;
+  store_le(block + 2, indices, 6);
+}
+
+class BitWriter {
+public:
+  auto write(u32 value, u32 count) -> void {
+    for (u32 bit = 0; bit < count; ++bit, ++position) {
+      if (((value >> bit) & 1U) != 0) {
+        words[position / 64] |= 1ULL << (position % 64);
+      }
+    }
+  }
+
+  auto store(u8 *output) const -> void {
+    store_le(output, words[0], 8);
+    store_le(output + 8, words[1], 8);
+  }
+
+private:
+  std::array<u64, 2> words{};
+  u32 position{0};
+};
+
+constexpr std::array<u32, 16> bc7_weights{0,  4,  9,  13, 17, 21, 26, 30,
+                                          34, 38, 43, 47, 51, 55, 60, 64};
+
+// Mode 6 endpoints are 7 bits per channel plus one shared low bit
+auto quantise_bc7(const Colour<4> &endpoint)
+    -> std::pair<std::array<u32, 4>, u32> {
+  std::array<u32, 4> best{};
+  u32 best_p_bit = 0;
+  auto best_error = std::numeric_limits<float>::max();
+  for (u32 p_bit = 0; p_bit < 2; ++p_bit) {
+    std::array<u32, 4> quantised{};
+    float error = 0.0F;
+    for (usize channel = 0; channel < 4; ++channel) {
+      quantised[channel] = static_cast<u32>(std::clamp(
+          std::lround((endpoint[channel] - static_cast<float>(p_bit)) / 2.0F),
+          0L, 127L));
+      const auto delta =
+          static_cast<float>((quantised[channel] << 1) | p_bit) -
+          endpoint[channel];
+      error += delta * delta;
+    }
+    if (error < best_error) {
+      best = quantised;
+      best_p_bit = p_bit;
+      best_error = error;
+    }
+  }
+  return {best, best_p_bit};
+}
+
+auto encode_bc7(std::span<const u8, 64> rgba, u8 *block) -> void {
+  const auto texels = to_texels<4>(rgba);
+  const auto [low, high] = fit_endpoints(texels);
+  auto [endpoint_0, p_bit_0] = quantise_bc7(low);
+  auto [endpoint_1, p_bit_1] = quantise_bc7(high);
+
+  std::array<Colour<4>, 16> palette{};
+  for (usize i = 0; i < palette.size(); ++i) {
+    for (usize channel = 0; channel < 4; ++channel) {
+      const auto value_0 = (endpoint_0[channel] << 1) | p_bit_0;
+      const auto value_1 = (endpoint_1[channel] << 1) | p_bit_1;
+      palette[i][channel] = static_cast<float>(
+          ((64 - bc7_weights[i]) * value_0 + bc7_weights[i] * value_1 + 32) >>
+          6);
+    }
+  }
+
+  std::array<u32, 16> indices{};
+  for (usize i = 0; i < texels.size(); ++i) {
+    indices[i] = nearest(palette, texels[i]);
+  }
+
+  // The first index is stored without its high bit, which must be zero.
+  // The weights are symmetric, so swapping the endpoints mirrors them.
+  if (indices[0] >= 8) {
+    std::swap(endpoint_0, endpoint_1);
+    std::swap(p_bit_0, p_bit_1);
+    for (auto &index : indices) {
+      index = 15 - index;
+    }
+  }
+
+  BitWriter writer;
+  writer.write(1U << 6, 7);
+  for (usize channel = 0; channel < 4; ++channel) {
+    writer.write(endpoint_0[channel], 7);
+    writer.write(endpoint_1[channel], 7);
+  }
+  writer.write(p_bit_0, 1);
+  writer.write(p_bit_1, 1);
+  writer.write(indices[0], 3);
+  for (usize i = 1; i < indices.size(); ++i) {
+    writer.write(indices[i], 4);
+  }
+  writer.store(block);
+}
+
+auto srgb_to_linear(u8 value) -> float {
+  static const auto table = [] {
+    std::array<float, 256> values{};
+    for (usize i = 0; i < values.size(); ++i) {
+      const auto srgb = static_cast<float>(i) / 255.0F;
+      values[i] = srgb <= 0.04045F
+                      ? srgb / 12.92F
+                      : std::pow((srgb + 0.055F) / 1.055F, 2.4F);
+    }
+    return values;
+  }();
+  return table[value];
+}
+
+auto linear_to_srgb(float linear) -> u8 {
+  const auto srgb = linear <= 0.0031308F
+                        ? linear * 12.92F
+                        : 1.055F * std::pow(linear, 1.0F / 2.4F) - 0.055F;
+  return static_cast<u8>(std::lround(std::clamp(srgb, 0.0F, 1.0F) * 255.0F));
+}
+
+auto next_extent(const Extent<u32> &extent) -> Extent<u32> {
+  return {std::max(extent.width / 2, 1U), std::max(extent.height / 2, 1U)};
+}
+
+// 2x2 box filter, averaging colour in linear space for sRGB formats
+auto downsample(std::span<const u8> source, const Extent<u32> &extent,
+                bool srgb) -> std::vector<u8> {
+  const auto target = next_extent(extent);
+  std::vector<u8> output(static_cast<usize>(target.width) * target.height * 4);
+
+  for (u32 y = 0; y < target.height; ++y) {
+    const std::array rows{std::min(y * 2, extent.height - 1),
+                          std::min(y * 2 + 1, extent.height - 1)};
+    for (u32 x = 0; x < target.width; ++x) {
+      const std::array columns{std::min(x * 2, extent.width - 1),
+                               std::min(x * 2 + 1, extent.width - 1)};
+      auto *texel = &output[(static_cast<usize>(y) * target.width + x) * 4];
+
+      for (usize channel = 0; channel < 4; ++channel) {
+        const auto linear = srgb && channel < 3;
+        float sum = 0.0F;
+        for (const auto row : rows) {
+          for (const auto column : columns) {
+            const auto value =
+                source[(static_cast<usize>(row) * extent.width + column) * 4 +
+                       channel];
+            sum += linear ? srgb_to_linear(value) : static_cast<float>(value);
+          }
+        }
+        texel[channel] = linear ? linear_to_srgb(sum / 4.0F)
+                                : static_cast<u8>(std::lround(sum / 4.0F));
+      }
+    }
+  }
+  return output;
+}
+
+auto encode_level(std::span<const u8> rgba, const Extent<u32> &extent,
+                  ImageFormat format, u8 *output) -> void {
+  const auto bytes_per_block = block_size(format);
+  const auto blocks_x = (extent.width + 3) / 4;
+  const auto blocks_y = (extent.height + 3) / 4;
+
+  std::array<u8, 64> texels{};
+  for (u32 block_y = 0; block_y < blocks_y; ++block_y) {
+    for (u32 block_x = 0; block_x < blocks_x; ++block_x) {
+      // Blocks overhanging the edge repeat the last row and column
+      for (u32 y = 0; y < 4; ++y) {
+        const auto row = std::min(block_y * 4 + y, extent.height - 1);
+        for (u32 x = 0; x < 4; ++x) {
+          const auto column = std::min(block_x * 4 + x, extent.width - 1);
+          std::memcpy(
+              &texels[(y * 4 + x) * 4],
+              &rgba[(static_cast<usize>(row) * extent.width + column) * 4], 4);
+        }
+      }
+
+      auto *block =
+          output + (static_cast<usize>(block_y) * blocks_x + block_x) *
+                       bytes_per_block;
+      TextureCompressor::encode_block(format, texels,
+                                      {block, bytes_per_block});
+    }
+  }
+}
+
+auto level_offsets_for(ImageFormat format, const Extent<u32> &extent,
+                       u32 level_count) -> std::pair<std::vector<u64>, u64> {
+  std::vector<u64> offsets;
+  u64 total = 0;
+  for (u32 level = 0; level < level_count; ++level) {
+    offsets.push_back(total);
+    total += TextureCompressor::level_size(format, extent, level);
+  }
+  return {offsets, total};
+}
+
+auto path_for(u64 key) -> FS::Path {
+  return FS::texture_cache(fmt::format("{:016x}.vktex", key));
+}
+
+} // namespace
+
+auto TextureCompressor::full_level_count(const Extent<u32> &extent) -> u32 {
+  return static_cast<u32>(
+      std::bit_width(std::max(extent.width, extent.height)));
+}
+
+auto TextureCompressor::level_size(ImageFormat format,
+                                   const Extent<u32> &extent, u32 level)
+    -> u64 {
+  const auto width = std::max(extent.width >> level, 1U);
+  const auto height = std::max(extent.height >> level, 1U);
+  if (!is_block_compressed(format)) {
+    return static_cast<u64>(width) * height * 4;
+  }
+  return static_cast<u64>((width + 3) / 4) * ((height + 3) / 4) *
+         block_size(format);
+}
+
+auto TextureCompressor::encode_block(ImageFormat format,
+                                     std::span<const u8, 64> texels,
+                                     std::span<u8> block) -> void {
+  ensure(block.size() >= block_size(format),
+         "Block of {} bytes is too small for the format", block.size());
+
+  switch (format) {
+    using enum ImageFormat;
+  case BC1_UNORM:
+  case BC1_SRGB:
+  case BC1_RGBA_UNORM:
+  case BC1_RGBA_SRGB:
+    encode_bc1(texels, block.data());
+    break;
+  case BC3_UNORM:
+  case BC3_SRGB:
+    encode_bc4(texels, 3, block.data());
+    encode_bc1(texels, block.data() + 8);
+    break;
+  case BC5_UNORM:
+    encode_bc4(texels, 0, block.data());
+    encode_bc4(texels, 1, block.data() + 8);
+    break;
+  case BC7_UNORM:
+  case BC7_SRGB:
+    encode_bc7(texels, block.data());
+    break;
+  default:
+    ensure(false, "Format {} is not block compressed",
+           static_cast<u32>(format));
+  }
+}
+
+auto TextureCompressor::compress(std::span<const u8> rgba,
+                                 const Extent<u32> &extent,
+                                 ImageFormat format, u32 level_count)
+    -> CompressedTexture {
+  const auto plain = format == ImageFormat::UNORM_RGBA8 ||
+                     format == ImageFormat::SRGB_RGBA8;
+  ensure(plain || is_block_compressed(format),
+         "Format {} is neither 8-bit RGBA nor block compressed",
+         static_cast<u32>(format));
+  ensure(rgba.size() >= static_cast<usize>(extent.width) * extent.height * 4,
+         "Expected {} RGBA8 texels", extent.width * extent.height);
+  level_count = std::clamp(level_count, 1U, full_level_count(extent));
+
+  auto [offsets, total] = level_offsets_for(format, extent, level_count);
+  std::vector<u8> blocks(total);
+
+  std::vector<u8> level_texels{rgba.begin(), rgba.end()};
+  auto level_extent = extent;
+  for (u32 level = 0; level < level_count; ++level) {
+    if (level > 0) {
+      level_texels =
+          downsample(level_texels, level_extent, is_srgb(format));
+      level_extent = next_extent(level_extent);
+    }
+    if (plain) {
+      std::memcpy(blocks.data() + offsets[level], level_texels.data(),
+                  TextureCompressor::level_size(format, extent, level));
+    } else {
+      encode_level(level_texels, level_extent, format,
+                   blocks.data() + offsets[level]);
+    }
+  }
+
+  CompressedTexture result{
+      .format = format,
+      .extent = extent,
+      .data = DataBuffer{blocks.size()},
+      .level_offsets = std::move(offsets),
+  };
+  result.data.write(blocks.data(), blocks.size());
+  return result;
+}
+
+auto TextureCompressor::load_or_compress(const FS::Path &source,
+                                         ImageFormat format,
+                                         bool generate_mips)
+    -> std::optional<CompressedTexture> {
+  const auto source_file = MappedFile::construct(source);
+  if (!source_file->is_valid()) {
+    return std::nullopt;
+  }
+
+  const auto bytes = source_file->data();
+  const auto seed = (static_cast<u64>(version) << 32) |
+                    (static_cast<u64>(format) << 8) |
+                    static_cast<u64>(generate_mips);
+  const auto key = content_hash(bytes, seed);
+  if (auto cached = load(key, format)) {
+    return cached;
+  }
+
+  i32 width{};
+  i32 height{};
+  i32 channels{};
+  auto *pixels = stbi_load_from_memory(bytes.data(),
+                                       static_cast<i32>(bytes.size()), &width,
+                                       &height, &channels, STBI_rgb_alpha);
+  if (pixels == nullptr) {
+    warn("Failed to decode '{}' for compression: {}", source.filename(),
+         stbi_failure_reason());
+    return std::nullopt;
+  }
+
+  const Extent<u32> extent{static_cast<u32>(width),
+                           static_cast<u32>(height)};
+  auto compressed = compress(
+      {pixels, static_cast<usize>(width) * static_cast<usize>(height) * 4},
+      extent, format, generate_mips ? full_level_count(extent) : 1);
+  stbi_image_free(pixels);
+
+  info("Compressed '{}' {} to {}", source.filename(), extent,
+       human_readable_size(compressed.data.size()));
+  store(key, compressed);
+  return compressed;
+}
+
+auto TextureCompressor::load(u64 key, ImageFormat format)
+    -> std::optional<CompressedTexture> {
+  const auto cache_path = path_for(key);
+  if (!FS::exists(cache_path)) {
+    return std::nullopt;
+  }
+
+  const auto file = MappedFile::construct(cache_path);
+  if (!file->is_valid() || file->data().size() < sizeof(Header)) {
+    return std::nullopt;
+  }
+
+  const auto bytes = file->data();
+  Header header{};
+  std::memcpy(&header, bytes.data(), sizeof(Header));
+  const auto payload = bytes.subspan(sizeof(Header));
+
+  const Extent<u32> extent{header.width, header.height};
+  if (header.magic != magic || header.version != version ||
+      header.key != key || header.format != static_cast<u32>(format) ||
+      extent.width == 0 || extent.height == 0 || header.level_count == 0 ||
+      header.level_count > full_level_count(extent)) {
+    info("Texture cache entry {} is stale, rebuilding.",
+         cache_path.filename());
+    return std::nullopt;
+  }
+
+  auto [offsets, total] =
+      level_offsets_for(format, extent, header.level_count);
+  if (header.payload_size != payload.size() || total != payload.size() ||
+      content_hash(payload) != header.payload_hash) {
+    warn("Texture cache entry {} is corrupt, rebuilding.",
+         cache_path.filename());
+    return std::nullopt;
+  }
+
+  CompressedTexture result{
+      .format = format,
+      .extent = extent,
+      .data = DataBuffer{payload.size()},
+      .level_offsets = std::move(offsets),
+  };
+  result.data.write(payload.data(), payload.size());
+  return result;
+}
+
+auto TextureCompressor::store(u64 key, const CompressedTexture &compressed)
+    -> bool {
+  const auto payload = compressed.data.span();
+  const Header header{
+      .magic = magic,
+      .version = version,
+      .key = key,
+      .format = static_cast<u32>(compressed.format),
+      .width = compressed.extent.width,
+      .height = compressed.extent.height,
+      .level_count = static_cast<u32>(compressed.level_offsets.size()),
+      .payload_size = payload.size(),
+      .payload_hash = content_hash(payload),
+  };
+
+  if (FS::mkdir_safe("texture_cache")) {
+    info("Created folder '{}'.", "texture_cache");
+  }
+
+  // Textures are compressed on several threads, so every writer gets its
+  // own temporary file before the rename
+  const auto cache_path = path_for(key);
+  auto temporary_path = cache_path;
+  temporary_path += fmt::format(
+      ".{}.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+  {
+    std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+    if (!file) {
+      warn("Failed to open texture cache file at {}", temporary_path);
+      return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(payload.data()),
+               static_cast<std::streamsize>(payload.size()));
+    if (!file) {
+      warn("Failed to write texture cache file at {}", temporary_path);
+      return false;
+    }
+  }
+
+  std::error_code error_code;
+  std::filesystem::rename(temporary_path, cache_path, error_code);
+  if (error_code) {
+    warn("Failed to move texture cache into place at {}: {}", cache_path,
+         error_code.message());
+    std::filesystem::remove(temporary_path, error_code);
+    return false;
+  }
+  return true;
+}
+
+} // namespace Core
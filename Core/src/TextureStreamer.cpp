@@ -0,0 +1,521 @@
+#include "pch/vkgpgpu_pch.hpp"
+
+#include "TextureStreamer.hpp"
+
+#include "CommandBuffer.hpp"
+#include "Formatters.hpp"
+#include "Image.hpp"
+#include "Logger.hpp"
+#include "StagingUploader.hpp"
+#include "Verify.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <ranges>
+
+namespace Core {
+
+namespace {
+
+auto level_extent(const Extent<u32> &extent, u32 level) -> Extent<u32> {
+  return {
+      std::max(extent.width >> level, 1U),
+      std::max(extent.height >> level, 1U),
+  };
+}
+
+auto is_streamable(const CompressedTexture &source) -> bool {
+  if (source.level_offsets.empty() || source.extent.width == 0 ||
+      source.extent.height == 0 ||
+      source.level_offsets.size() >
+          TextureCompressor::full_level_count(source.extent)) {
+    return false;
+  }
+
+  const auto plain = source.format == ImageFormat::UNORM_RGBA8 ||
+                     source.format == ImageFormat::SRGB_RGBA8;
+  if (!plain && !is_block_compressed(source.format)) {
+    return false;
+  }
+
+  for (u32 level = 0; level < source.level_offsets.size(); ++level) {
+    const auto end =
+        source.level_offsets[level] +
+        TextureCompressor::level_size(source.format, source.extent, level);
+    if (end > source.data.size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+TextureStreamer::TextureStreamer(const Device &dev, u64 budget_bytes)
+    : device(&dev), budget(budget_bytes),
+      copy_command_buffer(CommandBuffer::construct(
+          dev, {
+                   .queue_type = Queue::Type::Graphics,
+                   .count = Config::frame_count,
+               })) {}
+
+TextureStreamer::~TextureStreamer() {
+  // Pending decodes still finish on the main thread, but upload nothing
+  stopping = true;
+  try {
+    JobSystem::run_main_thread_jobs_until(JobSystem::when_all(decodes));
+  } catch (const std::exception &exception) {
+    error("Texture decode failed during shutdown: {}", exception.what());
+  }
+}
+
+auto TextureStreamer::construct(const Device &device, u64 budget_bytes)
+    -> Scope<TextureStreamer> {
+  return Scope<TextureStreamer>{new TextureStreamer(device, budget_bytes)};
+}
+
+auto TextureStreamer::stream(const TextureProperties &properties,
+                             Decoder decode) -> Ref<Texture> {
+  static constexpr std::array<u8, 4> white{255, 255, 255, 255};
+
+  auto placeholder_properties = properties;
+  placeholder_properties.format = ImageFormat::UNORM_RGBA8;
+  placeholder_properties.extent = {1, 1};
+  placeholder_properties.mip_generation = {
+      .strategy = MipGenerationStrategy::Unused,
+  };
+  Ref<Texture> texture = Texture::construct_from_buffer(
+      *device, placeholder_properties, DataBuffer{white.data(), white.size()});
+
+  // A texture that was released before its slot was reused
+  const auto *key = texture.get();
+  if (const auto stale = entries.find(key); stale != entries.end()) {
+    resident_bytes -= stale->second.resident_bytes;
+    entries.erase(stale);
+  }
+
+  const auto inserted =
+      entries.try_emplace(key, Entry{
+                                   .id = next_id++,
+                                   .key = key,
+                                   .texture = texture,
+                                   .properties = properties,
+                                   .decode = std::move(decode),
+                               });
+  request_decode(inserted.first->second);
+  return texture;
+}
+
+auto TextureStreamer::request_decode(Entry &entry) -> void {
+  if (entry.decoding || !entry.decode) {
+    return;
+  }
+  entry.decoding = true;
+
+  auto decoded = make_ref<std::optional<CompressedTexture>>();
+  const auto decode_job = JobSystem::schedule(
+      [decode = entry.decode, decoded,
+       name = entry.properties.path.filename().string()] {
+        try {
+          *decoded = decode();
+        } catch (const std::exception &exception) {
+          warn("Could not decode streamed texture '{}': {}", name,
+               exception.what());
+        }
+      },
+      {}, JobAffinity::Background);
+  auto upload = JobSystem::then(
+      decode_job,
+      [this, key = entry.key, id = entry.id, decoded] {
+        on_decoded(key, id, std::move(*decoded));
+      },
+      JobAffinity::MainThread);
+
+  std::erase_if(decodes,
+                [](const JobHandle &handle) { return handle.is_done(); });
+  decodes.push_back(std::move(upload));
+}
+
+auto TextureStreamer::hint(const Texture &texture, floating priority) -> void {
+  if (const auto found = entries.find(&texture); found != entries.end()) {
+    found->second.priority = std::max(found->second.priority, priority);
+  }
+}
+
+auto TextureStreamer::hint_screen_extent(const Texture &texture,
+                                         const Extent<u32> &extent) -> void {
+  const auto found = entries.find(&texture);
+  if (found == entries.end()) {
+    return;
+  }
+
+  auto &entry = found->second;
+  entry.priority =
+      std::max(entry.priority, static_cast<floating>(extent.width) *
+                                   static_cast<floating>(extent.height));
+  if (entry.level_count == 0) {
+    return;
+  }
+
+  // The smallest level that still covers the screen extent
+  const auto largest = std::max(entry.extent.width, entry.extent.height);
+  const auto screen = std::max({extent.width, extent.height, 1U});
+  u32 level = 0;
+  while (level + 1 < entry.level_count && (largest >> (level + 1)) >= screen) {
+    ++level;
+  }
+  entry.wanted_level = std::min(entry.wanted_level.value_or(level), level);
+}
+
+auto TextureStreamer::update() -> void {
+  ++frame;
+  // Normally long done, the copies of that frame read the retired images
+  copies_submitted[frame % Config::frame_count].wait();
+  retired[frame % Config::frame_count].clear();
+
+  // Textures released by their owners give their budget back
+  std::erase_if(entries, [this](const auto &pair) {
+    if (!pair.second.texture.expired()) {
+      return false;
+    }
+    resident_bytes -= pair.second.resident_bytes;
+    return true;
+  });
+
+  std::vector<Entry *> order;
+  order.reserve(entries.size());
+  for (auto &entry : entries | std::views::values) {
+    if (entry.level_count > 0) {
+      order.push_back(&entry);
+    }
+  }
+  std::ranges::stable_sort(order, std::greater{}, &Entry::priority);
+
+  const auto uploads = device->get_staging_uploader().batch();
+  make_room(order, 0);
+
+  u64 uploaded = 0;
+  for (usize index = 0; index < order.size(); ++index) {
+    auto &entry = *order[index];
+    if (entry.resident_level <= entry.wanted_level.value_or(0) ||
+        entry.dropped_in_frame == frame) {
+      continue;
+    }
+
+    // Only the new level is uploaded, the others are copied on the GPU
+    const auto next = entry.resident_level - 1;
+    const auto growth = levels_size(entry, next) - entry.resident_bytes;
+    if (uploaded > 0 &&
+        uploaded + growth > Config::texture_streaming_frame_upload) {
+      break;
+    }
+
+    // Only textures with a lower priority give up levels for this one
+    const auto lower = std::ranges::find_if(
+        order.begin() + static_cast<std::ptrdiff_t>(index) + 1, order.end(),
+        [&entry](const Entry *other) {
+          return other->priority < entry.priority;
+        });
+    if (!entry.source) {
+      // Freed once it had nothing left to upload, decoded again once the
+      // level could fit
+      if (resident_bytes + growth <= budget || lower != order.end()) {
+        request_decode(entry);
+      }
+      continue;
+    }
+    if (!make_room({lower, order.end()}, growth)) {
+      continue;
+    }
+
+    set_resident_level(entry, next);
+    uploaded += growth;
+  }
+
+  submit_copies();
+
+  // Hints only last for one frame
+  for (auto &entry : entries | std::views::values) {
+    entry.priority = 0.0F;
+    entry.wanted_level.reset();
+  }
+}
+
+auto TextureStreamer::on_decoded(const Texture *key, u64 id,
+                                 std::optional<CompressedTexture> &&source)
+    -> void {
+  const auto found = entries.find(key);
+  if (stopping || found == entries.end() || found->second.id != id) {
+    return;
+  }
+
+  auto &entry = found->second;
+  entry.decoding = false;
+  if (entry.texture.expired() || !source) {
+    return;
+  }
+  if (!is_streamable(*source)) {
+    warn("Streamed texture '{}' has no usable mip chain",
+         entry.properties.path.filename());
+    return;
+  }
+
+  const auto level_count = static_cast<u32>(source->level_offsets.size());
+  if (entry.level_count > 0) {
+    // Decoded again for larger levels, update() uploads them
+    if (source->format != entry.format ||
+        source->extent.width != entry.extent.width ||
+        source->extent.height != entry.extent.height ||
+        level_count != entry.level_count) {
+      warn("Streamed texture '{}' changed between decodes",
+           entry.properties.path.filename());
+      return;
+    }
+    entry.source = std::move(source);
+    return;
+  }
+
+  entry.format = source->format;
+  entry.extent = source->extent;
+  entry.level_count = level_count;
+  entry.source = std::move(source);
+
+  u32 base = 0;
+  while (base + 1 < entry.level_count &&
+         std::max(entry.extent.width >> base, entry.extent.height >> base) >
+             Config::texture_streaming_base_extent) {
+    ++base;
+  }
+  entry.base_level = base;
+  entry.resident_level = entry.level_count;
+  set_resident_level(entry, base);
+}
+
+auto TextureStreamer::set_resident_level(Entry &entry, u32 level) -> void {
+  const auto texture = entry.texture.lock();
+  const auto previous = entry.resident_level;
+  // Levels that are not resident yet come from the decoded chain
+  if (!texture || level == previous || (level < previous && !entry.source)) {
+    return;
+  }
+
+  const auto &properties = entry.properties;
+  auto image = make_scope<Image>(
+      *device, ImageProperties{
+                   .extent = level_extent(entry.extent, level),
+                   .mip_info =
+                       {
+                           .mips = entry.level_count - level,
+                           .use_mips = true,
+                       },
+                   .format = entry.format,
+                   .tiling = properties.tiling,
+                   .usage = properties.usage | ImageUsage::TransferSrc |
+                            ImageUsage::TransferDst,
+                   .layout = properties.layout,
+                   .min_filter = properties.min_filter,
+                   .max_filter = properties.max_filter,
+                   .address_mode = properties.address_mode,
+                   .border_color = properties.border_color,
+                   .debug_name = properties.path.string(),
+               });
+
+  // Only the new levels are staged, with their offsets rebased
+  const auto kept = std::max(level, previous);
+  if (level < previous) {
+    const auto &source = *entry.source;
+    u64 first = std::numeric_limits<u64>::max();
+    u64 last = 0;
+    for (auto index = level; index < kept; ++index) {
+      first = std::min(first, source.level_offsets[index]);
+      last = std::max(last, source.level_offsets[index] +
+                                TextureCompressor::level_size(
+                                    source.format, source.extent, index));
+    }
+
+    std::vector<VkBufferImageCopy> regions;
+    regions.reserve(kept - level);
+    for (auto index = level; index < kept; ++index) {
+      const auto extent = level_extent(source.extent, index);
+      regions.push_back({
+          .bufferOffset = source.level_offsets[index] - first,
+          .imageSubresource =
+              {
+                  .aspectMask = image->get_aspect_mask(),
+                  .mipLevel = index - level,
+                  .layerCount = 1,
+              },
+          .imageExtent = {extent.width, extent.height, 1},
+      });
+    }
+    device->get_staging_uploader().upload(
+        *image, source.data.span().subspan(first, last - first), regions,
+        image->get_descriptor_info().imageLayout);
+  }
+
+  // Levels that stay resident are copied out of the old image
+  if (kept < entry.level_count) {
+    pending_copies.push_back({
+        .source = &texture->get_image(),
+        .destination = image.get(),
+        .source_level = kept - previous,
+        .destination_level = kept - level,
+        .level_count = entry.level_count - kept,
+        .uploaded = level < previous,
+    });
+  }
+
+  const auto size = levels_size(entry, level);
+  retired[frame % Config::frame_count].push_back(texture->replace_image(
+      std::move(image), entry.format, entry.extent, size));
+  resident_bytes = resident_bytes - entry.resident_bytes + size;
+  entry.resident_bytes = size;
+  entry.resident_level = level;
+
+  // Nothing left to upload for now
+  if (level == 0 || level > previous) {
+    entry.source.reset();
+  }
+}
+
+auto TextureStreamer::submit_copies() -> void {
+  if (pending_copies.empty()) {
+    return;
+  }
+
+  // Also orders the copies after the acquire of a dedicated transfer queue
+  const std::array waits{SubmitWait{
+      .future = device->get_staging_uploader().flush(),
+      .stage = VK_PIPELINE_STAGE_TRANSFER_BIT,
+  }};
+
+  const auto slot = static_cast<u32>(frame % Config::frame_count);
+  copy_command_buffer->begin(slot);
+  const auto command_buffer = copy_command_buffer->get_command_buffer();
+
+  const auto barrier = [](const Image &image, u32 first_level,
+                          u32 level_count, VkImageLayout from,
+                          VkImageLayout to, VkAccessFlags source_access,
+                          VkAccessFlags destination_access) {
+    return VkImageMemoryBarrier{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = source_access,
+        .dstAccessMask = destination_access,
+        .oldLayout = from,
+        .newLayout = to,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = image.get_image(),
+        .subresourceRange =
+            {
+                .aspectMask = image.get_aspect_mask(),
+                .baseMipLevel = first_level,
+                .levelCount = level_count,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+            },
+    };
+  };
+
+  for (const auto &copy : pending_copies) {
+    const auto &source = *copy.source;
+    const auto &destination = *copy.destination;
+    const auto source_layout = source.get_descriptor_info().imageLayout;
+    const auto final_layout = destination.get_descriptor_info().imageLayout;
+
+    // Levels that were not staged hold nothing worth keeping
+    const std::array to_transfer{
+        barrier(source, copy.source_level, copy.level_count, source_layout,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, 0,
+                VK_ACCESS_TRANSFER_READ_BIT),
+        barrier(destination, copy.destination_level, copy.level_count,
+                copy.uploaded ? final_layout : VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0,
+                VK_ACCESS_TRANSFER_WRITE_BIT),
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, static_cast<u32>(to_transfer.size()),
+                         to_transfer.data());
+
+    std::vector<VkImageCopy> regions;
+    regions.reserve(copy.level_count);
+    for (u32 index = 0; index < copy.level_count; ++index) {
+      const auto extent =
+          level_extent(destination.get_extent(),
+                       copy.destination_level + index);
+      regions.push_back({
+          .srcSubresource =
+              {
+                  .aspectMask = source.get_aspect_mask(),
+                  .mipLevel = copy.source_level + index,
+                  .layerCount = 1,
+              },
+          .dstSubresource =
+              {
+                  .aspectMask = destination.get_aspect_mask(),
+                  .mipLevel = copy.destination_level + index,
+                  .layerCount = 1,
+              },
+          .extent = {extent.width, extent.height, 1},
+      });
+    }
+    vkCmdCopyImage(command_buffer, source.get_image(),
+                   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                   destination.get_image(),
+                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   static_cast<u32>(regions.size()), regions.data());
+
+    // The old image may be the source of a later copy of this submission
+    const std::array to_final{
+        barrier(source, copy.source_level, copy.level_count,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, source_layout, 0,
+                VK_ACCESS_SHADER_READ_BIT),
+        barrier(destination, copy.destination_level, copy.level_count,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, final_layout,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT),
+    };
+    vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0,
+                         nullptr, static_cast<u32>(to_final.size()),
+                         to_final.data());
+  }
+
+  copies_submitted[slot] = copy_command_buffer->end_and_submit_async(waits);
+  pending_copies.clear();
+}
+
+auto TextureStreamer::make_room(std::span<Entry *const> candidates, u64 bytes)
+    -> bool {
+  for (auto candidate = candidates.rbegin();
+       candidate != candidates.rend() && resident_bytes + bytes > budget;
+       ++candidate) {
+    auto &entry = **candidate;
+    auto level = entry.resident_level;
+    while (level < entry.base_level &&
+           resident_bytes + bytes + levels_size(entry, level) -
+                   entry.resident_bytes >
+               budget) {
+      ++level;
+    }
+    if (level != entry.resident_level) {
+      set_resident_level(entry, level);
+      entry.dropped_in_frame = frame;
+    }
+  }
+  return resident_bytes + bytes <= budget;
+}
+
+auto TextureStreamer::levels_size(const Entry &entry, u32 level) const
+    -> u64 {
+  u64 size = 0;
+  for (auto index = level; index < entry.level_count; ++index) {
+    size += TextureCompressor::level_size(entry.format, entry.extent, index);
+  }
+  return size;
+}
+
+} // namespace Core
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "MappedFile.hpp"
+
+namespace Core::Linux {
+
+class MappedFile : public Core::MappedFile {
+public:
+  MappedFile(const FS::Path &path);
+  ~MappedFile() override;
+
+  auto data() const -> std::span<const u8> override;
+  bool is_valid() const override;
+
+private:
+  void *mapping{nullptr};
+  usize size{0};
+};
+
+} // namespace Core::Linux
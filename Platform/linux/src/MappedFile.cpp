@@ -0,0 +1,44 @@
+#include "linux/include/MappedFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Core::Linux {
+
+MappedFile::MappedFile(const FS::Path &path) {
+  const auto descriptor = open(path.c_str(), O_RDONLY);
+  if (descriptor < 0) {
+    return;
+  }
+
+  struct stat file_status {};
+  if (fstat(descriptor, &file_status) == 0 && file_status.st_size > 0) {
+    size = static_cast<usize>(file_status.st_size);
+    mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (mapping == MAP_FAILED) {
+      mapping = nullptr;
+      size = 0;
+    } else {
+      madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+  }
+
+  // The mapping keeps the file alive
+  close(descriptor);
+}
+
+MappedFile::~MappedFile() {
+  if (mapping) {
+    munmap(mapping, size);
+  }
+}
+
+auto MappedFile::data() const -> std::span<const u8> {
+  return {static_cast<const u8 *>(mapping), size};
+}
+
+bool MappedFile::is_valid() const { return mapping != nullptr; }
+
+} // namespace Core::Linux
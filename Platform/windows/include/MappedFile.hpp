@@ -0,0 +1,23 @@
+#pragma once
+
+#include "MappedFile.hpp"
+#include <Windows.h>
+
+namespace Core::Windows {
+
+class MappedFile : public Core::MappedFile {
+public:
+  MappedFile(const FS::Path &path);
+  ~MappedFile() override;
+
+  auto data() const -> std::span<const u8> override;
+  bool is_valid() const override;
+
+private:
+  HANDLE file_handle{INVALID_HANDLE_VALUE};
+  HANDLE mapping_handle{nullptr};
+  const void *view{nullptr};
+  usize size{0};
+};
+
+} // namespace Core::Windows
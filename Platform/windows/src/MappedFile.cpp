@@ -0,0 +1,50 @@
+#include "windows/include/MappedFile.hpp"
+
+#include <Windows.h>
+
+namespace Core::Windows {
+
+MappedFile::MappedFile(const FS::Path &path) {
+  file_handle =
+      CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (file_handle == INVALID_HANDLE_VALUE) {
+    return;
+  }
+
+  LARGE_INTEGER file_size{};
+  if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+    return;
+  }
+
+  mapping_handle =
+      CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping_handle == nullptr) {
+    return;
+  }
+
+  view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+  if (view != nullptr) {
+    size = static_cast<usize>(file_size.QuadPart);
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (view) {
+    UnmapViewOfFile(view);
+  }
+  if (mapping_handle) {
+    CloseHandle(mapping_handle);
+  }
+  if (file_handle != INVALID_HANDLE_VALUE) {
+    CloseHandle(file_handle);
+  }
+}
+
+auto MappedFile::data() const -> std::span<const u8> {
+  return {static_cast<const u8 *>(view), size};
+}
+
+bool MappedFile::is_valid() const { return view != nullptr; }
+
+} // namespace Core::Windows
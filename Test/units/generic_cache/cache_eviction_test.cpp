@@ -0,0 +1,127 @@
+#include "GenericCache.hpp"
+
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+
+#include "common/device_mock.hpp"
+#include "common/instance_mock.hpp"
+#include "common/window_mock.hpp"
+
+namespace {
+
+struct Blob {
+  Core::usize size{0};
+};
+
+struct BlobProperties {
+  std::string identifier{};
+  Core::usize size{0};
+};
+
+struct BlobConstructor {
+  using Type = Blob;
+  using Properties = BlobProperties;
+
+  static auto construct(const Core::Device &, const BlobProperties &properties)
+      -> Core::Scope<Blob> {
+    return Core::make_scope<Blob>(properties.size);
+  }
+  static auto cost(const Blob &blob) -> Core::usize { return blob.size; }
+};
+
+using BlobCache =
+    Core::GenericCache<Blob, BlobProperties, false, BlobConstructor>;
+
+// Waits for a second construction to start, which only happens while the
+// first one runs if the shard is not locked
+struct RacingConstructor {
+  using Type = Blob;
+  using Properties = BlobProperties;
+
+  static inline std::atomic<int> started{0};
+
+  static auto construct(const Core::Device &, const BlobProperties &properties)
+      -> Core::Scope<Blob> {
+    started.fetch_add(1);
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (started.load() < 2 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::yield();
+    }
+    return Core::make_scope<Blob>(properties.size);
+  }
+  static auto cost(const Blob &blob) -> Core::usize { return blob.size; }
+};
+
+} // namespace
+
+TEST_CASE("GenericCache evicts least recently used entries over capacity",
+          "[GenericCache]") {
+  const MockInstance instance{};
+  const MockWindow window{instance};
+  const MockDevice device{instance, window};
+
+  BlobCache cache(device, nullptr, 100);
+  cache.begin_frame();
+  REQUIRE(cache.put_or_get({"a", 40})->size == 40);
+  REQUIRE(cache.put_or_get({"b", 40})->size == 40);
+
+  cache.begin_frame();
+  cache.put_or_get({"b", 40});
+  cache.put_or_get({"c", 40});
+
+  auto statistics = cache.statistics();
+  REQUIRE(statistics.evictions == 1);
+  REQUIRE(statistics.hits == 1);
+  REQUIRE(statistics.misses == 3);
+  REQUIRE(statistics.resident_bytes == 80);
+
+  // "a" was the least recently used, so it is loaded again
+  cache.put_or_get({"a", 40});
+  REQUIRE(cache.statistics().misses == 4);
+}
+
+TEST_CASE("GenericCache keeps pinned and current entries", "[GenericCache]") {
+  const MockInstance instance{};
+  const MockWindow window{instance};
+  const MockDevice device{instance, window};
+
+  BlobCache cache(device, nullptr, 100);
+  cache.begin_frame();
+  cache.put_or_get({"a", 60});
+  REQUIRE(cache.pin("a"));
+
+  cache.begin_frame();
+  // Over capacity, but "a" is pinned and "b" is used in this frame
+  REQUIRE(cache.put_or_get({"b", 60})->size == 60);
+  REQUIRE(cache.statistics().evictions == 0);
+
+  cache.unpin("a");
+  cache.begin_frame();
+  REQUIRE(cache.statistics().evictions == 1);
+  REQUIRE(cache.statistics().resident_bytes == 60);
+}
+
+TEST_CASE("GenericCache constructs synchronous loads outside the shard lock",
+          "[GenericCache]") {
+  const MockInstance instance{};
+  const MockWindow window{instance};
+  const MockDevice device{instance, window};
+
+  Core::GenericCache<Blob, BlobProperties, false, RacingConstructor> cache(
+      device, nullptr, 100);
+  const Blob *first = nullptr;
+  std::thread other{[&] { first = cache.put_or_get({"a", 40}).get(); }};
+  const auto *second = cache.put_or_get({"a", 40}).get();
+  other.join();
+
+  // Both loads ran at once, and the one inserted first is kept
+  REQUIRE(RacingConstructor::started.load() == 2);
+  REQUIRE(first == second);
+  const auto statistics = cache.statistics();
+  REQUIRE(statistics.entries == 1);
+  REQUIRE(statistics.misses == 1);
+  REQUIRE(statistics.resident_bytes == 40);
+}
@@ -0,0 +1,113 @@
+#include "JobSystem.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using SUT = Core::JobSystem;
+using Core::JobAffinity;
+using Core::JobHandle;
+using Core::usize;
+
+TEST_CASE("Continuations run after the job they depend on", "[job_system]") {
+  std::mutex mutex;
+  std::vector<int> order;
+  const auto append = [&](int value) {
+    std::scoped_lock lock(mutex);
+    order.push_back(value);
+  };
+
+  const auto first = SUT::schedule([&] { append(1); });
+  const auto second = SUT::then(first, [&] { append(2); });
+  SUT::then(second, [&] { append(3); }).wait();
+
+  REQUIRE(order == std::vector<int>{1, 2, 3});
+}
+
+TEST_CASE("Parallel for visits every index once", "[job_system]") {
+  std::vector<std::atomic<int>> visits(1000);
+  SUT::parallel_for(0, visits.size(), 7, [&](usize index) {
+    ++visits[index];
+  }).wait();
+
+  for (const auto &visit : visits) {
+    REQUIRE(visit == 1);
+  }
+}
+
+TEST_CASE("When all rethrows the exception of a failed job", "[job_system]") {
+  const std::array<JobHandle, 2> jobs{
+      SUT::schedule([] {}),
+      SUT::schedule([] { throw std::runtime_error("failed"); }),
+  };
+
+  REQUIRE_THROWS_AS(SUT::when_all(jobs).wait(), std::runtime_error);
+}
+
+TEST_CASE("Main-thread jobs only run when the main thread runs them",
+          "[job_system]") {
+  SUT::initialise();
+
+  std::atomic<bool> on_main_thread{false};
+  const auto job = SUT::schedule(
+      [&] { on_main_thread = SUT::is_main_thread(); }, {},
+      JobAffinity::MainThread);
+  // Waiting on other work leaves main-thread jobs queued
+  SUT::schedule([] {}).wait();
+  REQUIRE_FALSE(job.is_done());
+
+  REQUIRE(SUT::run_main_thread_jobs() == 1);
+  REQUIRE(job.is_done());
+  REQUIRE(on_main_thread);
+}
+
+TEST_CASE("Main-thread continuations run while the main thread waits on them",
+          "[job_system]") {
+  SUT::initialise();
+
+  std::atomic<int> value{0};
+  const auto decode = SUT::schedule([&] { value = 1; });
+  const auto upload =
+      SUT::then(decode, [&] { value = value * 2; }, JobAffinity::MainThread);
+  SUT::run_main_thread_jobs_until(upload);
+
+  REQUIRE(upload.is_done());
+  REQUIRE(value == 2);
+}
+
+TEST_CASE("A waiting main thread leaves background jobs to the workers",
+          "[job_system]") {
+  SUT::initialise();
+
+  std::atomic<bool> released{false};
+  std::atomic<bool> ran_on_main_thread{false};
+  // One more than there are workers, so one stays queued while they block
+  std::vector<JobHandle> background;
+  for (Core::u32 i = 0; i <= SUT::worker_count(); ++i) {
+    background.push_back(SUT::schedule(
+        [&] {
+          ran_on_main_thread = ran_on_main_thread || SUT::is_main_thread();
+          const auto deadline =
+              std::chrono::steady_clock::now() + std::chrono::seconds{5};
+          while (!released && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+          }
+        },
+        {}, JobAffinity::Background));
+  }
+
+  // Runs on the main thread alone while every worker is blocked
+  std::atomic<int> visited{0};
+  SUT::parallel_for(0, 64, 1, [&](usize) { ++visited; }).wait();
+  REQUIRE(visited == 64);
+
+  released = true;
+  SUT::when_all(background).wait();
+  REQUIRE_FALSE(ran_on_main_thread);
+}
@@ -0,0 +1,52 @@
+#include "Logger.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <string_view>
+
+using Core::u32;
+using Core::u8;
+
+namespace {
+
+template <typename... Args>
+auto round_trip(std::string_view format, const Args &...args) -> std::string {
+  std::array<u8, Core::Logger::record_payload_size> payload{};
+  auto *output = payload.data();
+  (Core::Detail::encode(output, args), ...);
+
+  std::string formatted;
+  Core::Detail::format_log_record<const Args &...>(format, payload.data(),
+                                                   formatted);
+  return formatted;
+}
+
+} // namespace
+
+TEST_CASE("Copied arguments format like the originals", "[logger]") {
+  const std::string name{"vertex"};
+  REQUIRE(round_trip("{} {:>4} {:x} {:.1f} {}", name, 42, 255U, 2.25, true) ==
+          "vertex   42 ff 2.2 true");
+}
+
+TEST_CASE("Strings are copied, not referenced", "[logger]") {
+  std::string name{"before"};
+  std::array<u8, Core::Logger::record_payload_size> payload{};
+  auto *output = payload.data();
+  Core::Detail::encode(output, name);
+  name = "after!";
+
+  std::string formatted;
+  Core::Detail::format_log_record<const std::string &>("{}", payload.data(),
+                                                       formatted);
+  REQUIRE(formatted == "before");
+}
+
+TEST_CASE("Only values and strings are deferred", "[logger]") {
+  STATIC_REQUIRE(Core::Detail::DeferredLogArgument<const char (&)[4]>);
+  STATIC_REQUIRE(Core::Detail::DeferredLogArgument<std::string &>);
+  STATIC_REQUIRE(Core::Detail::DeferredLogArgument<u32>);
+  STATIC_REQUIRE_FALSE(Core::Detail::DeferredLogArgument<std::array<u32, 2>>);
+}
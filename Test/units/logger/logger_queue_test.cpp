@@ -0,0 +1,93 @@
+#include "Logger.hpp"
+#include "Types.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <charconv>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using Core::u32;
+
+namespace {
+
+constexpr u32 producer_count = 8;
+// More records than the queue holds, so producers wait for the consumer
+constexpr u32 records_per_producer = 2000;
+constexpr std::string_view marker = "mpsc ";
+
+std::mutex received_mutex;
+std::string received;
+
+auto capture(std::string_view output) -> void {
+  std::scoped_lock lock(received_mutex);
+  received += output;
+}
+
+auto parse(std::string_view text) -> u32 {
+  u32 value{0};
+  std::from_chars(text.data(), text.data() + text.size(), value);
+  return value;
+}
+
+// Returns the next index seen for every producer, or nothing on a repeat or a
+// record out of order
+auto count_records(std::string_view output) -> std::vector<u32> {
+  std::vector<u32> next(producer_count, 0);
+  for (auto start = output.find(marker); start != std::string_view::npos;
+       start = output.find(marker, start)) {
+    start += marker.size();
+    const auto space = output.find(' ', start);
+    const auto producer = parse(output.substr(start, space - start));
+    const auto index = parse(output.substr(space + 1));
+    if (producer >= producer_count || index != next[producer]) {
+      return {};
+    }
+    ++next[producer];
+  }
+  return next;
+}
+
+} // namespace
+
+TEST_CASE("Records from every producer arrive once and in order", "[logger]") {
+  auto &logger = Core::Logger::get_instance();
+  {
+    std::scoped_lock lock(received_mutex);
+    received.clear();
+  }
+  logger.set_sink(&capture);
+
+  std::vector<std::jthread> producers;
+  producers.reserve(producer_count);
+  for (u32 producer = 0; producer < producer_count; ++producer) {
+    producers.emplace_back([&logger, producer] {
+      for (u32 index = 0; index < records_per_producer; ++index) {
+        logger.warn("mpsc {} {}", producer, index);
+      }
+    });
+  }
+  producers.clear();
+
+  // The background thread writes on its flush interval
+  const auto expected = std::vector<u32>(producer_count, records_per_producer);
+  auto counts = std::vector<u32>{};
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds{10};
+  while (std::chrono::steady_clock::now() < deadline) {
+    {
+      std::scoped_lock lock(received_mutex);
+      counts = count_records(received);
+    }
+    if (counts.empty() || counts == expected) {
+      break;
+    }
+    std::this_thread::sleep_for(Core::Logger::flush_interval);
+  }
+  logger.set_sink(nullptr);
+
+  REQUIRE(counts == expected);
+}
@@ -0,0 +1,102 @@
+#include "ArenaStack.hpp"
+#include "Types.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using SUT = Core::ArenaStack;
+
+TEST_CASE("ArenaStack stacks ranges down from the top", "[arena_stack]") {
+  SUT arena{256};
+
+  SECTION("Ranges are aligned below the previous one") {
+    REQUIRE(arena.retain(64, 16) == 192);
+    REQUIRE(arena.retain(10, 16) == 176);
+    REQUIRE(arena.retain(10, 4) == 164);
+    REQUIRE(arena.get_used() == 92);
+  }
+
+  SECTION("Empty and too large ranges fail") {
+    REQUIRE_FALSE(arena.retain(0, 1).has_value());
+    REQUIRE_FALSE(arena.retain(257, 1).has_value());
+    REQUIRE(arena.empty());
+  }
+
+  SECTION("A full arena has no room, so BufferSets fall back to buffers") {
+    REQUIRE(arena.retain(128, 1) == 128);
+    REQUIRE(arena.retain(128, 1) == 0);
+    REQUIRE_FALSE(arena.retain(1, 1).has_value());
+
+    arena.release(0);
+    REQUIRE(arena.retain(64, 1) == 64);
+  }
+}
+
+TEST_CASE("ArenaStack gives space back from the top of the stack down",
+          "[arena_stack]") {
+  SUT arena{256};
+  const auto first = arena.retain(64, 1);
+  const auto second = arena.retain(64, 1);
+  const auto third = arena.retain(64, 1);
+  REQUIRE(first == 192);
+  REQUIRE(second == 128);
+  REQUIRE(third == 64);
+
+  SECTION("Releasing below the top keeps its space until the top goes") {
+    arena.release(*second);
+    REQUIRE(arena.get_used() == 192);
+    REQUIRE(arena.retain(64, 1) == 0);
+
+    arena.release(0);
+    arena.release(*third);
+    REQUIRE(arena.get_used() == 64);
+    REQUIRE(arena.retain(128, 1) == 64);
+  }
+
+  SECTION("Releasing everything in any order empties the arena") {
+    arena.release(*first);
+    arena.release(*third);
+    REQUIRE_FALSE(arena.empty());
+    arena.release(*second);
+    REQUIRE(arena.empty());
+    REQUIRE(arena.get_used() == 0);
+    REQUIRE(arena.retain(256, 1) == 0);
+  }
+
+  SECTION("Offsets that were never retained are ignored") {
+    arena.release(100);
+    REQUIRE(arena.get_used() == 192);
+  }
+}
+
+TEST_CASE("ArenaStack bumps transient ranges up from the bottom",
+          "[arena_stack]") {
+  SUT arena{256};
+
+  SECTION("Transient ranges are aligned above the previous one") {
+    REQUIRE(arena.allocate(10, 16) == 0);
+    REQUIRE(arena.allocate(10, 16) == 16);
+    REQUIRE(arena.allocate(4, 4) == 28);
+    REQUIRE(arena.get_transient_used() == 32);
+    REQUIRE(arena.empty());
+  }
+
+  SECTION("Transient and retained ranges never overlap") {
+    REQUIRE(arena.retain(128, 1) == 128);
+    REQUIRE(arena.allocate(100, 1) == 0);
+    REQUIRE_FALSE(arena.allocate(29, 1).has_value());
+    REQUIRE_FALSE(arena.retain(29, 1).has_value());
+    REQUIRE(arena.retain(28, 1) == 100);
+    REQUIRE_FALSE(arena.allocate(0, 1).has_value());
+  }
+
+  SECTION("Resetting frees the transient ranges but keeps retained ones") {
+    REQUIRE(arena.retain(64, 1) == 192);
+    REQUIRE(arena.allocate(192, 1) == 0);
+    REQUIRE_FALSE(arena.allocate(1, 1).has_value());
+
+    arena.reset_transient();
+    REQUIRE(arena.get_transient_used() == 0);
+    REQUIRE(arena.get_used() == 64);
+    REQUIRE(arena.allocate(192, 1) == 0);
+  }
+}
@@ -0,0 +1,58 @@
+#include "MemoryTelemetry.hpp"
+#include "Types.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+
+using SUT = Core::MemoryTelemetry;
+using Core::MemoryCategory;
+using Core::u64;
+using Core::usize;
+
+namespace {
+
+auto live_bytes(MemoryCategory category) -> u64 {
+  return SUT::snapshot().categories.at(static_cast<usize>(category)).live_bytes;
+}
+
+auto find_resource(const Core::MemorySnapshot &snapshot,
+                   const std::string &name) -> const Core::NamedMemoryUsage * {
+  const auto found = std::ranges::find(snapshot.resources, name,
+                                       &Core::NamedMemoryUsage::resource_name);
+  return found == snapshot.resources.end() ? nullptr : &*found;
+}
+
+} // namespace
+
+TEST_CASE("Frees are counted against the category of their allocation",
+          "[memory]") {
+  const auto before = live_bytes(MemoryCategory::Staging);
+
+  SUT::record_allocation(MemoryCategory::Staging, "Telemetry Test Ring", 256);
+  SUT::record_allocation(MemoryCategory::Staging, "Telemetry Test Ring", 64);
+  REQUIRE(live_bytes(MemoryCategory::Staging) == before + 320);
+
+  const auto snapshot = SUT::snapshot();
+  const auto *resource = find_resource(snapshot, "Telemetry Test Ring");
+  REQUIRE(resource != nullptr);
+  REQUIRE(resource->live_allocations == 2);
+
+  SUT::record_free(MemoryCategory::Staging, "Telemetry Test Ring", 256);
+  SUT::record_free(MemoryCategory::Staging, "Telemetry Test Ring", 64);
+  REQUIRE(live_bytes(MemoryCategory::Staging) == before);
+  REQUIRE(find_resource(SUT::snapshot(), "Telemetry Test Ring") == nullptr);
+}
+
+TEST_CASE("Frame counts roll over and names are escaped in JSON", "[memory]") {
+  SUT::begin_frame();
+  SUT::record_allocation(MemoryCategory::Other, "Telemetry \"Quoted\"", 8);
+  SUT::begin_frame();
+
+  const auto snapshot = SUT::snapshot();
+  REQUIRE(snapshot.allocations_last_frame >= 1);
+  REQUIRE(SUT::to_json(snapshot).find(R"("Telemetry \"Quoted\"")") !=
+          std::string::npos);
+
+  SUT::record_free(MemoryCategory::Other, "Telemetry \"Quoted\"", 8);
+}
@@ -0,0 +1,81 @@
+#include "PipelineCache.hpp"
+#include "Types.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <vector>
+
+using SUT = Core::PipelineCache;
+
+namespace {
+
+auto make_properties() -> VkPhysicalDeviceProperties {
+  VkPhysicalDeviceProperties properties{};
+  properties.vendorID = 0x10DE;
+  properties.deviceID = 0x2684;
+  for (Core::u8 i = 0; i < VK_UUID_SIZE; ++i) {
+    properties.pipelineCacheUUID[i] = i;
+  }
+  return properties;
+}
+
+auto make_blob(const VkPhysicalDeviceProperties &properties)
+    -> std::vector<Core::u8> {
+  VkPipelineCacheHeaderVersionOne header{};
+  header.headerSize = sizeof(header);
+  header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+  header.vendorID = properties.vendorID;
+  header.deviceID = properties.deviceID;
+  std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID,
+              VK_UUID_SIZE);
+
+  // Header followed by some driver data
+  std::vector<Core::u8> blob(sizeof(header) + 64, 0xAB);
+  std::memcpy(blob.data(), &header, sizeof(header));
+  return blob;
+}
+
+} // namespace
+
+TEST_CASE("Pipeline cache accepts blobs from the same device",
+          "[pipeline_cache]") {
+  const auto properties = make_properties();
+  REQUIRE(SUT::is_compatible(make_blob(properties), properties));
+}
+
+TEST_CASE("Pipeline cache rejects blobs from another device or driver",
+          "[pipeline_cache]") {
+  const auto properties = make_properties();
+
+  auto other_vendor = properties;
+  other_vendor.vendorID = 0x1002;
+  REQUIRE_FALSE(SUT::is_compatible(make_blob(other_vendor), properties));
+
+  auto other_device = properties;
+  other_device.deviceID = 0x2204;
+  REQUIRE_FALSE(SUT::is_compatible(make_blob(other_device), properties));
+
+  auto other_driver = properties;
+  other_driver.pipelineCacheUUID[7] ^= 0xFF;
+  REQUIRE_FALSE(SUT::is_compatible(make_blob(other_driver), properties));
+}
+
+TEST_CASE("Pipeline cache rejects truncated or malformed headers",
+          "[pipeline_cache]") {
+  const auto properties = make_properties();
+  const auto blob = make_blob(properties);
+
+  REQUIRE_FALSE(SUT::is_compatible({}, properties));
+  REQUIRE_FALSE(SUT::is_compatible(
+      std::span{blob}.first(sizeof(VkPipelineCacheHeaderVersionOne) - 1),
+      properties));
+
+  auto wrong_version = blob;
+  wrong_version[4] = 2;
+  REQUIRE_FALSE(SUT::is_compatible(wrong_version, properties));
+
+  auto oversized_header = blob;
+  const auto header_size = static_cast<Core::u32>(blob.size() + 1);
+  std::memcpy(oversized_header.data(), &header_size, sizeof(header_size));
+  REQUIRE_FALSE(SUT::is_compatible(oversized_header, properties));
+}
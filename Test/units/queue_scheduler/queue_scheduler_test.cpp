@@ -0,0 +1,78 @@
+#include "Allocator.hpp"
+#include "CommandBuffer.hpp"
+#include "Image.hpp"
+#include "ImageProperties.hpp"
+#include "QueueScheduler.hpp"
+
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+
+#include "common/device_mock.hpp"
+#include "common/instance_mock.hpp"
+#include "common/window_mock.hpp"
+
+TEST_CASE("Queue scheduler hands images from compute to graphics",
+          "[queue_scheduler]") {
+  MockInstance instance{};
+  MockWindow window{instance};
+  MockDevice device{instance, window};
+  Core::Allocator::construct(device, instance);
+
+  Core::Image image(device, Core::ImageProperties{
+                                .extent = {16, 16},
+                                .format = Core::ImageFormat::UNORM_RGBA8,
+                                .usage = Core::ImageUsage::Storage |
+                                         Core::ImageUsage::Sampled,
+                                .layout = Core::ImageLayout::General,
+                            });
+  auto scheduler = Core::QueueScheduler::construct(device);
+  auto producer = Core::CommandBuffer::construct(
+      device, {.queue_type = Core::Queue::Type::Compute});
+  auto consumer = Core::CommandBuffer::construct(
+      device, {.queue_type = Core::Queue::Type::Graphics});
+
+  using enum Core::Queue::Type;
+  producer->begin(0);
+  scheduler->release(*producer, Graphics, {.image = &image});
+  REQUIRE(scheduler->get_pending_handoff_count(Graphics) == 1);
+  REQUIRE(scheduler->get_pending_wait_count(Graphics) == 0);
+
+  SECTION("Submitting the producer makes the consumer wait on it") {
+    const auto produced = scheduler->submit(*producer);
+    REQUIRE(scheduler->get_pending_wait_count(Graphics) == 1);
+    REQUIRE(scheduler->get_pending_wait_count(Compute) == 0);
+
+    consumer->begin(0);
+    scheduler->acquire_pending(*consumer);
+    REQUIRE(scheduler->get_pending_handoff_count(Graphics) == 0);
+
+    const auto consumed = scheduler->submit(*consumer);
+    REQUIRE(scheduler->get_pending_wait_count(Graphics) == 0);
+    REQUIRE(consumed.wait());
+    REQUIRE(produced.is_ready());
+  }
+
+  SECTION("An explicit wait on the producer is merged with the handoff") {
+    const auto produced = scheduler->submit(*producer);
+    consumer->begin(0);
+    scheduler->acquire_pending(*consumer);
+
+    const std::array explicit_waits{Core::SubmitWait{.future = produced}};
+    const auto consumed = scheduler->submit(*consumer, explicit_waits);
+    REQUIRE(scheduler->get_pending_wait_count(Graphics) == 0);
+    REQUIRE(consumed.wait());
+  }
+
+  SECTION("Handoffs are consumed once") {
+    scheduler->submit(*producer).wait();
+    consumer->begin(0);
+    scheduler->acquire_pending(*consumer);
+    scheduler->submit(*consumer).wait();
+
+    consumer->begin(1);
+    scheduler->acquire_pending(*consumer);
+    REQUIRE(scheduler->get_pending_handoff_count(Graphics) == 0);
+    REQUIRE(scheduler->get_pending_wait_count(Graphics) == 0);
+    scheduler->submit(*consumer).wait();
+  }
+}
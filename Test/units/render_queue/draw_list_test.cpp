@@ -0,0 +1,79 @@
+#include "DrawList.hpp"
+#include "Types.hpp"
+
+#include <array>
+#include <bit>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <span>
+
+using SUT = Core::DrawList;
+
+namespace {
+auto fake_mesh(std::uintptr_t address) -> const Core::Mesh * {
+  return std::bit_cast<const Core::Mesh *>(address);
+}
+} // namespace
+
+TEST_CASE("DrawList groups instances per submesh", "[draw_list]") {
+  SUT list;
+  std::array<glm::mat4, 16> output{};
+
+  list.submit(fake_mesh(0x1000), 0, nullptr, glm::mat4{1.0F});
+  list.submit(fake_mesh(0x2000), 0, nullptr, glm::mat4{2.0F});
+  list.submit(fake_mesh(0x1000), 0, nullptr, glm::mat4{3.0F});
+  list.submit(fake_mesh(0x1000), 1, nullptr, glm::mat4{4.0F});
+  REQUIRE(list.size() == 3);
+  REQUIRE(list.instance_size() == 4);
+
+  REQUIRE(list.pack(output, 2) == 6);
+  REQUIRE(list.get_first_instance(0) == 2);
+  REQUIRE(list.get_instance_count(0) == 2);
+  REQUIRE(output[2] == glm::mat4{1.0F});
+  REQUIRE(output[3] == glm::mat4{3.0F});
+  REQUIRE(output[4] == glm::mat4{2.0F});
+  REQUIRE(output[5] == glm::mat4{4.0F});
+
+  SECTION("Clearing keeps lookups working") {
+    list.clear();
+    REQUIRE(list.size() == 0);
+    list.submit(fake_mesh(0x2000), 0, nullptr, glm::mat4{5.0F});
+    list.submit(fake_mesh(0x2000), 0, nullptr, glm::mat4{6.0F});
+    REQUIRE(list.size() == 1);
+    REQUIRE(list.get_instance_count(0) == 2);
+  }
+}
+
+TEST_CASE("DrawList drops draws which do not fit", "[draw_list]") {
+  SUT list;
+  std::array<glm::mat4, 2> output{};
+
+  list.submit(fake_mesh(0x1000), 0, nullptr, glm::mat4{1.0F});
+  list.submit(fake_mesh(0x2000), 0, nullptr, glm::mat4{2.0F});
+  list.submit(fake_mesh(0x2000), 0, nullptr, glm::mat4{3.0F});
+
+  REQUIRE(list.pack(output, 0) == 1);
+  REQUIRE(list.get_instance_count(1) == 0);
+  REQUIRE(list.dropped_instance_size() == 2);
+  REQUIRE(output[0] == glm::mat4{1.0F});
+}
+
+TEST_CASE("DrawList packs a second pass into its own region", "[draw_list]") {
+  SUT geometry;
+  SUT shadow;
+  std::array<glm::mat4, 4> output{};
+  const auto region = std::span{output}.first(2);
+
+  geometry.submit(fake_mesh(0x1000), 0, nullptr, glm::mat4{1.0F});
+  geometry.submit(fake_mesh(0x1000), 0, nullptr, glm::mat4{2.0F});
+  shadow.submit(fake_mesh(0x1000), 0, nullptr, glm::mat4{3.0F});
+  shadow.submit(fake_mesh(0x1000), 0, nullptr, glm::mat4{4.0F});
+
+  // A full first region leaves the second one its whole capacity
+  const auto offset = geometry.pack(region, 0);
+  REQUIRE(offset == 2);
+  REQUIRE(shadow.pack(std::span{output}.first(offset + 2), offset) == 4);
+  REQUIRE(shadow.dropped_instance_size() == 0);
+  REQUIRE(shadow.get_first_instance(0) == 2);
+  REQUIRE(output[3] == glm::mat4{4.0F});
+}
@@ -0,0 +1,69 @@
+#include "RenderQueue.hpp"
+#include "Types.hpp"
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+
+using SUT = Core::RenderQueue;
+
+TEST_CASE("radix_sort orders 64-bit keys", "[render_queue]") {
+  std::mt19937_64 engine{1234};
+  std::vector<Core::u64> keys(1000);
+  std::ranges::generate(keys, engine);
+  std::vector<Core::u64> scratch;
+
+  auto expected = keys;
+  std::ranges::sort(expected);
+
+  Core::radix_sort(keys, scratch, [](Core::u64 key) { return key; });
+  REQUIRE(keys == expected);
+}
+
+TEST_CASE("radix_sort is stable", "[render_queue]") {
+  std::vector<std::pair<Core::u64, int>> items{
+      {2, 0}, {1, 1}, {2, 2}, {1, 3}, {0, 4},
+  };
+  std::vector<std::pair<Core::u64, int>> scratch;
+
+  Core::radix_sort(items, scratch, [](const auto &item) { return item.first; });
+
+  const std::vector<std::pair<Core::u64, int>> expected{
+      {0, 4}, {1, 1}, {1, 3}, {2, 0}, {2, 2},
+  };
+  REQUIRE(items == expected);
+}
+
+TEST_CASE("RenderQueue groups draws by material before mesh",
+          "[render_queue]") {
+  SUT queue;
+  queue.push(SUT::make_key(0, 2, 1, 0), 0);
+  queue.push(SUT::make_key(0, 1, 2, 0), 1);
+  queue.push(SUT::make_key(0, 2, 0, 3), 2);
+  queue.push(SUT::make_key(0, 1, 2, 1), 3);
+  queue.sort();
+
+  std::vector<Core::u32> order;
+  for (const auto &entry : queue.get_entries()) {
+    order.push_back(entry.index);
+  }
+  REQUIRE(order == std::vector<Core::u32>{1, 3, 2, 0});
+
+  SECTION("Clearing keeps nothing but the capacity") {
+    SUT::Statistics recorded{};
+    recorded.count_bind(true);
+    recorded.count_bind(false);
+    queue.add_statistics(recorded);
+    queue.add_statistics(recorded);
+    REQUIRE(queue.get_statistics().elided_binds == 2);
+
+    queue.clear();
+    queue.add_statistics(recorded);
+    REQUIRE(queue.get_statistics().elided_binds == 1);
+    REQUIRE(queue.get_statistics().binds == 1);
+
+    queue.clear();
+    REQUIRE(queue.size() == 0);
+    REQUIRE(queue.get_statistics().elided_binds == 0);
+  }
+}
@@ -0,0 +1,57 @@
+#include "RingAllocator.hpp"
+#include "Types.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+
+using SUT = Core::RingAllocator;
+
+TEST_CASE("RingAllocator hands out regions in order", "[ring_allocator]") {
+  SUT ring{256};
+
+  SECTION("First allocation starts at zero") {
+    REQUIRE(ring.allocate(64, 16, 1) == 0);
+    REQUIRE_FALSE(ring.empty());
+  }
+
+  SECTION("Allocations are aligned") {
+    REQUIRE(ring.allocate(10, 16, 1) == 0);
+    REQUIRE(ring.allocate(10, 16, 1) == 16);
+    REQUIRE(ring.allocate(10, 4, 1) == 28);
+  }
+
+  SECTION("Too large allocations fail") {
+    REQUIRE_FALSE(ring.allocate(257, 1, 1).has_value());
+    REQUIRE_FALSE(ring.allocate(0, 1, 1).has_value());
+  }
+}
+
+TEST_CASE("RingAllocator recycles retired batches", "[ring_allocator]") {
+  SUT ring{256};
+
+  SECTION("A full ring has no room until a batch retires") {
+    REQUIRE(ring.allocate(128, 1, 1) == 0);
+    REQUIRE(ring.allocate(128, 1, 2) == 128);
+    REQUIRE_FALSE(ring.allocate(64, 1, 3).has_value());
+
+    ring.retire(1);
+    REQUIRE(ring.allocate(64, 1, 3) == 0);
+  }
+
+  SECTION("Wrapped allocations do not overrun the oldest region") {
+    REQUIRE(ring.allocate(100, 1, 1) == 0);
+    REQUIRE(ring.allocate(100, 1, 2) == 100);
+    ring.retire(1);
+
+    REQUIRE(ring.allocate(80, 1, 3) == 0);
+    REQUIRE_FALSE(ring.allocate(40, 1, 3).has_value());
+    REQUIRE(ring.allocate(20, 1, 3) == 80);
+  }
+
+  SECTION("Retiring everything empties the ring") {
+    REQUIRE(ring.allocate(100, 1, 1).has_value());
+    REQUIRE(ring.allocate(100, 1, 2).has_value());
+    ring.retire(2);
+    REQUIRE(ring.empty());
+    REQUIRE(ring.allocate(256, 1, 3) == 0);
+  }
+}
@@ -0,0 +1,83 @@
+#include "Ktx2.hpp"
+#include "Types.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <vector>
+
+using SUT = Core::Ktx2Reader;
+using Core::ImageFormat;
+using Core::u32;
+using Core::u64;
+using Core::u8;
+using Core::usize;
+
+namespace {
+
+constexpr u32 vk_format_bc1_rgba_srgb_block = 134;
+constexpr u32 vk_format_bc7_unorm_block = 145;
+
+auto write_u32(std::vector<u8> &file, usize offset, u32 value) -> void {
+  std::memcpy(file.data() + offset, &value, sizeof(value));
+}
+
+auto write_u64(std::vector<u8> &file, usize offset, u64 value) -> void {
+  std::memcpy(file.data() + offset, &value, sizeof(value));
+}
+
+// 4x4 BC7 texture with two levels, stored smallest first after the index
+auto two_level_bc7() -> std::vector<u8> {
+  std::vector<u8> file(128 + 2 * 16, 0);
+  std::memcpy(file.data(), SUT::identifier.data(), SUT::identifier.size());
+  write_u32(file, 12, vk_format_bc7_unorm_block);
+  write_u32(file, 16, 1);
+  write_u32(file, 20, 4);
+  write_u32(file, 24, 4);
+  write_u32(file, 36, 1);
+  write_u32(file, 40, 2);
+
+  write_u64(file, 80, 144);
+  write_u64(file, 88, 16);
+  write_u64(file, 104, 128);
+  write_u64(file, 112, 16);
+  return file;
+}
+
+} // namespace
+
+TEST_CASE("KTX2 level index is rebased onto the payload", "[ktx2]") {
+  const auto layout = SUT::parse(two_level_bc7());
+
+  REQUIRE(layout.has_value());
+  REQUIRE(layout->format == ImageFormat::BC7_UNORM);
+  REQUIRE(layout->extent.width == 4);
+  REQUIRE(layout->extent.height == 4);
+  REQUIRE(layout->payload_offset == 128);
+  REQUIRE(layout->payload_size == 32);
+  REQUIRE(layout->level_offsets == std::vector<u64>{16, 0});
+}
+
+TEST_CASE("KTX2 BC1 with alpha keeps its alpha", "[ktx2]") {
+  auto file = two_level_bc7();
+  write_u32(file, 12, vk_format_bc1_rgba_srgb_block);
+  const auto layout = SUT::parse(file);
+
+  REQUIRE(layout.has_value());
+  REQUIRE(layout->format == ImageFormat::BC1_RGBA_SRGB);
+  REQUIRE(Core::is_srgb(layout->format));
+}
+
+TEST_CASE("KTX2 files that need decoding or are truncated are rejected",
+          "[ktx2]") {
+  auto supercompressed = two_level_bc7();
+  write_u32(supercompressed, 44, 2);
+  REQUIRE_FALSE(SUT::parse(supercompressed).has_value());
+
+  auto truncated = two_level_bc7();
+  truncated.resize(150);
+  REQUIRE_FALSE(SUT::parse(truncated).has_value());
+
+  auto not_ktx2 = two_level_bc7();
+  not_ktx2[1] = 'X';
+  REQUIRE_FALSE(SUT::parse(not_ktx2).has_value());
+}
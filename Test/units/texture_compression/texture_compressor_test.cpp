@@ -0,0 +1,154 @@
+#include "TextureCompressor.hpp"
+#include "Types.hpp"
+
+#include <algorithm>
+#include <array>
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+
+using SUT = Core::TextureCompressor;
+using Core::ImageFormat;
+using Core::u32;
+using Core::u64;
+using Core::u8;
+using Core::usize;
+
+namespace {
+
+auto solid_block(u8 red, u8 green, u8 blue, u8 alpha) -> std::array<u8, 64> {
+  std::array<u8, 64> texels{};
+  for (usize i = 0; i < 16; ++i) {
+    texels[i * 4 + 0] = red;
+    texels[i * 4 + 1] = green;
+    texels[i * 4 + 2] = blue;
+    texels[i * 4 + 3] = alpha;
+  }
+  return texels;
+}
+
+auto read_bits(const std::array<u8, 16> &block, u32 position, u32 count)
+    -> u32 {
+  u32 value = 0;
+  for (u32 bit = 0; bit < count; ++bit, ++position) {
+    value |= ((block[position / 8] >> (position % 8)) & 1U) << bit;
+  }
+  return value;
+}
+
+// Reference decoder for the BC7 mode 6 blocks the compressor emits
+auto decode_bc7_mode_6(const std::array<u8, 16> &block)
+    -> std::array<u8, 64> {
+  static constexpr std::array<u32, 16> weights{
+      0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+  u32 position = 7;
+  std::array<std::array<u32, 4>, 2> endpoints{};
+  for (usize channel = 0; channel < 4; ++channel) {
+    for (auto &endpoint : endpoints) {
+      endpoint[channel] = read_bits(block, position, 7) << 1;
+      position += 7;
+    }
+  }
+  for (auto &endpoint : endpoints) {
+    const auto p_bit = read_bits(block, position++, 1);
+    for (auto &channel : endpoint) {
+      channel |= p_bit;
+    }
+  }
+
+  std::array<u8, 64> texels{};
+  for (usize i = 0; i < 16; ++i) {
+    const auto width = i == 0 ? 3U : 4U;
+    const auto weight = weights[read_bits(block, position, width)];
+    position += width;
+    for (usize channel = 0; channel < 4; ++channel) {
+      texels[i * 4 + channel] = static_cast<u8>(
+          ((64 - weight) * endpoints[0][channel] +
+           weight * endpoints[1][channel] + 32) >>
+          6);
+    }
+  }
+  return texels;
+}
+
+} // namespace
+
+TEST_CASE("Block sizes match the BC formats", "[texture_compression]") {
+  REQUIRE(Core::block_size(ImageFormat::BC1_UNORM) == 8);
+  REQUIRE(Core::block_size(ImageFormat::BC3_SRGB) == 16);
+  REQUIRE(Core::block_size(ImageFormat::BC5_UNORM) == 16);
+  REQUIRE(Core::block_size(ImageFormat::BC7_UNORM) == 16);
+  REQUIRE_FALSE(Core::is_block_compressed(ImageFormat::UNORM_RGBA8));
+  REQUIRE(Core::is_srgb(ImageFormat::BC7_SRGB));
+}
+
+TEST_CASE("BC1 encodes a solid colour exactly", "[texture_compression]") {
+  std::array<u8, 8> block{};
+  SUT::encode_block(ImageFormat::BC1_UNORM, solid_block(255, 0, 0, 255),
+                    block);
+
+  // Pure red is 0xF800 in RGB565, both endpoints equal and every index zero
+  REQUIRE(block == std::array<u8, 8>{0x00, 0xF8, 0x00, 0xF8, 0, 0, 0, 0});
+}
+
+TEST_CASE("BC5 stores solid red and green channels in their endpoints",
+          "[texture_compression]") {
+  std::array<u8, 16> block{};
+  SUT::encode_block(ImageFormat::BC5_UNORM, solid_block(10, 200, 0, 255),
+                    block);
+
+  REQUIRE(block[0] == 10);
+  REQUIRE(block[1] == 10);
+  REQUIRE(block[8] == 200);
+  REQUIRE(block[9] == 200);
+}
+
+TEST_CASE("BC7 mode 6 blocks decode back to two colour blocks",
+          "[texture_compression]") {
+  std::array<u8, 64> texels{};
+  for (usize i = 0; i < 16; ++i) {
+    const auto red = i % 2 == 0;
+    texels[i * 4 + 0] = red ? 255 : 0;
+    texels[i * 4 + 1] = red ? 0 : 255;
+    texels[i * 4 + 2] = 64;
+    texels[i * 4 + 3] = 255;
+  }
+
+  std::array<u8, 16> block{};
+  SUT::encode_block(ImageFormat::BC7_UNORM, texels, block);
+  REQUIRE((block[0] & 0x7F) == 0x40);
+
+  const auto decoded = decode_bc7_mode_6(block);
+  for (usize i = 0; i < decoded.size(); ++i) {
+    const auto difference =
+        static_cast<int>(decoded[i]) - static_cast<int>(texels[i]);
+    REQUIRE(difference * difference <= 4);
+  }
+}
+
+TEST_CASE("Compressed textures lay out every mip level back to back",
+          "[texture_compression]") {
+  const std::vector<u8> texels(13 * 5 * 4, 200);
+  const auto compressed =
+      SUT::compress(texels, {13, 5}, ImageFormat::BC7_SRGB, 32);
+
+  // 13x5, 6x2, 3x1 and 1x1 take 8, 2, 1 and 1 blocks
+  REQUIRE(compressed.level_offsets ==
+          std::vector<u64>{0, 8 * 16, 10 * 16, 11 * 16});
+  REQUIRE(compressed.data.size() == 12 * 16);
+}
+
+TEST_CASE("RGBA8 chains keep the base level texels as they are",
+          "[texture_compression]") {
+  std::vector<u8> texels(4 * 2 * 4);
+  for (usize i = 0; i < texels.size(); ++i) {
+    texels[i] = static_cast<u8>(i);
+  }
+  const auto chain = SUT::compress(texels, {4, 2}, ImageFormat::UNORM_RGBA8,
+                                   SUT::full_level_count({4, 2}));
+
+  // 4x2, 2x1 and 1x1 take 32, 8 and 4 bytes
+  REQUIRE(chain.level_offsets == std::vector<u64>{0, 32, 40});
+  REQUIRE(chain.data.size() == 44);
+  REQUIRE(std::equal(texels.begin(), texels.end(), chain.data.span().begin()));
+}
@@ -0,0 +1,86 @@
+#include "Allocator.hpp"
+#include "Image.hpp"
+#include "ImageProperties.hpp"
+#include "JobSystem.hpp"
+#include "Texture.hpp"
+#include "TextureCompressor.hpp"
+#include "TextureStreamer.hpp"
+
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "common/device_mock.hpp"
+#include "common/instance_mock.hpp"
+#include "common/window_mock.hpp"
+
+using Core::Extent;
+using Core::u32;
+
+namespace {
+
+auto grey_chain(const Extent<u32> &extent) -> Core::CompressedTexture {
+  const std::vector<Core::u8> pixels(
+      static_cast<Core::usize>(extent.width) * extent.height * 4, 128);
+  return Core::TextureCompressor::compress(
+      pixels, extent, Core::ImageFormat::UNORM_RGBA8,
+      Core::TextureCompressor::full_level_count(extent));
+}
+
+auto stream_grey(Core::TextureStreamer &streamer, const Extent<u32> &extent)
+    -> Core::Ref<Core::Texture> {
+  return streamer.stream(
+      Core::TextureProperties{
+          .format = Core::ImageFormat::UNORM_RGBA8,
+          .path = "grey.png",
+          .usage = Core::ImageUsage::Sampled | Core::ImageUsage::TransferDst |
+                   Core::ImageUsage::TransferSrc,
+          .layout = Core::ImageLayout::ShaderReadOnlyOptimal,
+      },
+      [extent]() -> std::optional<Core::CompressedTexture> {
+        return grey_chain(extent);
+      });
+}
+
+auto resident_width(const Core::Texture &texture) -> u32 {
+  return texture.get_image().get_extent().width;
+}
+
+} // namespace
+
+TEST_CASE("A small screen extent stops streaming at a coarser level",
+          "[texture_streamer]") {
+  MockInstance instance{};
+  MockWindow window{instance};
+  MockDevice device{instance, window};
+  Core::Allocator::construct(device, instance);
+  Core::JobSystem::initialise();
+
+  auto streamer = Core::TextureStreamer::construct(device);
+  const Extent<u32> extent{1024, 1024};
+  const auto hinted = stream_grey(*streamer, extent);
+  const auto unhinted = stream_grey(*streamer, extent);
+  REQUIRE(resident_width(*hinted) == 1);
+
+  // Decodes finish on the main thread, with the base levels resident
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::seconds{10};
+  while ((resident_width(*hinted) == 1 || resident_width(*unhinted) == 1) &&
+         std::chrono::steady_clock::now() < deadline) {
+    Core::JobSystem::run_main_thread_jobs();
+    std::this_thread::yield();
+  }
+  using Core::Config::texture_streaming_base_extent;
+  REQUIRE(resident_width(*hinted) == texture_streaming_base_extent);
+
+  // One level per texture and frame, so a frame per level is enough
+  const auto level_count = Core::TextureCompressor::full_level_count(extent);
+  for (u32 frame = 0; frame < 2 * level_count; ++frame) {
+    streamer->hint_screen_extent(*hinted, {128, 128});
+    streamer->update();
+  }
+
+  REQUIRE(resident_width(*hinted) == 128);
+  REQUIRE(resident_width(*unhinted) == extent.width);
+}